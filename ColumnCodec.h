@@ -0,0 +1,129 @@
+//
+// ColumnCodec: on-disk format of the per-tick columnar export (see TickExport.h)
+// and the encoding helpers shared by the writer and the tickdump reader.
+//
+// File:   "SIMCOL01" followed by frames.
+// Frame:  u8 type, u32 little-endian payload length, payload.
+//   'D' dictionary: varint n, then n x { varint nameId, u8 ObjectKind, varint len, name bytes }
+//       Emitted before the first tick that mentions a new object.
+//   'T' tick: varint time, varint shipCount, varint portCount, then the columns
+//       ships: name, x, y, fuel, state, containers, attackStat
+//       ports: name, x, y, fuel
+//       Each column is varint byteLength + bytes; byteLength 0 means every
+//       value equals the one at the same index in the previous tick.
+// Values are integers (coordinates and fuel in 1/1000 nm and kl, below the
+// precision status prints), stored as zigzag varint deltas against the value
+// at the same row index of the previous tick, or against 0 for new rows.
+//
+
+#ifndef INC_74_EX3_COLUMNCODEC_H
+#define INC_74_EX3_COLUMNCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+static const char   COLUMN_FILE_MAGIC[] = "SIMCOL01"; // 8 bytes on disk, no terminator
+static const size_t COLUMN_MAGIC_SIZE   = 8;
+static const double COLUMN_SCALE        = 1000.0;     // fixed-point units per nm / kl
+
+static const uint8_t FRAME_DICTIONARY = 'D';
+static const uint8_t FRAME_TICK       = 'T';
+
+// Object kind as recorded in dictionary frames
+enum ObjectKind : uint8_t { PortObject, FreighterObject, PatrolObject, CruiserObject };
+
+// Column order inside a tick frame
+enum ShipColumn : uint8_t { ShipName, ShipX, ShipY, ShipFuel, ShipState, ShipContainers, ShipAttack,
+                            SHIP_COLUMNS };
+enum PortColumn : uint8_t { PortName, PortX, PortY, PortFuel, PORT_COLUMNS };
+
+// Round half away from zero, like llround() but inlined (called per value per tick)
+inline int64_t toFixed(double v) {
+    double scaled = v * COLUMN_SCALE;
+    return static_cast<int64_t>(scaled >= 0 ? scaled + 0.5 : scaled - 0.5);
+}
+inline double  fromFixed(int64_t v) { return static_cast<double>(v) / COLUMN_SCALE; }
+
+// Write v at p (at most MAX_VARINT bytes); returns the end
+static const size_t MAX_VARINT = 10;
+inline char* putVarint(char* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = static_cast<char>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<char>(v);
+    return p;
+}
+
+inline void putVarint(string& out, uint64_t v) {
+    char buf[MAX_VARINT];
+    out.append(buf, putVarint(buf, v) - buf);
+}
+
+// Returns false on truncated input
+inline bool getVarint(const string& in, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) return false;
+        uint8_t b = static_cast<uint8_t>(in[pos++]);
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t zigzag(int64_t v)    { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t  unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+inline void putU32(string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+inline uint32_t getU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+/**
+ * Append one column: `cur` delta-encoded against `prev` (missing rows count as 0).
+ * An all-unchanged column is written as length 0 with no body.
+ */
+inline void putColumn(string& out, const vector<int64_t>& cur, const vector<int64_t>& prev, string& scratch) {
+    if (cur == prev) {
+        putVarint(out, 0);
+        return;
+    }
+    scratch.resize(cur.size() * MAX_VARINT);
+    char* p = &scratch[0];
+    size_t common = cur.size() < prev.size() ? cur.size() : prev.size();
+    for (size_t i = 0; i < common; ++i)     p = putVarint(p, zigzag(cur[i] - prev[i]));
+    for (size_t i = common; i < cur.size(); ++i) p = putVarint(p, zigzag(cur[i]));
+    size_t len = p - scratch.data();
+    putVarint(out, len);
+    out.append(scratch.data(), len);
+}
+
+// Decode a column of n rows written by putColumn; false on malformed input
+inline bool getColumn(const string& in, size_t& pos, size_t n, const vector<int64_t>& prev, vector<int64_t>& cur) {
+    uint64_t len;
+    if (!getVarint(in, pos, len) || len > in.size() - pos) return false;
+    cur.resize(n);
+    if (len == 0) {
+        if (n > 0 && prev.size() != n) return false;
+        cur = prev;
+        return true;
+    }
+    size_t end = pos + len;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t z;
+        if (!getVarint(in, pos, z) || pos > end) return false;
+        cur[i] = (i < prev.size() ? prev[i] : 0) + unzigzag(z);
+    }
+    return pos == end;
+}
+
+#endif //INC_74_EX3_COLUMNCODEC_H
@@ -0,0 +1,33 @@
+//
+// Combat implementation
+//
+#include "Combat.h"
+#include <cmath>
+#include <stdexcept>
+
+CombatMode parseCombatMode(const string& name) {
+    if (name == "deterministic") return DeterministicCombat;
+    if (name == "stochastic")    return StochasticCombat;
+    throw runtime_error("unknown combat mode: " + name);
+}
+
+double winProbability(int force, int resistance) {
+    return 1.0 / (1.0 + exp(-(force - resistance) / COMBAT_SPREAD));
+}
+
+// splitmix64 step; the top 53 bits make the double
+double CombatRng::uniform() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Run (seed, branch) through one splitmix64 round so neighbouring branches get unrelated streams
+uint64_t branchSeed(uint64_t seed, uint64_t branch) {
+    uint64_t z = seed + (branch + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
@@ -0,0 +1,57 @@
+//
+// Combat: how a cruiser's attack on a freighter or patrol boat turns out.
+//
+// Deterministic combat is the original rule: the cruiser wins if its force
+// exceeds the target's resistance. Stochastic combat makes that a draw: the
+// cruiser wins with a probability that rises smoothly with force - resistance
+// (a logistic curve, even odds when they are equal), so a stronger side is
+// favoured but not certain. Draws come from the world's own random stream
+// (Model::seed): a world replays the same way from the same seed, and worlds
+// branched from one state with different seeds sample different futures (see
+// Ensemble.h).
+//
+
+#ifndef INC_74_EX3_COMBAT_H
+#define INC_74_EX3_COMBAT_H
+
+#include <cstdint>
+#include <string>
+using namespace std;
+
+static const double COMBAT_SPREAD = 2.0; // force - resistance that gives the cruiser about 73% odds
+
+enum CombatMode : uint8_t { DeterministicCombat, StochasticCombat };
+
+// "deterministic" or "stochastic" (throws runtime_error for anything else)
+CombatMode parseCombatMode(const string& name);
+
+// Chance that a cruiser of force beats a target of resistance under stochastic combat
+double winProbability(int force, int resistance);
+
+// Outcomes of a world's attacks so far
+struct CombatTally {
+    uint64_t attacks        = 0;
+    uint64_t victories      = 0; // won by the cruiser
+    uint64_t containersLost = 0; // cargo freighters lost to victorious cruisers
+};
+
+/**
+ * Random stream of one world: splitmix64, whose whole state is one integer, so
+ * copying a world copies its stream exactly. Streams seeded with different
+ * values (see branchSeed) are independent for simulation purposes.
+ */
+class CombatRng {
+public:
+    explicit CombatRng(uint64_t seed = 0) : state(seed) {}
+
+    // Uniform in [0, 1)
+    double uniform();
+
+private:
+    uint64_t state;
+};
+
+// Seed of branch number `branch` of an ensemble seeded with seed
+uint64_t branchSeed(uint64_t seed, uint64_t branch);
+
+#endif //INC_74_EX3_COMBAT_H
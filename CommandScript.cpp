@@ -0,0 +1,127 @@
+//
+// CommandScript implementation
+//
+#include "CommandScript.h"
+#include <sstream>
+using namespace std;
+
+CommandScript CommandScript::compile(const vector<string>& lines) {
+    CommandScript script;
+    script.ops.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        Controller::ParsedCommand pc = Controller::tokenize(lines[i]);
+        if (pc.first.empty()) continue; // blank lines do nothing
+        ScriptOp op;
+        string reason;
+        if (!script.lower(pc, op, reason)) {
+            op = ScriptOp();
+            op.text = script.addString(lines[i]);
+            script.diagnostics.push_back("line " + to_string(i + 1) + ": " + reason);
+        }
+        script.ops.push_back(op);
+    }
+    return script;
+}
+
+uint32_t CommandScript::addString(const string& s) {
+    strings.push_back(s);
+    return static_cast<uint32_t>(strings.size() - 1);
+}
+
+/**
+ * Reads the arguments with the Controller's own parsers, so a line lowers only
+ * if its typed form would get past parsing. The checks that need the world are
+ * left to the executor.
+ */
+bool CommandScript::lower(const Controller::ParsedCommand& pc, ScriptOp& op, string& reason) {
+    using C = Controller;
+    istringstream args(pc.line.substr(pc.argsPos));
+    op.cmd = pc.cmd;
+    switch (pc.cmd) {
+    case C::CmdExit:
+    case C::CmdDefault:
+    case C::CmdShow:
+    case C::CmdGo:
+        return true;
+    case C::CmdStatus: {
+        args >> ws;
+        if (args.eof()) return true; // every object
+        StatusQuery query;
+        if (!C::parseStatusQuery(args, query, reason)) { reason = "Error: " + reason; return false; }
+        op.flag = 1;
+        op.text = static_cast<uint32_t>(queries.size());
+        queries.push_back(query);
+        return true;
+    }
+    case C::CmdSize:
+        return C::parseSize(args, op.n, reason);
+    case C::CmdZoom:
+        return C::parseZoom(args, op.z, reason);
+    case C::CmdPan:
+        return C::parsePan(args, op.x, op.y, reason);
+    case C::CmdCreate: {
+        C::CreateArgs create;
+        if (!C::parseCreate(args, create, reason)) return false;
+        op.flag  = static_cast<uint8_t>(create.type);
+        op.x     = create.x;
+        op.y     = create.y;
+        op.n     = create.stat;
+        op.extra = create.extra;
+        op.text  = addString(create.name);
+        return true;
+    }
+    case C::CmdTrack: {
+        C::TrackArgs track;
+        if (!C::parseTrack(args, track, reason)) return false;
+        op.ship = NameTable::get().intern(track.name);
+        op.z    = static_cast<double>(track.count);
+        op.text = addString(track.file);
+        return true;
+    }
+    case C::CmdEncounters: {
+        bool given;
+        if (!C::parseEncounters(args, given, op.z, reason)) return false;
+        op.flag = given;
+        return true;
+    }
+    case C::CmdPorts: {
+        size_t limit;
+        if (!C::parsePorts(args, limit, reason)) return false;
+        op.z = static_cast<double>(limit);
+        return true;
+    }
+    case C::CmdProfile: {
+        C::ProfileAction action;
+        if (!C::parseProfile(args, action, reason)) return false;
+        op.flag = action;
+        return true;
+    }
+    case C::CmdRemove: {
+        string name;
+        if (!C::parseRemove(args, name, reason)) return false;
+        op.text = addString(name);
+        return true;
+    }
+    default:
+        break; // a ship name (a ship sub-command is not a command on its own)
+    }
+
+    string subcmd;
+    if (!(args >> subcmd)) { reason = "Error: missing command for ship '" + pc.first + "'"; return false; }
+    op.cmd = C::lookupCommand(subcmd);
+    if (op.cmd < C::CmdCourse || op.cmd > C::CmdStop) {
+        reason = "Error: illegal command '" + subcmd + "' for ship '" + pc.first + "'";
+        return false;
+    }
+    C::ShipArgs ship;
+    if (!C::parseShipArgs(op.cmd, args, ship, reason)) return false;
+    op.ship = NameTable::get().intern(pc.first);
+    switch (op.cmd) {
+    case C::CmdCourse:   op.x = ship.heading; op.z = ship.speed; break;
+    case C::CmdPosition: op.x = ship.x; op.y = ship.y; op.z = ship.speed; break;
+    case C::CmdVoyage:   op.z = ship.hours; break;
+    default:             op.n = ship.count; op.z = ship.speed; break;
+    }
+    if (!ship.other.empty()) op.other = NameTable::get().intern(ship.other);
+    return true;
+}
@@ -0,0 +1,69 @@
+//
+// CommandScript: a command file compiled once into an op list, for replaying
+// the same scenario many times (see ScenarioRunner.h, Ensemble.h).
+//
+// Compiling does all of a line's text work up front: tokenizing, keyword
+// lookup, coordinate surgery and number parsing, and names resolved to
+// interned NameIds. What is left for each run is what depends on the world:
+// does the ship exist, is the port known, is the speed within the ship's
+// limits. Controller::execute(const CommandScript&) runs the ops through the
+// same code as typed commands, so a compiled script prints exactly what the
+// text script would, errors included.
+//
+// A line that does not compile cleanly (a syntax error, an unknown ship type)
+// stays in the list as text and is parsed by the Controller when it is
+// reached: its error message may depend on the world at that moment (an
+// unknown ship name wins over a bad argument). getDiagnostics() says which
+// lines those are and why.
+//
+
+#ifndef INC_74_EX3_COMMANDSCRIPT_H
+#define INC_74_EX3_COMMANDSCRIPT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Controller.h"
+#include "NameTable.h"
+#include "StatusIndex.h"
+using namespace std;
+
+/**
+ * One compiled command (48 bytes). cmd selects the meaning of the operands;
+ * CmdNone is a line kept as text (strings[text]). Blank lines are dropped.
+ */
+struct ScriptOp {
+    Controller::Command cmd   = Controller::CmdNone;
+    uint8_t             flag  = 0;       // create: ShipType; encounters: 1 if a threshold is given; status: 1 if a query; profile: action
+    NameId              ship  = NO_NAME; // ship commands and track: the ship
+    NameId              other = NO_NAME; // port, or attack target
+    int32_t             n     = 0;       // size, stat, unload count
+    int32_t             extra = 0;       // create: maxContainers / attackRange
+    uint32_t            text  = 0;       // index into strings: name, track file, or the line itself; status: into queries
+    double              x = 0, y = 0, z = 0; // coordinates, heading, speed, zoom, hours, threshold, track / ports count
+};
+
+class CommandScript {
+public:
+    // Compile script lines (never fails: what does not compile is kept as text)
+    static CommandScript compile(const vector<string>& lines);
+
+    const vector<ScriptOp>& getOps()     const { return ops; }
+    const string& str(uint32_t index)    const { return strings[index]; }
+    const StatusQuery& query(uint32_t index) const { return queries[index]; }
+
+    // "line N: " and the parse error, for every line kept as text
+    const vector<string>& getDiagnostics() const { return diagnostics; }
+
+private:
+    vector<ScriptOp> ops;
+    vector<string>   strings;
+    vector<StatusQuery> queries;
+    vector<string>   diagnostics;
+
+    // Lower one line into op; false (with the parse error) if it has to stay text
+    bool lower(const Controller::ParsedCommand& pc, ScriptOp& op, string& reason);
+    uint32_t addString(const string& s);
+};
+
+#endif //INC_74_EX3_COMMANDSCRIPT_H
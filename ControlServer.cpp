@@ -0,0 +1,481 @@
+/*
+ * ControlServer.cpp
+ *
+ * epoll-based control server; see ControlServer.h for the protocol.
+ */
+
+#include "ControlServer.h"
+#include "Model.h"
+#include "View.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+static const size_t QUEUE_CAPACITY = 4096;
+static const size_t SIM_BATCH_SIZE = 256;
+static const int    MAX_EVENTS     = 64;
+static const char*  END_OF_RESPONSE = ".\n";
+static const auto   IDLE_NAP       = chrono::microseconds(200);
+
+// Degraded real-time mode: publishes put off in a row before one goes out anyway
+static const int MAX_SKIPPED_PUBLISHES = 10;
+// Bytes reserved past a snapshot status line that outgrew its buffer
+static const size_t LINE_SLACK = 16;
+
+// Tag for the listen socket and the wake-up eventfd in epoll_event.data.u64
+// (client ids start at 1, so these never collide)
+static const uint64_t LISTEN_TAG = 0;
+static const uint64_t WAKE_TAG   = UINT64_MAX;
+
+static runtime_error sysError(const string& what) {
+    return runtime_error(what + ": " + strerror(errno));
+}
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// "status" alone or "status <name>": answered from the snapshot. Filters,
+// rankings and pages need the Model's indexes, so those go to the simulation thread.
+static bool snapshotStatus(const string& line, size_t argsPos) {
+    istringstream args(line.substr(argsPos));
+    string name, more;
+    if (!(args >> name)) return true;
+    if (args >> more || name.find_first_of("=<>") != string::npos) return false;
+    istringstream single(name);
+    StatusQuery query;
+    string reason;
+    return !Controller::parseStatusQuery(single, query, reason);
+}
+
+// Construction / teardown
+
+ControlServer::ControlServer(Controller& controller, const string& endpoint, int tickMs, const RealTimeOptions& realTime)
+    : controller(controller), tickMs(tickMs), realTime(realTime), pacer(chrono::milliseconds(tickMs)),
+      inbound(QUEUE_CAPACITY), outbound(QUEUE_CAPACITY), stopping(false) {
+    if (endpoint.compare(0, 5, "unix:") == 0) {
+        unixPath = endpoint.substr(5);
+        sockaddr_un addr{};
+        if (unixPath.empty() || unixPath.size() >= sizeof(addr.sun_path))
+            throw runtime_error("invalid unix socket path '" + unixPath + "'");
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, unixPath.c_str(), sizeof(addr.sun_path) - 1);
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0) throw sysError("socket");
+        unlink(unixPath.c_str()); // stale socket from an earlier run
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            throw sysError("bind " + unixPath);
+    } else if (endpoint.compare(0, 4, "tcp:") == 0) {
+        int port = stoi(endpoint.substr(4));
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd < 0) throw sysError("socket");
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            throw sysError("bind 127.0.0.1:" + to_string(port));
+    } else {
+        throw runtime_error("endpoint must be unix:<path> or tcp:<port>");
+    }
+    if (listen(listenFd, SOMAXCONN) < 0) throw sysError("listen");
+    setNonBlocking(listenFd);
+
+    epollFd = epoll_create1(0);
+    wakeFd  = eventfd(0, EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0) throw sysError("epoll/eventfd");
+    epoll_event ev{};
+    ev.events   = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.u64 = WAKE_TAG;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+ControlServer::~ControlServer() {
+    stopping = true;
+    if (ioThread.joinable()) ioThread.join();
+    for (auto& kv : clients) close(kv.second.fd);
+    if (listenFd >= 0) close(listenFd);
+    if (epollFd >= 0)  close(epollFd);
+    if (wakeFd >= 0)   close(wakeFd);
+    if (!unixPath.empty()) unlink(unixPath.c_str());
+}
+
+// Simulation thread
+
+/**
+ * Owns the Model: applies queued commands in arrival order and ticks every
+ * tickMs. Publishes a snapshot after each batch, before the batch's responses
+ * are released, so a client's follow-up queries always see its own commands.
+ * In degraded real-time mode a publish that would overrun the next deadline
+ * is put off (at most MAX_SKIPPED_PUBLISHES times in a row), and the
+ * responses with it.
+ */
+void ControlServer::run() {
+    if (realTime.enabled) prepareRealTime(realTime.cpu);
+    publishSnapshot();
+    ioThread = thread(&ControlServer::ioLoop, this);
+
+    // Sized up front so that steady-state ticks do not allocate here
+    vector<Request> batch;
+    vector<Response> responses; // waiting for the next publish
+    batch.reserve(SIM_BATCH_SIZE);
+    responses.reserve(SIM_BATCH_SIZE * (MAX_SKIPPED_PUBLISHES + 1));
+    bool shutdownRequested = false;
+    bool unpublished = false; // commands or ticks since the last publish
+    int  skipped = 0;         // publishes put off in a row
+    pacer.start();
+
+    while (!shutdownRequested) {
+        batch.clear();
+        inbound.tryPopBatch(batch, SIM_BATCH_SIZE);
+        for (auto& req : batch) {
+            Response resp;
+            resp.client = req.client;
+            resp.seq    = req.seq;
+            if (req.shutdown) shutdownRequested = true;
+            else if (req.query) resp.text = answerLive(req.command);
+            else              resp.text = executeCaptured(req.command);
+            responses.push_back(move(resp));
+        }
+
+        bool ticked = false;
+        if (tickMs > 0 && pacer.due()) {
+            streambuf* realOut = cout.rdbuf(nullptr); // per-tick chatter has no client to go to
+            pacer.beginTick();
+            controller.getModel().go();
+            pacer.endTick();
+            cout.rdbuf(realOut);
+            ticked = true;
+        }
+
+        unpublished = unpublished || !batch.empty() || ticked;
+        bool late = realTime.degrade && tickMs > 0 && !shutdownRequested && skipped < MAX_SKIPPED_PUBLISHES
+                    && Clock::now() + lastPublish > pacer.nextDeadline();
+        if (unpublished && late) {
+            pacer.skippedRender();
+            ++skipped;
+        } else if (unpublished) {
+            publishSnapshot();
+            unpublished = false;
+            skipped = 0;
+            for (auto& r : responses) outbound.push(move(r));
+            responses.clear();
+            uint64_t one = 1;
+            ssize_t ignored = write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+        if (batch.empty() && !ticked) {
+            // idle: nap briefly, but never past the next tick
+            auto wake = Clock::now() + IDLE_NAP;
+            if (tickMs > 0) pacer.sleepUntilDue(wake);
+            else            TickPacer::sleepUntil(wake);
+        }
+    }
+
+    stopping = true;
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+    ioThread.join();
+    if (realTime.enabled) pacer.report(cout);
+}
+
+// Run one command with stdout/stderr captured into its response
+string ControlServer::executeCaptured(const Controller::ParsedCommand& pc) {
+    ostringstream out;
+    streambuf* realOut = cout.rdbuf(out.rdbuf());
+    streambuf* realErr = cerr.rdbuf(out.rdbuf());
+    controller.execute(pc);
+    cout.rdbuf(realOut);
+    cerr.rdbuf(realErr);
+    return out.str();
+}
+
+// A snapshot query answered from the Model itself, in order with the client's commands
+string ControlServer::answerLive(const Controller::ParsedCommand& pc) {
+    istringstream args(pc.line.substr(pc.argsPos));
+    string name;
+    if (pc.cmd != Controller::CmdStatus || !(args >> name)) return executeCaptured(pc);
+    const Model& model = controller.getModel();
+    NameId id = NameTable::get().find(name);
+    ostringstream out;
+    if (model.shipExists(id))      model.getShip(id)->printStatus(out);
+    else if (model.portExists(id)) model.getPort(id)->printStatus(out);
+    else                           out << "Error: no object named '" << name << "'\n";
+    return out.str();
+}
+
+// Home slot of a name in Snapshot::byName
+static size_t nameSlot(NameId id, size_t mask) { return (id * 0x9E3779B9u) & mask; }
+
+size_t ControlServer::Snapshot::find(NameId id) const {
+    if (byName.empty()) return lineCount;
+    size_t mask = byName.size() - 1;
+    for (size_t i = nameSlot(id, mask); byName[i] != 0; i = (i + 1) & mask)
+        if (lines[byName[i] - 1].name == id) return byName[i] - 1;
+    return lineCount;
+}
+
+/**
+ * Refill a snapshot no reader holds any more. Its lines are the ones of the
+ * publish it last held, in status order: only a line whose object or version
+ * differs is copied again (the objects touched since, and every port), and the
+ * name table is rebuilt only if the objects changed. Once the pool and its
+ * buffers have grown, publishing allocates nothing.
+ */
+void ControlServer::publishSnapshot() {
+    auto start = Clock::now();
+    Model& model = controller.getModel();
+    // Free snapshots let go of their Model epochs, so the Model can recycle those too
+    snapshots.forEachFree([](Snapshot& old) { old.model.reset(); });
+    shared_ptr<Snapshot> snap = snapshots.take();
+    snap->time = model.getTime();
+
+    size_t n = 0;
+    bool reordered = false;
+    snap->textSize = 0;
+    model.forEachStatusLine([&snap, &n, &reordered](NameId name, const string& text, uint64_t version) {
+        if (n == snap->lines.size()) snap->lines.push_back(Snapshot::Line{ NO_NAME, 0, string() });
+        Snapshot::Line& line = snap->lines[n++];
+        if (line.name != name || line.version != version || version == 0) {
+            if (line.name != name) reordered = true;
+            line.name    = name;
+            line.version = version;
+            // room for the line to grow by a few digits without reallocating
+            if (line.text.capacity() < text.size()) line.text.reserve(text.size() + LINE_SLACK);
+            line.text.assign(text);
+        }
+        snap->textSize += text.size();
+    });
+    if (reordered || n != snap->lineCount) {
+        snap->lineCount = n;
+        size_t slots = 16;
+        while (slots < 2 * n) slots *= 2;
+        snap->byName.assign(slots, 0);
+        for (size_t k = 0; k < n; ++k) {
+            size_t i = nameSlot(snap->lines[k].name, slots - 1);
+            while (snap->byName[i] != 0) i = (i + 1) & (slots - 1);
+            snap->byName[i] = static_cast<uint32_t>(k + 1);
+        }
+    }
+
+    snap->model  = model.publishSnapshot();
+    snap->view   = controller.getView();
+    snap->pacing = pacer;
+    atomic_store(&snapshot, shared_ptr<const Snapshot>(snap));
+    lastPublish = Clock::now() - start;
+}
+
+// I/O thread
+
+void ControlServer::ioLoop() {
+    epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, 100);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                acceptClients();
+            } else if (tag == WAKE_TAG) {
+                uint64_t count;
+                ssize_t ignored = read(wakeFd, &count, sizeof(count));
+                (void)ignored;
+                drainResponses();
+            } else if (clients.count(tag)) {
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) { closeClient(tag); continue; }
+                if (events[i].events & EPOLLIN)  readClient(tag);
+                if (clients.count(tag) && (events[i].events & EPOLLOUT)) flushClient(tag);
+            }
+        }
+    }
+    drainResponses(); // deliver the shutdown acknowledgement if possible
+}
+
+void ControlServer::acceptClients() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return; // EAGAIN: no more pending connections
+        setNonBlocking(fd);
+        uint64_t id = nextClientId++;
+        clients[id].fd = fd;
+        epoll_event ev{};
+        ev.events   = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = id;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void ControlServer::readClient(uint64_t id) {
+    char buf[4096];
+    while (true) {
+        ssize_t n = read(clients[id].fd, buf, sizeof(buf));
+        if (n > 0) {
+            clients[id].inbuf.append(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            // peer closed: still answer what it already sent
+            clients[id].pending.push_back(Pending{Pending::Close});
+        }
+        break;
+    }
+    size_t nl;
+    while (clients.count(id) && (nl = clients[id].inbuf.find('\n')) != string::npos) {
+        string line = clients[id].inbuf.substr(0, nl);
+        clients[id].inbuf.erase(0, nl + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        handleLine(id, line);
+    }
+    if (clients.count(id)) pump(id);
+}
+
+// Classify one line: connection control, snapshot query, or a command for the Model
+void ControlServer::handleLine(uint64_t id, const string& line) {
+    Client& c = clients[id];
+    if (c.closing || (!c.pending.empty() && c.pending.back().kind == Pending::Close)) return;
+
+    Controller::ParsedCommand pc = Controller::tokenize(line);
+    if (pc.cmd == Controller::CmdExit) {
+        c.pending.push_back(Pending{Pending::Close});
+        return;
+    }
+    bool query = (pc.cmd == Controller::CmdStatus && snapshotStatus(line, pc.argsPos))
+                 || pc.cmd == Controller::CmdShow || pc.first == "pacing";
+    bool inFlight = any_of(c.pending.begin(), c.pending.end(),
+                           [](const Pending& p) { return p.kind == Pending::Mutation; });
+    if (query && (!inFlight || pc.first == "pacing")) {
+        Pending q{Pending::Query};
+        q.text = line;
+        q.snap = atomic_load(&snapshot);
+        c.pending.push_back(move(q));
+        return;
+    }
+
+    Request req;
+    req.client   = id;
+    req.seq      = nextSeq++;
+    req.query    = query;
+    req.shutdown = (pc.first == "shutdown");
+    req.command  = move(pc);
+    Pending m{Pending::Mutation};
+    m.seq = req.seq;
+    c.pending.push_back(move(m));
+    inbound.push(move(req));
+}
+
+// Emit every leading pending entry that can be answered now
+void ControlServer::pump(uint64_t id) {
+    Client& c = clients[id];
+    while (!c.pending.empty()) {
+        Pending& p = c.pending.front();
+        if (p.kind == Pending::Mutation) {
+            if (!p.done) break; // later entries wait for it
+            c.outbuf += p.text;
+        } else if (p.kind == Pending::Query) {
+            c.outbuf += answerQuery(p);
+        } else {
+            c.closing = true;
+            c.pending.clear();
+            break;
+        }
+        c.outbuf += END_OF_RESPONSE;
+        c.pending.pop_front();
+    }
+    flushClient(id);
+}
+
+// Answer status / status <name> / show / pacing from the snapshot taken when it arrived
+string ControlServer::answerQuery(const Pending& query) const {
+    const string& line = query.text;
+    const Snapshot* snap = query.snap.get();
+    Controller::ParsedCommand pc = Controller::tokenize(line);
+    if (pc.first == "pacing") {
+        if (tickMs == 0) return "Error: the server only ticks on \"go\" (no --tick-ms)\n";
+        ostringstream report;
+        snap->pacing.report(report);
+        return report.str();
+    }
+    if (pc.cmd == Controller::CmdShow) {
+        ostringstream map;
+        snap->view.draw(*snap->model, map);
+        return map.str();
+    }
+
+    istringstream args(line.substr(pc.argsPos));
+    string name;
+    if (!(args >> name)) {
+        string text;
+        text.reserve(snap->textSize);
+        for (size_t k = 0; k < snap->lineCount; ++k) text += snap->lines[k].text;
+        return text;
+    }
+    size_t k = snap->find(NameTable::get().find(name));
+    if (k == snap->lineCount) return "Error: no object named '" + name + "'\n";
+    return snap->lines[k].text;
+}
+
+void ControlServer::flushClient(uint64_t id) {
+    Client& c = clients[id];
+    while (!c.outbuf.empty()) {
+        ssize_t n = send(c.fd, c.outbuf.data(), c.outbuf.size(), MSG_NOSIGNAL);
+        if (n > 0) { c.outbuf.erase(0, static_cast<size_t>(n)); continue; }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closeClient(id);
+        return;
+    }
+    // wait for EPOLLOUT only while output is backed up
+    epoll_event ev{};
+    ev.events   = EPOLLIN | EPOLLRDHUP | (c.outbuf.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+    ev.data.u64 = id;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+    if (c.outbuf.empty() && c.closing) closeClient(id);
+}
+
+void ControlServer::closeClient(uint64_t id) {
+    auto it = clients.find(id);
+    if (it == clients.end()) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    clients.erase(it);
+}
+
+// Attach finished command output to its client's pending entry
+void ControlServer::drainResponses() {
+    vector<Response> done;
+    while (outbound.tryPopBatch(done, QUEUE_CAPACITY) > 0) {}
+    for (auto& r : done) {
+        auto it = clients.find(r.client);
+        if (it == clients.end()) continue; // client already gone
+        for (auto& p : it->second.pending) {
+            if (p.kind == Pending::Mutation && p.seq == r.seq) {
+                p.done = true;
+                p.text = move(r.text);
+                break;
+            }
+        }
+        pump(r.client);
+    }
+}
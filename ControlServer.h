@@ -0,0 +1,182 @@
+/*
+ * ControlServer.h
+ *
+ * Local control server: lets many clients drive one Model at the same time
+ * over a Unix domain socket or a localhost TCP port (Linux, epoll based).
+ *
+ * Protocol: one command per line, same grammar as Controller::parseCommand.
+ * Every command gets exactly one response: whatever the command printed
+ * (stdout and stderr), followed by a line containing a single ".".
+ *   status            – full status, served from a snapshot (see below)
+ *   status <name>     – status line of one port or ship, likewise
+ *   status <query>    – filtered / ranked / paged ships (see Controller::statusCommand),
+ *                       run on the simulation thread like any other command
+ *   show              – map, served from a snapshot
+ *   pacing            – how well ticks keep to --tick-ms (see TickPacer.h)
+ *   exit              – close this connection
+ *   shutdown          – stop the server
+ *   anything else     – queued to the simulation thread and applied in arrival order
+ *
+ * Threads: an I/O thread runs the epoll loop; the thread calling run() owns the
+ * Model and executes commands (and periodic ticks). After every batch it
+ * publishes an immutable snapshot (formatted status plus a Model epoch, see
+ * ModelSnapshot.h) that the I/O thread reads without touching the Model, so
+ * queries never stall ticks; maps are rendered on the I/O thread. A query
+ * is answered from the snapshot current when it arrives, which holds every
+ * command the client sent before it and none it sent after. A query that
+ * arrives while the client still has commands in flight has no such snapshot
+ * (the one after them may already hold its later commands too), so it is
+ * queued to the simulation thread and answered there, in order.
+ *
+ * Real-time mode keeps ticks on the wall clock for integrations that need a
+ * simulated hour every tickMs: the simulation thread is pinned to one CPU and
+ * sleeps to absolute deadlines, overruns are counted, and a pacing report is
+ * printed at shutdown. Degraded real-time mode also skips publishing (the
+ * status rendering, the costly part with many objects) when it would run
+ * into the next deadline; responses wait for the next publish, so clients
+ * still see their own writes.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Controller.h"
+#include "ModelSnapshot.h"
+#include "SpscQueue.h"
+#include "TickPacer.h"
+#include "View.h"
+
+// ControlServer real-time mode (needs tickMs > 0)
+struct RealTimeOptions {
+    bool enabled = false;
+    int  cpu     = -1;    // pin the simulation thread here; -1 = the CPU it starts on
+    bool degrade = false; // skip publishing rather than miss a deadline
+};
+
+class ControlServer {
+public:
+
+    /**
+     * @param controller  Executes commands (and owns the View used for "show").
+     * @param endpoint    "unix:<path>" or "tcp:<port>" (TCP binds 127.0.0.1 only).
+     * @param tickMs      Advance the Model every tickMs milliseconds; 0 = only on "go".
+     * @param realTime    Real-time mode options; off by default.
+     * Throws std::runtime_error if the endpoint cannot be opened.
+     */
+    ControlServer(Controller& controller, const std::string& endpoint, int tickMs,
+                  const RealTimeOptions& realTime = RealTimeOptions());
+    ~ControlServer();
+
+    ControlServer(const ControlServer&)            = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // Serve until a client sends "shutdown". Throws std::runtime_error if
+    // real-time mode cannot pin the simulation thread.
+    void run();
+
+private:
+    // Immutable view of the Model published by the simulation thread. Recycled
+    // (see RecyclePool) once no reader holds it, so its buffers keep their capacity.
+    struct Snapshot {
+        struct Line {
+            NameId      name;
+            uint64_t    version; // see Model::forEachStatusLine(); 0 = copied on every refill
+            std::string text;
+        };
+        int         time = 0;
+        std::vector<Line> lines;    // in "status" order; entries past lineCount keep their buffers
+        size_t      lineCount = 0;
+        size_t      textSize  = 0;  // of the lines together: the full "status" output
+        std::vector<uint32_t> byName; // open-addressed by NameId: 1 + index in lines; 0 = empty
+        std::shared_ptr<const ModelSnapshot> model; // positions for "show"
+        View        view;       // map parameters in effect at publish time
+        TickPacer   pacing{std::chrono::nanoseconds(0)}; // schedule measurements, rendered for "pacing"
+
+        // Index in lines of the object named id, or lineCount if it has none
+        size_t find(NameId id) const;
+    };
+
+    // I/O thread -> simulation thread
+    struct Request {
+        uint64_t client = 0;
+        uint64_t seq    = 0;
+        bool     shutdown = false;
+        bool     query    = false; // status / show behind the client's own commands
+        Controller::ParsedCommand command;
+    };
+
+    // Simulation thread -> I/O thread
+    struct Response {
+        uint64_t    client = 0;
+        uint64_t    seq    = 0;
+        std::string text;
+    };
+
+    // One queued line of a client, answered strictly in order
+    struct Pending {
+        enum Kind { Mutation, Query, Close };
+        explicit Pending(Kind kind) : kind(kind) {}
+
+        Kind        kind;
+        uint64_t    seq = 0;     // Mutation: request sequence number
+        bool        done = false;
+        std::string text;        // Mutation: response; Query: the query line
+        std::shared_ptr<const Snapshot> snap; // Query: the state it is answered from
+    };
+
+    struct Client {
+        int         fd = -1;
+        std::string inbuf;
+        std::string outbuf;
+        std::deque<Pending> pending;
+        bool        closing = false; // close once outbuf drains
+    };
+
+    Controller& controller;
+    int tickMs;
+    RealTimeOptions realTime;
+    TickPacer pacer; // tick schedule (simulation thread)
+    TickPacer::Clock::duration lastPublish{0}; // how long the last publishSnapshot() took
+
+    int listenFd = -1;
+    int epollFd  = -1;
+    int wakeFd   = -1; // eventfd: simulation thread -> I/O thread
+    std::string unixPath; // removed on shutdown
+
+    SpscQueue<Request>  inbound;
+    SpscQueue<Response> outbound;
+    std::shared_ptr<const Snapshot> snapshot; // accessed with atomic_load / atomic_store
+    RecyclePool<Snapshot> snapshots;          // simulation thread
+    std::atomic<bool> stopping;
+    std::thread ioThread;
+
+    // I/O thread state
+    std::unordered_map<uint64_t, Client> clients; // by client id
+    uint64_t nextClientId = 1;
+    uint64_t nextSeq      = 1;
+
+    // Simulation thread
+    void publishSnapshot();
+    std::string executeCaptured(const Controller::ParsedCommand& pc);
+    std::string answerLive(const Controller::ParsedCommand& pc);
+
+    // I/O thread
+    void ioLoop();
+    void acceptClients();
+    void readClient(uint64_t id);
+    void handleLine(uint64_t id, const std::string& line);
+    void pump(uint64_t id);
+    std::string answerQuery(const Pending& query) const;
+    void flushClient(uint64_t id);
+    void closeClient(uint64_t id);
+    void drainResponses();
+};
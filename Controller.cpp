@@ -8,9 +8,15 @@
  * Dispatch rules (first token):
  *   "exit"                                         → stop the loop
  *   "default"|"size"|"zoom"|"pan"|"show"           → handleViewCommand()
- *   "status"|"go"|"create"                         → handleModelCommand()
+ *   "status"|"go"|"create"|"track"|"encounters"|
+ *   "remove"|"ports"|"profile"                     → handleModelCommand()
  *   <known ship name>                              → handleShipCommand()
  *   anything else                                  → "Error: illegal command"
+ *
+ * Keywords are classified with a compile-time perfect hash (KEYWORDS below):
+ * one hash, one table probe and one string compare per token. Ship sub-commands
+ * then jump straight to their handler through SHIP_HANDLERS, and type-restricted
+ * commands are checked against the ship's type tag instead of RTTI.
  */
 
 #include "Controller.h"
@@ -19,57 +25,541 @@
 #include "Freighter.h"
 #include "Patrol.h"
 #include "Cruiser.h"
+#include "SpscQueue.h"
+#include "CommandScript.h"
+#include "Profiler.h"
+#include "Geodesy.h"
 
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <set>
+#include <cstring>
 #include <stdexcept>
 #include <cmath>
+#include <cctype>
+#include <thread>
+#include <vector>
 using namespace std;
 
-// Helper sets for quick keyword classification
-static const set<string> VIEW_COMMANDS  = { "default", "size", "zoom", "pan", "show" };
-static const set<string> MODEL_COMMANDS = { "status", "go", "create" };
-static const set<string> SHIP_COMMANDS  = {
-    "course", "position", "destination",
-    "load_at", "unload_at", "dock_at",
-    "attack", "refuel", "stop"
+// Keyword table
+
+namespace {
+
+// Bit per ShipType: which ship types accept a ship sub-command
+constexpr uint8_t typeBit(ShipType t) { return static_cast<uint8_t>(1u << t); }
+constexpr uint8_t ANY_SHIP = typeBit(FreighterType) | typeBit(PatrolType) | typeBit(CruiserType);
+
+enum CommandGroup : uint8_t { ExitGroup, ViewGroup, ModelGroup, ShipGroup };
+
+struct Keyword {
+    const char*         text;
+    Controller::Command cmd;
+    CommandGroup        group;
+    uint8_t             shipTypes; // ShipGroup only: allowed ShipType bits
+};
+
+constexpr Keyword KEYWORDS[] = {
+    { "exit",        Controller::CmdExit,        ExitGroup,  0 },
+    { "default",     Controller::CmdDefault,     ViewGroup,  0 },
+    { "size",        Controller::CmdSize,        ViewGroup,  0 },
+    { "zoom",        Controller::CmdZoom,        ViewGroup,  0 },
+    { "pan",         Controller::CmdPan,         ViewGroup,  0 },
+    { "show",        Controller::CmdShow,        ViewGroup,  0 },
+    { "status",      Controller::CmdStatus,      ModelGroup, 0 },
+    { "go",          Controller::CmdGo,          ModelGroup, 0 },
+    { "create",      Controller::CmdCreate,      ModelGroup, 0 },
+    { "track",       Controller::CmdTrack,       ModelGroup, 0 },
+    { "encounters",  Controller::CmdEncounters,  ModelGroup, 0 },
+    { "remove",      Controller::CmdRemove,      ModelGroup, 0 },
+    { "ports",       Controller::CmdPorts,       ModelGroup, 0 },
+    { "profile",     Controller::CmdProfile,     ModelGroup, 0 },
+    { "course",      Controller::CmdCourse,      ShipGroup,  ANY_SHIP },
+    { "position",    Controller::CmdPosition,    ShipGroup,  ANY_SHIP },
+    { "destination", Controller::CmdDestination, ShipGroup,  ANY_SHIP },
+    { "load_at",     Controller::CmdLoadAt,      ShipGroup,  typeBit(FreighterType) },
+    { "unload_at",   Controller::CmdUnloadAt,    ShipGroup,  typeBit(FreighterType) },
+    { "dock_at",     Controller::CmdDockAt,      ShipGroup,  typeBit(FreighterType) },
+    { "voyage",      Controller::CmdVoyage,      ShipGroup,  typeBit(FreighterType) },
+    { "attack",      Controller::CmdAttack,      ShipGroup,  typeBit(CruiserType) },
+    { "refuel",      Controller::CmdRefuel,      ShipGroup,  ANY_SHIP },
+    { "stop",        Controller::CmdStop,        ShipGroup,  ANY_SHIP },
+};
+constexpr int KEYWORD_COUNT = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+
+// Perfect hash over KEYWORDS: first two chars, last char and length (s[1] is '\0' for
+// 1-char tokens; len is never 0)
+constexpr int HASH_SLOTS = 64;
+constexpr unsigned keywordHash(const char* s, size_t len) {
+    return (static_cast<unsigned char>(s[0]) + 2u * static_cast<unsigned char>(s[1])
+            + static_cast<unsigned char>(s[len - 1]) + 12u * static_cast<unsigned>(len)) & (HASH_SLOTS - 1);
+}
+constexpr size_t constLength(const char* s) { return *s ? 1 + constLength(s + 1) : 0; }
+
+// Slot -> index into KEYWORDS, or -1 when no keyword hashes there
+struct SlotTable {
+    int8_t index[HASH_SLOTS];
+};
+constexpr SlotTable buildSlots() {
+    SlotTable t{};
+    for (int i = 0; i < HASH_SLOTS; ++i) t.index[i] = -1;
+    for (int k = 0; k < KEYWORD_COUNT; ++k)
+        t.index[keywordHash(KEYWORDS[k].text, constLength(KEYWORDS[k].text))] = static_cast<int8_t>(k);
+    return t;
+}
+constexpr SlotTable SLOTS = buildSlots();
+
+// Every keyword must own its slot; adding a keyword that collides fails the build
+constexpr bool hashIsPerfect() {
+    for (int k = 0; k < KEYWORD_COUNT; ++k)
+        if (SLOTS.index[keywordHash(KEYWORDS[k].text, constLength(KEYWORDS[k].text))] != k) return false;
+    return true;
+}
+static_assert(hashIsPerfect(), "keyword hash collision: adjust keywordHash()");
+
+// KEYWORDS is also indexed by Command, so entry k must describe Command k
+constexpr bool keywordsInCommandOrder() {
+    for (int k = 0; k < KEYWORD_COUNT; ++k)
+        if (KEYWORDS[k].cmd != k) return false;
+    return true;
+}
+static_assert(Controller::CmdNone == KEYWORD_COUNT && keywordsInCommandOrder(),
+              "KEYWORDS must list every Command in order");
+
+// Input pipeline sizing
+constexpr size_t INPUT_QUEUE_CAPACITY = 4096; // commands buffered ahead of the model thread
+constexpr size_t INPUT_BATCH_SIZE     = 256;  // commands executed per queue pop
+
+// Keyword entry for token, or nullptr
+const Keyword* findKeyword(const string& token) {
+    if (token.empty()) return nullptr;
+    int8_t k = SLOTS.index[keywordHash(token.c_str(), token.size())];
+    if (k < 0 || strcmp(KEYWORDS[k].text, token.c_str()) != 0) return nullptr;
+    return &KEYWORDS[k];
+}
+
+// Navigation state as shown in a trajectory listing
+const char* stateName(State s) {
+    switch (s) {
+        case Stopped: return "Stopped";
+        case Docked:  return "Docked";
+        case DITW:    return "Dead in the water";
+        case Moving:  return "Moving to destination";
+        case Course:  return "Moving on course";
+    }
+    return "";
+}
+
+// True if kw accepts this ship's type; otherwise reports which types it takes
+bool shipAccepts(const Keyword& kw, const Ship& ship, ostream& err);
+
+// "Freighters" / "Cruisers" for single-type restrictions in error messages
+const char* typePlural(uint8_t types) {
+    if (types == typeBit(FreighterType)) return "Freighters";
+    if (types == typeBit(PatrolType))    return "Patrol boats";
+    if (types == typeBit(CruiserType))   return "Cruisers";
+    return "some ship types";
+}
+
+bool shipAccepts(const Keyword& kw, const Ship& ship, ostream& err) {
+    if (kw.shipTypes & typeBit(ship.getType())) return true;
+    err << "Error: " << kw.text << " is only valid for " << typePlural(kw.shipTypes) << "\n";
+    return false;
+}
+
+// Commands that only read the Model (or set up the view) leave its latest snapshot current
+bool readsOnly(Controller::Command cmd) {
+    if (cmd == Controller::CmdNone) return false; // a ship command
+    return KEYWORDS[cmd].group == ExitGroup || KEYWORDS[cmd].group == ViewGroup
+        || cmd == Controller::CmdStatus || cmd == Controller::CmdTrack || cmd == Controller::CmdPorts;
+}
+
+// A whole token that is a positive integer
+bool readCount(const string& tok, size_t& n) {
+    size_t idx = 0;
+    long value = 0;
+    try { value = stol(tok, &idx); }
+    catch (...) { return false; }
+    if (idx != tok.size() || value <= 0) return false;
+    n = static_cast<size_t>(value);
+    return true;
+}
+
+// "on" / "off" / "reset"; false for anything else
+bool readProfileAction(const string& token, Controller::ProfileAction& action) {
+    if (token == "on")         action = Controller::ProfileOn;
+    else if (token == "off")   action = Controller::ProfileOff;
+    else if (token == "reset") action = Controller::ProfileReset;
+    else return false;
+    return true;
+}
+
+// "<v", "<=v", ">v", ">=v" or "=v" narrowing range; false if malformed
+bool readComparison(const string& text, ValueRange& range) {
+    size_t opLen = text.size() > 1 && text[1] == '=' && text[0] != '=' ? 2 : 1;
+    if (text.empty() || (text[0] != '<' && text[0] != '>' && text[0] != '=')) return false;
+    string number = text.substr(opLen);
+    size_t idx = 0;
+    double v;
+    try { v = stod(number, &idx); }
+    catch (...) { return false; }
+    if (idx != number.size() || !isfinite(v)) return false;
+    bool below = text[0] == '<' || text[0] == '=', above = text[0] == '>' || text[0] == '=';
+    bool strict = opLen == 1 && text[0] != '=';
+    if (below && (v < range.hi || (strict && v == range.hi))) { range.hi = v; range.hiOpen = strict; }
+    if (above && (v > range.lo || (strict && v == range.lo))) { range.lo = v; range.loOpen = strict; }
+    return true;
+}
+
+// Navigation state keywords of status queries, indexed by State
+const char* const STATE_WORDS[] = { "stopped", "docked", "ditw", "moving", "course" };
+
+} // namespace
+
+// Indexed by (Command - CmdCourse)
+const Controller::ShipHandler Controller::SHIP_HANDLERS[] = {
+    &Controller::shipCourse,
+    &Controller::shipPosition,
+    &Controller::shipDestination,
+    &Controller::shipLoadAt,
+    &Controller::shipUnloadAt,
+    &Controller::shipDockAt,
+    &Controller::shipVoyage,
+    &Controller::shipAttack,
+    &Controller::shipRefuel,
+    &Controller::shipStop,
 };
 
+Controller::Command Controller::lookupCommand(const string& token) {
+    const Keyword* kw = findKeyword(token);
+    return kw ? kw->cmd : CmdNone;
+}
+
 // Constructor / Destructor
 
-Controller::Controller() {
+Controller::Controller(Model& model, ostream& out, ostream& err) : model(model), out(out), err(err) {
     view_ptr = make_shared<View>();
 }
 
 Controller::~Controller() = default;
 
+const View& Controller::getView() const { return *view_ptr; }
+
+Model& Controller::getModel() const { return model; }
+
 // run() — main event loop
 
+/**
+ * Reader thread: getline + tokenize, pushed into the ring buffer.
+ * Model thread (this one): pops batches and executes them in order.
+ * The reader stops on its own after forwarding "exit" or end of input, so it
+ * can always be joined. cin is untied from cout because the reader must not
+ * flush cout behind the model thread's back; the model thread flushes itself
+ * whenever it is about to wait for input.
+ */
 void Controller::run() {
-    string line;
-    while (true) {
-        cout << "Time " << Model::get().getTime() << ": Enter command: ";
-        if (!getline(cin, line)) break;  // EOF
-        if (!parseCommand(line)) break;  // "exit"
+    SpscQueue<ParsedCommand> queue(INPUT_QUEUE_CAPACITY);
+    ostream* tied = cin.tie(nullptr);
+
+    thread reader([&queue]() {
+        string line;
+        while (getline(cin, line)) {
+            ParsedCommand pc = tokenize(line);
+            bool isExit = (pc.cmd == CmdExit);
+            queue.push(move(pc));
+            if (isExit) return;
+        }
+        ParsedCommand end;
+        end.eof = true;
+        queue.push(move(end));
+    });
+
+    vector<ParsedCommand> batch;
+    batch.reserve(INPUT_BATCH_SIZE);
+    bool running = true;
+    while (running) {
+        out << "Time " << model.getTime() << ": Enter command: ";
+        batch.clear();
+        if (queue.empty()) out.flush(); // about to wait on the user / upstream
+        queue.popBatch(batch, INPUT_BATCH_SIZE);
+        for (size_t i = 0; i < batch.size() && running; ++i) {
+            if (i > 0) out << "Time " << model.getTime() << ": Enter command: ";
+            if (batch[i].eof || !execute(batch[i])) running = false; // EOF / "exit"
+        }
+    }
+
+    reader.join();
+    out.flush();
+    cin.tie(tied);
+}
+
+// tokenize() — split off the first token (no Model access, safe on the reader thread)
+
+Controller::ParsedCommand Controller::tokenize(const string& line) {
+    ParsedCommand pc;
+    pc.line = line;
+    size_t begin = 0;
+    while (begin < line.size() && isspace(static_cast<unsigned char>(line[begin]))) ++begin;
+    size_t end = begin;
+    while (end < line.size() && !isspace(static_cast<unsigned char>(line[end]))) ++end;
+    pc.first   = line.substr(begin, end - begin);
+    pc.argsPos = end;
+    pc.cmd     = lookupCommand(pc.first);
+    return pc;
+}
+
+// Argument helpers, shared with the script compiler
+
+Controller::CoordStatus Controller::readCoordinates(istringstream& args, double& x, double& y) {
+    string coordToken;
+    if (!(args >> coordToken)) return CoordMissing;
+    // If it doesn't end with ')' we need to read the second half
+    if (coordToken.back() != ')') {
+        string coordToken2;
+        if (!(args >> coordToken2)) return CoordMissing;
+        coordToken += coordToken2;
+    }
+    // Strip parentheses, replace the comma with a space
+    string inner;
+    for (char c : coordToken)
+        if (c != '(' && c != ')') inner += c;
+    for (char& c : inner)
+        if (c == ',') c = ' ';
+    istringstream coordSS(inner);
+    return (coordSS >> x >> y) ? CoordOk : CoordInvalid;
+}
+
+bool Controller::parseShipType(const string& token, ShipType& type) {
+    if (token == "Freighter")   { type = FreighterType; return true; }
+    if (token == "Patrol_boat") { type = PatrolType;    return true; }
+    if (token == "Cruiser")     { type = CruiserType;   return true; }
+    return false;
+}
+
+/**
+ * Tokens, in any order:
+ *   type=T[,T...]      Freighter, Patrol_boat, Cruiser
+ *   state=S[,S...]     Stopped, Docked, DITW, Moving, Course (any case)
+ *   fuel<v, containers>=v, ...   also <=, >, =; repeat to bound both sides
+ *   near (x,y) r       within r nm of (x, y)
+ *   top N by F         the N largest by fuel or containers
+ *   page P, per N      page P (from 1) of N ships (default STATUS_PAGE_SIZE)
+ */
+bool Controller::parseStatusQuery(istringstream& args, StatusQuery& query, string& reason) {
+    string tok;
+    while (args >> tok) {
+        if (tok.compare(0, 5, "type=") == 0 || tok.compare(0, 6, "state=") == 0) {
+            bool isType = tok[0] == 't';
+            istringstream values(tok.substr(isType ? 5 : 6));
+            string value;
+            bool any = false;
+            while (getline(values, value, ',')) {
+                any = true;
+                if (isType) {
+                    ShipType type;
+                    if (!parseShipType(value, type)) { reason = "type must be Freighter, Patrol_boat or Cruiser"; return false; }
+                    query.types |= static_cast<uint8_t>(1u << type);
+                    continue;
+                }
+                for (char& c : value) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+                int state = 0;
+                while (state < 5 && value != STATE_WORDS[state]) ++state;
+                if (state == 5) { reason = "state must be Stopped, Docked, DITW, Moving or Course"; return false; }
+                query.states |= static_cast<uint8_t>(1u << state);
+            }
+            if (!any) { reason = tok + " needs a value"; return false; }
+        } else if (tok.compare(0, 4, "fuel") == 0 && tok.size() > 4 && !isalpha(static_cast<unsigned char>(tok[4]))) {
+            if (!readComparison(tok.substr(4), query.fuel)) { reason = "fuel needs a comparison such as fuel<50"; return false; }
+        } else if (tok.compare(0, 10, "containers") == 0 && tok.size() > 10) {
+            if (!readComparison(tok.substr(10), query.containers)) {
+                reason = "containers needs a comparison such as containers>=100";
+                return false;
+            }
+        } else if (tok == "near") {
+            if (readCoordinates(args, query.nearX, query.nearY) != CoordOk) { reason = "near requires a location and a radius"; return false; }
+            string radius;
+            size_t idx = 0;
+            if (!(args >> radius)) { reason = "near requires a location and a radius"; return false; }
+            try { query.nearR = stod(radius, &idx); }
+            catch (...) { idx = 0; }
+            if (idx == 0 || idx != radius.size() || !(query.nearR >= 0)) { reason = "near radius must be a non-negative number"; return false; }
+            query.near = true;
+        } else if (tok == "top") {
+            string count, by, field;
+            if (!(args >> count >> by >> field) || by != "by" || !readCount(count, query.top)) {
+                reason = "top requires a count and a field, e.g. top 20 by containers";
+                return false;
+            }
+            if (field == "fuel")            query.rank = RankFuel;
+            else if (field == "containers") query.rank = RankContainers;
+            else { reason = "ships can only be ranked by fuel or containers"; return false; }
+        } else if (tok == "page" || tok == "per") {
+            string count;
+            if (!(args >> count) || !readCount(count, tok == "page" ? query.page : query.perPage)) {
+                reason = tok + " must be a positive integer";
+                return false;
+            }
+        } else {
+            reason = "unknown status filter '" + tok + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Controller::parseSize(istringstream& args, int& size, string& error) {
+    string tok;
+    if (!(args >> tok)) { error = "Error: size requires an integer argument"; return false; }
+    for (char c : tok)
+        if (!isdigit(c) && c != '-') { error = "ERROR: Expected an integer."; return false; }
+    try { size = stoi(tok); }
+    catch (...) { error = "ERROR: Expected an integer."; return false; }
+    return true;
+}
+
+bool Controller::parseZoom(istringstream& args, double& scale, string& error) {
+    string tok;
+    if (!(args >> tok)) { error = "Error: zoom requires a numeric argument"; return false; }
+    size_t idx = 0;
+    try { scale = stod(tok, &idx); }
+    catch (...) { idx = 0; }
+    if (idx == 0 || idx != tok.size()) { error = "ERROR: Expected a double."; return false; }
+    return true;
+}
+
+bool Controller::parsePan(istringstream& args, double& x, double& y, string& error) {
+    if (!(args >> x >> y)) { error = "Error: pan requires two numeric arguments"; return false; }
+    return true;
+}
+
+bool Controller::parseCreate(istringstream& args, CreateArgs& create, string& error) {
+    string name, type;
+    if (!(args >> name)) { error = "Error: create requires a name"; return false; }
+    if (name.size() > 12) { error = "Error: ship name too long (max 12 chars)"; return false; }
+    for (char c : name)
+        if (!isalpha(c)) { error = "Error: ship name must be alphabetic"; return false; }
+    create.name = name;
+    if (!(args >> type)) { error = "Error: create requires a ship type"; return false; }
+    switch (readCoordinates(args, create.x, create.y)) {
+        case CoordMissing: error = "Error: create requires coordinates"; return false;
+        case CoordInvalid: error = "Error: invalid coordinates"; return false;
+        case CoordOk:      break;
+    }
+    if (!(args >> create.stat)) { error = "Error: create requires a resistance/force value"; return false; }
+    int extra = 0;
+    create.extra = args >> extra ? extra : 0; // optional
+    if (!parseShipType(type, create.type)) { error = "Error: unknown ship type '" + type + "'"; return false; }
+    return true;
+}
+
+// A leading number is the count; the first other token is the file
+bool Controller::parseTrack(istringstream& args, TrackArgs& track, string& error) {
+    string name, tok;
+    if (!(args >> name)) { error = "Error: track requires a ship name"; return false; }
+    track.name = name;
+    while (args >> tok) {
+        if (!tok.empty() && isdigit(static_cast<unsigned char>(tok[0])) && track.file.empty() && track.count == 0) {
+            if (!readCount(tok, track.count)) { error = "Error: track count must be a positive integer"; return false; }
+        } else if (track.file.empty()) {
+            track.file = tok;
+        } else {
+            error = "Error: too many arguments to track";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Controller::parseEncounters(istringstream& args, bool& given, double& nm, string& error) {
+    string tok;
+    given = static_cast<bool>(args >> tok);
+    if (!given) return true;
+    size_t idx = 0;
+    try { nm = stod(tok, &idx); }
+    catch (...) { error = "ERROR: Expected a double."; return false; }
+    if (idx != tok.size() || nm < 0) { error = "Error: encounter distance must be a non-negative number"; return false; }
+    return true;
+}
+
+bool Controller::parsePorts(istringstream& args, size_t& limit, string& error) {
+    string tok;
+    limit = 0;
+    if (args >> tok && !readCount(tok, limit)) { error = "Error: ports count must be a positive integer"; return false; }
+    return true;
+}
+
+bool Controller::parseProfile(istringstream& args, ProfileAction& action, string& error) {
+    string tok;
+    action = ProfileReport;
+    if (args >> tok && !readProfileAction(tok, action)) { error = "Error: profile takes on, off or reset"; return false; }
+    return true;
+}
+
+bool Controller::parseRemove(istringstream& args, string& name, string& error) {
+    if (!(args >> name)) { error = "Error: remove requires a name"; return false; }
+    return true;
+}
+
+bool Controller::parseShipArgs(Command cmd, istringstream& args, ShipArgs& ship, string& error) {
+    switch (cmd) {
+    case CmdCourse:
+        if (!(args >> ship.heading >> ship.speed)) { error = "Error: course requires heading and speed"; return false; }
+        return true;
+    case CmdPosition:
+        switch (readCoordinates(args, ship.x, ship.y)) {
+            case CoordMissing: error = "Error: position requires coordinates"; return false;
+            case CoordInvalid: error = "Error: invalid coordinates"; return false;
+            case CoordOk:      break;
+        }
+        if (!(args >> ship.speed)) { error = "Error: position requires speed"; return false; }
+        return true;
+    case CmdDestination:
+        if (!(args >> ship.other >> ship.speed)) { error = "Error: destination requires port name and speed"; return false; }
+        return true;
+    case CmdLoadAt:
+        if (!(args >> ship.other)) { error = "Error: load_at requires a port name"; return false; }
+        return true;
+    case CmdDockAt:
+        if (!(args >> ship.other)) { error = "Error: dock_at requires a port name"; return false; }
+        return true;
+    case CmdUnloadAt:
+        if (!(args >> ship.other >> ship.count)) { error = "Error: unload_at requires port name and container count"; return false; }
+        return true;
+    case CmdVoyage:
+        if (!(args >> ship.other >> ship.hours)) { error = "Error: voyage requires a port name and hours"; return false; }
+        return true;
+    case CmdAttack:
+        if (!(args >> ship.other)) { error = "Error: attack requires a target ship name"; return false; }
+        return true;
+    default:
+        return true; // refuel, stop
     }
 }
 
 // parseCommand() — top-level dispatcher
 
 bool Controller::parseCommand(const string& line) {
-    istringstream iss(line);
-    string first;
-    if (!(iss >> first)) return true;  // empty line — ignore
+    return execute(tokenize(line));
+}
 
-    if (first == "exit") return false;
+bool Controller::execute(const ParsedCommand& pc) {
+    if (pc.first.empty()) return true;  // empty line — ignore
+    istringstream iss(pc.line.substr(pc.argsPos));
+    if (!readsOnly(pc.cmd)) snapshotStale = true;
 
-    if (VIEW_COMMANDS.count(first))  { handleViewCommand(first, iss);       return true; }
-    if (MODEL_COMMANDS.count(first)) { handleModelCommand(first, iss);      return true; }
-    if (Model::get().shipExists(first)) { handleShipCommand(first, iss);    return true; }
+    if (pc.cmd != CmdNone) {
+        switch (KEYWORDS[pc.cmd].group) {
+            case ExitGroup:  return false;
+            case ViewGroup:  handleViewCommand(pc.cmd, iss);  return true;
+            case ModelGroup: handleModelCommand(pc.cmd, iss); return true;
+            case ShipGroup:  break; // a ship sub-command is not a command on its own
+        }
+    }
+    NameId shipId = NameTable::get().find(pc.first);
+    if (model.shipExists(shipId)) { handleShipCommand(shipId, iss); return true; }
 
-    cerr << "Error: illegal command\n";
+    err << "Error: illegal command\n";
     return true;
 }
 
@@ -83,53 +573,43 @@ bool Controller::parseCommand(const string& line) {
  *   pan  <double> <double> – set origin (x y)
  *   show                 – draw the map
  */
-bool Controller::handleViewCommand(const string& cmd, istringstream& args) {
+bool Controller::handleViewCommand(Command cmd, istringstream& args) {
+    string error;
     try {
-        if (cmd == "default") {
+        switch (cmd) {
+        case CmdDefault:
             view_ptr->setDefault();
             return true;
-        }
-        if (cmd == "show") {
-            view_ptr->draw();
+        case CmdShow:
+            show();
             return true;
-        }
-        if (cmd == "size") {
-            string tok;
-            if (!(args >> tok)) { cerr << "Error: size requires an integer argument\n"; return false; }
-            // validate integer
-            for (char c : tok) {
-                if (!isdigit(c) && c != '-') {
-                    cerr << "ERROR: Expected an integer.\n";
-                    return false;
-                }
-            }
-            int s = stoi(tok);
+        case CmdSize: {
+            int s;
+            if (!parseSize(args, s, error)) break;
             view_ptr->setSize(s);   // throws invalid_argument if out of range
             return true;
         }
-        if (cmd == "zoom") {
-            string tok;
-            if (!(args >> tok)) { cerr << "Error: zoom requires a numeric argument\n"; return false; }
-            // try parsing as double; catch bad input
-            size_t idx = 0;
+        case CmdZoom: {
             double z;
-            try { z = stod(tok, &idx); }
-            catch (...) { cerr << "ERROR: Expected a double.\n"; return false; }
-            if (idx != tok.size()) { cerr << "ERROR: Expected a double.\n"; return false; }
+            if (!parseZoom(args, z, error)) break;
             view_ptr->setScale(z);  // throws invalid_argument if <= 0
             return true;
         }
-        if (cmd == "pan") {
+        case CmdPan: {
             double px, py;
-            if (!(args >> px >> py)) { cerr << "Error: pan requires two numeric arguments\n"; return false; }
+            if (!parsePan(args, px, py, error)) break;
             view_ptr->setOrigin(px, py);
             return true;
         }
+        default:
+            error = "Error: unknown view command";
+            break;
+        }
     } catch (const invalid_argument& e) {
-        cerr << "ERROR: " << e.what() << "\n";
+        err << "ERROR: " << e.what() << "\n";
         return false;
     }
-    cerr << "Error: unknown view command '" << cmd << "'\n";
+    err << error << "\n";
     return false;
 }
 
@@ -137,97 +617,284 @@ bool Controller::handleViewCommand(const string& cmd, istringstream& args) {
 
 /**
  * Commands:
- *   status – print status of all objects
+ *   status [query]          – every object, or see statusCommand()
  *   go                   – advance simulation one hour
  *   create <name> <type> (<x>,<y>) <stat> [<extra>]
  *       type: Freighter | Patrol_boat | Cruiser
  *       stat: resistance (Freighter/Patrol) or force (Cruiser)
  *       extra: maxContainers (Freighter) | attackRange (Cruiser) | omitted (Patrol)
+ *   track <ship> [N] [file] – see trackCommand()
+ *   encounters [nm]         – see encountersCommand()
+ *   remove <name>           – delete a ship or port (not Nagoya)
+ *   ports [N]               – see portsCommand()
+ *   profile [on|off|reset]  – see profileCommand()
  */
-bool Controller::handleModelCommand(const string& cmd, istringstream& args) {
-    if (cmd == "status") {
-        Model::get().printStatus();
-        return true;
-    }
-    if (cmd == "go") {
-        Model::get().go();
+bool Controller::handleModelCommand(Command cmd, istringstream& args) {
+    if (cmd == CmdTrack) return trackCommand(args);
+    if (cmd == CmdEncounters) return encountersCommand(args);
+    if (cmd == CmdPorts) return portsCommand(args);
+    if (cmd == CmdProfile) return profileCommand(args);
+    if (cmd == CmdStatus) return statusCommand(args);
+    if (cmd == CmdGo) {
+        model.go();
+        snapshotStale = false; // go() publishes the new hour
         return true;
     }
-    if (cmd == "create") {
-        //parse name
+    string error;
+    if (cmd == CmdRemove) {
         string name;
-        if (!(args >> name)) { cerr << "Error: create requires a name\n"; return false; }
-        if (name.size() > 12) { cerr << "Error: ship name too long (max 12 chars)\n"; return false; }
-        // name must be alphabetic
-        for (char c : name) {
-            if (!isalpha(c)) { cerr << "Error: ship name must be alphabetic\n"; return false; }
-        }
-        if (Model::get().nameExists(name)) {
-            cerr << "Error: name '" << name << "' already exists\n";
+        if (!parseRemove(args, name, error)) { err << error << "\n"; return false; }
+        return applyRemove(name);
+    }
+    if (cmd == CmdCreate) {
+        CreateArgs create;
+        bool parsed = parseCreate(args, create, error);
+        // a taken name is reported before anything wrong after it
+        if (!create.name.empty() && model.nameExists(create.name)) {
+            err << "Error: name '" << create.name << "' already exists\n";
             return false;
         }
+        if (!parsed) { err << error << "\n"; return false; }
+        return applyCreate(create.name, create.type, create.x, create.y, create.stat, create.extra);
+    }
+    err << "Error: unknown model command\n";
+    return false;
+}
 
-        //parse type
-        string type;
-        if (!(args >> type)) { cerr << "Error: create requires a ship type\n"; return false; }
-
-        //parse coordinates: "(x,y)" possibly split across tokens
-        // Accept formats: "(x,y)" as one token, or "(x," and "y)" as two tokens
-        double cx, cy;
-        {
-            string coordToken;
-            if (!(args >> coordToken)) { cerr << "Error: create requires coordinates\n"; return false; }
-            // If it doesn't end with ')' we need to read the second half
-            if (coordToken.back() != ')') {
-                string coordToken2;
-                if (!(args >> coordToken2)) { cerr << "Error: create requires coordinates\n"; return false; }
-                coordToken += coordToken2;
-            }
-            // coordToken should now be "(x,y)"
-            // Strip parentheses and comma
-            string inner;
-            for (char c : coordToken) {
-                if (c != '(' && c != ')') inner += c;
-            }
-            // replace comma with space
-            for (char& c : inner) if (c == ',') c = ' ';
-            istringstream coordSS(inner);
-            if (!(coordSS >> cx >> cy)) {
-                cerr << "Error: invalid coordinates\n";
-                return false;
-            }
+bool Controller::applyCreate(const string& name, ShipType type, double x, double y, int stat, int extra) {
+    try {
+        switch (type) {
+            case FreighterType: model.addFreighter(name, x, y, stat, extra); break;
+            case PatrolType:    model.addPatrol(name, x, y, stat);          break;
+            case CruiserType:   model.addCruiser(name, x, y, stat, extra);  break;
         }
+    } catch (const runtime_error& e) {
+        err << "Error: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
 
-        //parse primary stat (resistance or force)
-        int stat;
-        if (!(args >> stat)) { cerr << "Error: create requires a resistance/force value\n"; return false; }
+bool Controller::applyRemove(const string& name) {
+    try {
+        model.remove(name);
+    } catch (const runtime_error& e) {
+        err << "Error: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
 
-        //optional extra parameter
-        int extra = 0;
-        bool hasExtra = static_cast<bool>(args >> extra);
+// statusCommand()
 
-        //create the object
-        try {
-            if (type == "Freighter") {
-                int maxContainers = hasExtra ? extra : 0;
-                Model::get().addFreighter(name, cx, cy, stat, maxContainers);
-            } else if (type == "Patrol_boat") {
-                Model::get().addPatrol(name, cx, cy, stat);
-            } else if (type == "Cruiser") {
-                int range = hasExtra ? extra : 0;
-                Model::get().addCruiser(name, cx, cy, stat, range);
-            } else {
-                cerr << "Error: unknown ship type '" << type << "'\n";
-                return false;
-            }
-        } catch (const runtime_error& e) {
-            cerr << "Error: " << e.what() << "\n";
-            return false;
-        }
+/**
+ * status           – every port and ship, as always
+ * status <query>   – only the ships the query picks (see parseStatusQuery()):
+ *   a count line ("N ships match", with "page P of Q" when there are more),
+ *   then their status lines, ranked if asked, else in creation order.
+ *   e.g. status type=Freighter state=DITW | status fuel<50 page 2
+ *        status near (40, 10) 25 | status top 20 by containers
+ */
+bool Controller::statusCommand(istringstream& args) {
+    args >> ws;
+    if (args.eof()) {
+        model.printStatus(out);
         return true;
     }
-    cerr << "Error: unknown model command '" << cmd << "'\n";
-    return false;
+    StatusQuery query;
+    string reason;
+    if (!parseStatusQuery(args, query, reason)) { err << "Error: " << reason << "\n"; return false; }
+    return listStatus(query);
+}
+
+bool Controller::listStatus(const StatusQuery& query) {
+    StatusPage page = model.queryStatus(query);
+    size_t pages = (page.matches + query.perPage - 1) / query.perPage;
+    if (query.page > max<size_t>(pages, 1)) {
+        err << "Error: page " << query.page << " is past the last page (" << pages << ")\n";
+        return false;
+    }
+    out << page.matches << (page.matches == 1 ? " ship matches" : " ships match");
+    if (pages > 1) out << ", page " << query.page << " of " << pages;
+    out << "\n";
+    for (const auto& ship : page.ships) ship->printStatus(out);
+    return true;
+}
+
+// trackCommand()
+
+/**
+ * track <ship> [N] [file]
+ *   Lists the ship's last N recorded hours (default: all the log holds), oldest
+ *   first. With a file name the samples are written there as CSV instead:
+ *   time,x,y,state,fuel
+ */
+bool Controller::trackCommand(istringstream& args) {
+    TrackArgs track;
+    string error;
+    bool parsed = parseTrack(args, track, error);
+    if (track.name.empty()) { err << error << "\n"; return false; }
+    // the ship and the log are checked before the rest of the arguments
+    NameId id = NameTable::get().find(track.name);
+    if (!trackAllowed(id, track.name)) return false;
+    if (!parsed) { err << error << "\n"; return false; }
+    return applyTrack(id, track.count, track.file);
+}
+
+bool Controller::trackAllowed(NameId id, const string& name) {
+    if (!model.shipExists(id)) { err << "Error: no ship named " << name << "\n"; return false; }
+    if (model.getTrackDepth() == 0) {
+        err << "Error: trajectory recording is off\n";
+        return false;
+    }
+    return true;
+}
+
+bool Controller::applyTrack(NameId id, size_t count, const string& file) {
+    const string& name = NameTable::get().str(id);
+    vector<int> times;
+    vector<TrackPoint> points;
+    model.getTrack(id, count, times, points);
+    bool hasFuel = model.getShip(id)->getMaxFuel() > 0;
+
+    if (!file.empty()) {
+        ofstream csv(file);
+        if (!csv) { err << "Error: cannot open " << file << " for writing\n"; return false; }
+        csv << fixed << setprecision(2) << "time,x,y,state,fuel\n";
+        for (size_t i = 0; i < points.size(); ++i)
+            csv << times[i] << ',' << points[i].x << ',' << points[i].y << ','
+                << stateName(points[i].state) << ',' << points[i].fuel << '\n';
+        return true;
+    }
+
+    out << fixed << setprecision(2);
+    out << "Track of " << name << " (" << points.size() << (points.size() == 1 ? " hour" : " hours") << "):\n";
+    for (size_t i = 0; i < points.size(); ++i) {
+        out << "  Time " << times[i] << ": (" << points[i].x << ", " << points[i].y << "), "
+             << stateName(points[i].state);
+        if (hasFuel) out << ", fuel " << points[i].fuel << " kl";
+        out << "\n";
+    }
+    return true;
+}
+
+// encountersCommand()
+
+/**
+ * encounters       – list ships that came within the proximity threshold of
+ *                    each other during the last hour, in the order they met
+ * encounters <nm>  – set the threshold for the following ticks (0 turns it off)
+ */
+bool Controller::encountersCommand(istringstream& args) {
+    bool given;
+    double nm;
+    string error;
+    if (!parseEncounters(args, given, nm, error)) { err << error << "\n"; return false; }
+    return given ? applyEncounters(nm) : listEncounters();
+}
+
+// Distances are measured on the plane, so geodesic worlds (in degrees) have no detection
+bool Controller::applyEncounters(double nm) {
+    if (nm > 0 && model.getNavigation() == Geodesic) {
+        err << "Error: encounter detection is not available with geodesic navigation\n";
+        return false;
+    }
+    model.setProximityThreshold(nm);
+    return true;
+}
+
+bool Controller::listEncounters() {
+    if (model.getProximityThreshold() <= 0) {
+        err << "Error: proximity detection is off\n";
+        return false;
+    }
+    const vector<Encounter>& events = model.getEncounters();
+    out << fixed << setprecision(2);
+    out << "Encounters within " << model.getProximityThreshold() << " nm: " << events.size() << "\n";
+    for (const Encounter& e : events)
+        out << "  Time " << e.time << ": " << NameTable::get().str(e.first) << " and "
+             << NameTable::get().str(e.second) << ", " << e.distance << " nm apart\n";
+    return true;
+}
+
+// portsCommand()
+
+/**
+ * ports      – every port's fuel outlook, largest projected shortfall first
+ * ports <N>  – only the first N
+ *   One line per port: stock, production, storage, then the ships expected
+ *   (see Model::forecastPorts), what they will ask for and how much of that
+ *   the port will be short.
+ */
+bool Controller::portsCommand(istringstream& args) {
+    size_t limit;
+    string error;
+    if (!parsePorts(args, limit, error)) { err << error << "\n"; return false; }
+    return listPorts(limit);
+}
+
+bool Controller::listPorts(size_t limit) {
+    vector<PortForecast> forecast = model.forecastPorts(limit);
+    size_t expected = 0;
+    for (const PortForecast& f : forecast) expected += f.outlook.arrivals;
+    out << fixed << setprecision(1);
+    out << "Fuel outlook at time " << model.getTime() << ": " << forecast.size() << " port"
+        << (forecast.size() == 1 ? "" : "s") << ", " << expected << " arrival" << (expected == 1 ? "" : "s")
+        << " expected\n";
+    for (const PortForecast& f : forecast) {
+        const Port& port = *f.port;
+        const PortOutlook& o = f.outlook;
+        out << "  " << port.getName() << ": " << port.getFuel() << " kl, +" << port.getFuelRate() << " kl/hr, ";
+        if (port.getCapacity() < UNLIMITED_STORAGE) out << "holds " << port.getCapacity() << " kl";
+        else                                        out << "no storage limit";
+        if (o.arrivals == 0) {
+            out << "; no arrivals expected\n";
+            continue;
+        }
+        out << "; " << o.arrivals << (o.arrivals == 1 ? " arrival" : " arrivals") << " from hour "
+            << model.getTime() + o.firstHour << ", demand " << o.demand << " kl, shortfall " << o.shortfall << " kl\n";
+    }
+    return true;
+}
+
+// profileCommand()
+
+/**
+ * profile        – per phase of the ticks since profiling started (ports, each
+ *                  ship type, bookkeeping) and of the maps drawn: time, and
+ *                  with hardware counters cycles, IPC and misses per object
+ * profile on     – start profiling (again, from zero)
+ * profile off    – stop and drop the profile
+ * profile reset  – keep profiling, from zero
+ */
+bool Controller::profileCommand(istringstream& args) {
+    ProfileAction action;
+    string error;
+    if (!parseProfile(args, action, error)) { err << error << "\n"; return false; }
+    return applyProfile(action);
+}
+
+bool Controller::applyProfile(ProfileAction action) {
+    if (action == ProfileOn)  { model.startProfiling(); return true; }
+    if (action == ProfileOff) { model.stopProfiling(); return true; }
+    TickProfiler* prof = model.getProfiler();
+    if (!prof) {
+        err << "Error: profiling is off\n";
+        return false;
+    }
+    if (action == ProfileReset) prof->reset();
+    else                        prof->report(out);
+    return true;
+}
+
+// Draws the latest snapshot, publishing a new one only if a command may have changed the Model since
+void Controller::show() {
+    shared_ptr<const ModelSnapshot> snap = snapshotStale ? model.publishSnapshot() : model.getSnapshot();
+    snapshotStale = false;
+    TickProfiler* prof = model.getProfiler();
+    if (prof) prof->beginDraw();
+    view_ptr->draw(*snap, out);
+    if (prof) prof->mark(PhaseDraw, snap->ports.size() + snap->ships.size());
 }
 
 // handleShipCommand()
@@ -242,194 +909,304 @@ bool Controller::handleModelCommand(const string& cmd, istringstream& args) {
  *   load_at <port>                – set load port (Freighter only)
  *   unload_at <port> <count>      – set unload port and amount (Freighter only)
  *   dock_at <port>                – set dock destination (Freighter only)
+ *   voyage <port> <hours>         – least-fuel voyage, refuel stops included (Freighter only)
  *   attack <target>               – queue attack for next step (Cruiser only)
  */
-bool Controller::handleShipCommand(const string& shipName, istringstream& args) {
+bool Controller::handleShipCommand(NameId shipId, istringstream& args) {
+    static_assert(sizeof(SHIP_HANDLERS) / sizeof(SHIP_HANDLERS[0]) == CmdNone - CmdCourse,
+                  "SHIP_HANDLERS must cover every ship command");
+    const string& shipName = NameTable::get().str(shipId);
     string subcmd;
     if (!(args >> subcmd)) {
-        cerr << "Error: missing command for ship '" << shipName << "'\n";
+        err << "Error: missing command for ship '" << shipName << "'\n";
         return false;
     }
-    if (!SHIP_COMMANDS.count(subcmd)) {
-        cerr << "Error: illegal command '" << subcmd << "' for ship '" << shipName << "'\n";
+    const Keyword* kw = findKeyword(subcmd);
+    if (!kw || kw->group != ShipGroup) {
+        err << "Error: illegal command '" << subcmd << "' for ship '" << shipName << "'\n";
         return false;
     }
 
     try {
-        auto ship = Model::get().getShip(shipName);
+        Ship& ship = *model.getShip(shipId);
+        if (!shipAccepts(*kw, ship, err)) return false;
+        ShipArgs parsed;
+        string error;
+        if (!parseShipArgs(kw->cmd, args, parsed, error)) { err << error << "\n"; return false; }
+        return (this->*SHIP_HANDLERS[kw->cmd - CmdCourse])(ship, parsed);
+    } catch (const runtime_error& e) {
+        err << "Error: " << e.what() << "\n";
+        return false;
+    }
+}
 
-        //- stop-
-        if (subcmd == "stop") {
-            ship->stop();
-            return true;
-        }
+//- stop-
+bool Controller::shipStop(Ship& ship, const ShipArgs&) {
+    ship.stop();
+    return true;
+}
 
-        //- refuel-
-        if (subcmd == "refuel") {
-            if (ship->getState() != Docked) {
-                cerr << "Error: '" << shipName << "' is not docked\n";
-                return false;
-            }
-            // Find the port it is docked at (same location)
-            auto objs = Model::get().getAllObjects();
-            for (const auto& obj : objs) {
-                auto loc = obj->getLocation();
-                if (loc.first == ship->getCorX() && loc.second == ship->getCorY()) {
-                    // Try to cast to Port
-                    auto portPtr = dynamic_pointer_cast<Port>(obj);
-                    if (portPtr) {
-                        double needed = ship->getMaxFuel() - ship->getFuel();
-                        double dispensed = portPtr->dispenseFuel(needed);
-                        ship->refuel(dispensed);
-                        return true;
-                    }
-                }
-            }
-            cerr << "Error: no port found at ship's current location\n";
-            return false;
-        }
+//- refuel-
+bool Controller::shipRefuel(Ship& ship, const ShipArgs&) {
+    return applyRefuel(ship);
+}
 
-        //- course <heading> <speed>-
-        if (subcmd == "course") {
-            double heading, speed;
-            if (!(args >> heading >> speed)) {
-                cerr << "Error: course requires heading and speed\n";
-                return false;
-            }
-            if (speed <= 0 || speed > ship->getMaxSpeed()) {
-                cerr << "Error: invalid speed for '" << shipName << "'\n";
-                return false;
-            }
-            ship->setCourse(heading, speed);
-            return true;
-        }
+bool Controller::applyRefuel(Ship& ship) {
+    if (ship.getState() != Docked) {
+        err << "Error: '" << ship.getName() << "' is not docked\n";
+        return false;
+    }
+    // Find the port it is docked at (same location)
+    auto port = model.getPortAt(ship.getCorX(), ship.getCorY());
+    if (!port) {
+        err << "Error: no port found at ship's current location\n";
+        return false;
+    }
+    double needed = ship.getMaxFuel() - ship.getFuel();
+    double dispensed = port->dispenseFuel(needed);
+    ship.refuel(dispensed);
+    return true;
+}
 
-        //- position (<x>,<y>) <speed>-
-        if (subcmd == "position") {
-            // parse coordinate token (same logic as create)
-            string coordToken;
-            if (!(args >> coordToken)) { cerr << "Error: position requires coordinates\n"; return false; }
-            if (coordToken.back() != ')') {
-                string t2;
-                if (!(args >> t2)) { cerr << "Error: position requires coordinates\n"; return false; }
-                coordToken += t2;
-            }
-            string inner;
-            for (char c : coordToken) if (c != '(' && c != ')') inner += c;
-            for (char& c : inner) if (c == ',') c = ' ';
-            istringstream cs(inner);
-            double px, py;
-            if (!(cs >> px >> py)) { cerr << "Error: invalid coordinates\n"; return false; }
+//- course <heading> <speed>-
+bool Controller::shipCourse(Ship& ship, const ShipArgs& args) {
+    return applyCourse(ship, args.heading, args.speed);
+}
 
-            double speed;
-            if (!(args >> speed)) { cerr << "Error: position requires speed\n"; return false; }
-            if (speed <= 0 || speed > ship->getMaxSpeed()) {
-                cerr << "Error: invalid speed for '" << shipName << "'\n";
-                return false;
-            }
-            ship->setDestination(px, py, speed);
-            return true;
-        }
+bool Controller::applyCourse(Ship& ship, double heading, double speed) {
+    if (speed <= 0 || speed > ship.getMaxSpeed()) {
+        err << "Error: invalid speed for '" << ship.getName() << "'\n";
+        return false;
+    }
+    ship.setCourse(heading, speed);
+    return true;
+}
 
-        //- destination <portName> <speed>-
-        if (subcmd == "destination") {
-            string portName;
-            double speed;
-            if (!(args >> portName >> speed)) {
-                cerr << "Error: destination requires port name and speed\n";
-                return false;
-            }
-            // validate port exists
-            shared_ptr<Port> port;
-            try { port = Model::get().getPort(portName); }
-            catch (...) { cerr << "Error: no port named '" << portName << "'\n"; return false; }
+//- position (<x>,<y>) <speed>-
+bool Controller::shipPosition(Ship& ship, const ShipArgs& args) {
+    return applyPosition(ship, args.x, args.y, args.speed);
+}
 
-            if (speed <= 0 || speed > ship->getMaxSpeed()) {
-                cerr << "Error: invalid speed for '" << shipName << "'\n";
-                return false;
-            }
-            auto loc = port->getLocation();
-            ship->setPortDestination(loc.first, loc.second, speed, portName);
-            return true;
-        }
+bool Controller::applyPosition(Ship& ship, double px, double py, double speed) {
+    if (speed <= 0 || speed > ship.getMaxSpeed()) {
+        err << "Error: invalid speed for '" << ship.getName() << "'\n";
+        return false;
+    }
+    model.sendShip(ship, px, py, speed);
+    return true;
+}
 
-        //- load_at <port>  (Freighter only)-
-        if (subcmd == "load_at") {
-            auto frtr = dynamic_pointer_cast<Freighter>(ship);
-            if (!frtr) { cerr << "Error: load_at is only valid for Freighters\n"; return false; }
-            string portName;
-            if (!(args >> portName)) { cerr << "Error: load_at requires a port name\n"; return false; }
-            try { Model::get().getPort(portName); } // validate
-            catch (...) { cerr << "Error: no port named '" << portName << "'\n"; return false; }
-            frtr->setLoadPort(portName);
-            return true;
-        }
+//- destination <portName> <speed>-
+bool Controller::shipDestination(Ship& ship, const ShipArgs& args) {
+    return applyDestination(ship, NameTable::get().find(args.other), args.other, args.speed);
+}
 
-        //- unload_at <port> <count>  (Freighter only)-
-        if (subcmd == "unload_at") {
-            auto frtr = dynamic_pointer_cast<Freighter>(ship);
-            if (!frtr) { cerr << "Error: unload_at is only valid for Freighters\n"; return false; }
-            string portName;
-            int count;
-            if (!(args >> portName >> count)) {
-                cerr << "Error: unload_at requires port name and container count\n";
-                return false;
-            }
-            try { Model::get().getPort(portName); }
-            catch (...) { cerr << "Error: no port named '" << portName << "'\n"; return false; }
-            frtr->setUnloadPort(portName, count);
-            return true;
-        }
+bool Controller::applyDestination(Ship& ship, NameId portId, const string& portName, double speed) {
+    // validate port exists
+    if (!model.portExists(portId)) {
+        err << "Error: no port named '" << portName << "'\n";
+        return false;
+    }
+    if (speed <= 0 || speed > ship.getMaxSpeed()) {
+        err << "Error: invalid speed for '" << ship.getName() << "'\n";
+        return false;
+    }
+    auto loc = model.getPort(portId)->getLocation();
+    model.sendShip(ship, loc.first, loc.second, speed, portId);
+    return true;
+}
 
-        //- dock_at <port>  (Freighter only)-
-        if (subcmd == "dock_at") {
-            auto frtr = dynamic_pointer_cast<Freighter>(ship);
-            if (!frtr) { cerr << "Error: dock_at is only valid for Freighters\n"; return false; }
-            string portName;
-            if (!(args >> portName)) { cerr << "Error: dock_at requires a port name\n"; return false; }
-            shared_ptr<Port> port;
-            try { port = Model::get().getPort(portName); }
-            catch (...) { cerr << "Error: no port named '" << portName << "'\n"; return false; }
-            auto loc = port->getLocation();
-            // Dock immediately if already within 0.1 nm, otherwise move toward it
-            double dx = frtr->getCorX() - loc.first;
-            double dy = frtr->getCorY() - loc.second;
-            double dist = sqrt(dx*dx + dy*dy);
-            if (dist <= 0.1) {
-                frtr->setCorX(loc.first);
-                frtr->setCorY(loc.second);
-                frtr->changeState(Docked);
-            } else {
-                frtr->setPortDestination(loc.first, loc.second, frtr->getMaxSpeed(), portName);
-            }
-            return true;
-        }
+//- load_at <port>  (Freighter only)-
+bool Controller::shipLoadAt(Ship& ship, const ShipArgs& args) {
+    return applyLoadAt(static_cast<Freighter&>(ship), NameTable::get().find(args.other), args.other);
+}
 
-        //attack <target>  (Cruiser only).
-        if (subcmd == "attack") {
-            auto crs = dynamic_pointer_cast<Cruiser>(ship);
-            if (!crs) { cerr << "Error: attack is only valid for Cruisers\n"; return false; }
-            string targetName;
-            if (!(args >> targetName)) { cerr << "Error: attack requires a target ship name\n"; return false; }
-            if (!Model::get().shipExists(targetName)) {
-                cerr << "Error: no ship named '" << targetName << "'\n";
-                return false;
-            }
-            auto target = Model::get().getShip(targetName);
-            // Check target is not another cruiser
-            if (dynamic_pointer_cast<Cruiser>(target)) {
-                cerr << "Error: Cruisers cannot attack other Cruisers\n";
-                return false;
-            }
-            crs->attack(target.get());
-            return true;
+bool Controller::applyLoadAt(Freighter& frtr, NameId portId, const string& portName) {
+    if (!model.portExists(portId)) {
+        err << "Error: no port named '" << portName << "'\n";
+        return false;
+    }
+    frtr.setLoadPort(portId);
+    return true;
+}
+
+//- unload_at <port> <count>  (Freighter only)-
+bool Controller::shipUnloadAt(Ship& ship, const ShipArgs& args) {
+    return applyUnloadAt(static_cast<Freighter&>(ship), NameTable::get().find(args.other), args.other, args.count);
+}
+
+bool Controller::applyUnloadAt(Freighter& frtr, NameId portId, const string& portName, int count) {
+    if (!model.portExists(portId)) {
+        err << "Error: no port named '" << portName << "'\n";
+        return false;
+    }
+    frtr.setUnloadPort(portId, count);
+    return true;
+}
+
+//- dock_at <port>  (Freighter only)-
+bool Controller::shipDockAt(Ship& ship, const ShipArgs& args) {
+    return applyDockAt(static_cast<Freighter&>(ship), NameTable::get().find(args.other), args.other);
+}
+
+bool Controller::applyDockAt(Freighter& frtr, NameId portId, const string& portName) {
+    if (!model.portExists(portId)) {
+        err << "Error: no port named '" << portName << "'\n";
+        return false;
+    }
+    auto loc = model.getPort(portId)->getLocation();
+    // Dock immediately if already within 0.1 nm, otherwise move toward it
+    double dist = distanceNm(model.getNavigation(), frtr.getCorX(), frtr.getCorY(), loc.first, loc.second);
+    if (dist <= 0.1) {
+        frtr.setCorX(loc.first);
+        frtr.setCorY(loc.second);
+        frtr.changeState(Docked);
+    } else {
+        model.sendShip(frtr, loc.first, loc.second, frtr.getMaxSpeed(), portId);
+    }
+    return true;
+}
+
+//- voyage <port> <hours>  (Freighter only)-
+// Plans the least-fuel voyage (refuel stops included), prints it and sets off
+bool Controller::shipVoyage(Ship& ship, const ShipArgs& args) {
+    return applyVoyage(static_cast<Freighter&>(ship), NameTable::get().find(args.other), args.other, args.hours);
+}
+
+bool Controller::applyVoyage(Freighter& frtr, NameId portId, const string& portName, double hours) {
+    if (!model.portExists(portId)) {
+        err << "Error: no port named '" << portName << "'\n";
+        return false;
+    }
+    if (hours <= 0) {
+        err << "Error: voyage hours must be positive\n";
+        return false;
+    }
+    shared_ptr<const VoyagePlan> plan = model.startVoyage(frtr, portId, hours);
+    out << fixed << setprecision(2);
+    out << "Voyage of " << frtr.getName() << " to " << portName << ": " << plan->legs.size()
+         << (plan->legs.size() == 1 ? " leg, " : " legs, ") << plan->hours << " hours, fuel "
+         << plan->fuel << " kl\n";
+    for (size_t i = 0; i < plan->legs.size(); ++i) {
+        const VoyageLeg& leg = plan->legs[i];
+        out << "  " << i + 1 << ". " << NameTable::get().str(leg.port) << ": " << leg.distance
+             << " nm at " << leg.speed << " nm/hr, fuel " << leg.fuel << " kl"
+             << (i + 1 < plan->legs.size() ? " (refuel)\n" : "\n");
+    }
+    return true;
+}
+
+//attack <target>  (Cruiser only).
+bool Controller::shipAttack(Ship& ship, const ShipArgs& args) {
+    return applyAttack(static_cast<Cruiser&>(ship), NameTable::get().find(args.other), args.other);
+}
+
+bool Controller::applyAttack(Cruiser& crs, NameId targetId, const string& targetName) {
+    if (!model.shipExists(targetId)) {
+        err << "Error: no ship named '" << targetName << "'\n";
+        return false;
+    }
+    auto target = model.getShip(targetId);
+    // Check target is not another cruiser
+    if (target->getType() == CruiserType) {
+        err << "Error: Cruisers cannot attack other Cruisers\n";
+        return false;
+    }
+    model.attack(crs, *target);
+    return true;
+}
+
+// Compiled scripts (see CommandScript.h)
+
+bool Controller::execute(const CommandScript& script) {
+    for (const ScriptOp& op : script.getOps())
+        if (!execute(script, op)) return false;
+    return true;
+}
+
+// Mirrors execute(const ParsedCommand&) and the handlers, minus the parsing
+bool Controller::execute(const CommandScript& script, const ScriptOp& op) {
+    if (!readsOnly(op.cmd)) snapshotStale = true;
+    switch (op.cmd) {
+    case CmdNone:
+        return parseCommand(script.str(op.text));
+    case CmdExit:
+        return false;
+    case CmdDefault:
+        view_ptr->setDefault();
+        return true;
+    case CmdShow:
+        show();
+        return true;
+    case CmdSize:
+    case CmdZoom:
+    case CmdPan:
+        try {
+            if (op.cmd == CmdSize)      view_ptr->setSize(op.n);
+            else if (op.cmd == CmdZoom) view_ptr->setScale(op.z);
+            else                        view_ptr->setOrigin(op.x, op.y);
+        } catch (const invalid_argument& e) {
+            err << "ERROR: " << e.what() << "\n";
         }
+        return true;
+    case CmdStatus:
+        if (op.flag) listStatus(script.query(op.text));
+        else         model.printStatus(out);
+        return true;
+    case CmdGo:
+        model.go();
+        snapshotStale = false;
+        return true;
+    case CmdCreate: {
+        const string& name = script.str(op.text);
+        if (model.nameExists(name)) err << "Error: name '" << name << "' already exists\n";
+        else applyCreate(name, static_cast<ShipType>(op.flag), op.x, op.y, op.n, op.extra);
+        return true;
+    }
+    case CmdTrack:
+        if (trackAllowed(op.ship, NameTable::get().str(op.ship)))
+            applyTrack(op.ship, static_cast<size_t>(op.z), script.str(op.text));
+        return true;
+    case CmdEncounters:
+        if (op.flag) applyEncounters(op.z);
+        else         listEncounters();
+        return true;
+    case CmdRemove:
+        applyRemove(script.str(op.text));
+        return true;
+    case CmdPorts:
+        listPorts(static_cast<size_t>(op.z));
+        return true;
+    case CmdProfile:
+        applyProfile(static_cast<ProfileAction>(op.flag));
+        return true;
+    default:
+        if (model.shipExists(op.ship)) executeShipOp(op);
+        else                           err << "Error: illegal command\n";
+        return true;
+    }
+}
 
+bool Controller::executeShipOp(const ScriptOp& op) {
+    try {
+        Ship& ship = *model.getShip(op.ship);
+        if (!shipAccepts(KEYWORDS[op.cmd], ship, err)) return false;
+        const string& other = NameTable::get().str(op.other);
+        switch (op.cmd) {
+        case CmdCourse:      return applyCourse(ship, op.x, op.z);
+        case CmdPosition:    return applyPosition(ship, op.x, op.y, op.z);
+        case CmdDestination: return applyDestination(ship, op.other, other, op.z);
+        case CmdLoadAt:      return applyLoadAt(static_cast<Freighter&>(ship), op.other, other);
+        case CmdUnloadAt:    return applyUnloadAt(static_cast<Freighter&>(ship), op.other, other, op.n);
+        case CmdDockAt:      return applyDockAt(static_cast<Freighter&>(ship), op.other, other);
+        case CmdVoyage:      return applyVoyage(static_cast<Freighter&>(ship), op.other, other, op.z);
+        case CmdAttack:      return applyAttack(static_cast<Cruiser&>(ship), op.other, other);
+        case CmdRefuel:      return applyRefuel(ship);
+        case CmdStop:        ship.stop(); return true;
+        default:             return false;
+        }
     } catch (const runtime_error& e) {
-        cerr << "Error: " << e.what() << "\n";
+        err << "Error: " << e.what() << "\n";
         return false;
     }
-
-    cerr << "Error: unhandled ship command '" << subcmd << "'\n";
-    return false;
 }
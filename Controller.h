@@ -3,53 +3,236 @@ This class is responsible for controlling the Model and View according to intera
 with the user.
 */
 #pragma once
+#include <cstdint>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <sstream>
+#include "NameTable.h"
+#include "ShipTraits.h"
 
-// Forward-declare View to avoid circular includes; actual include in .cpp
+// Forward-declare to avoid circular includes; actual includes in .cpp
+class Model;
 class View;
+class Ship;
+class Freighter;
+class Cruiser;
+class CommandScript;
+struct ScriptOp;
+struct StatusQuery;
 
 class Controller {
 public:
-    Controller();
+    // Drive model; command output goes to out, error messages to err
+    explicit Controller(Model& model, std::ostream& out = std::cout, std::ostream& err = std::cerr);
     ~Controller();
 
-    // Creates View object, runs the program by accepting user commands, then destroys View object
+    /**
+     * Runs the program by accepting user commands until "exit" or end of input.
+     * Pipelined: a reader thread reads and tokenizes stdin into a lock-free SPSC
+     * ring buffer while this (model) thread executes commands in batches. Each
+     * prompt is printed by the model thread right before its command executes,
+     * so the output is identical to a synchronous read-execute loop.
+     */
     void run();
 
-private:
-    std::shared_ptr<View> view_ptr;
-
     /**
      * Parse a single input line and dispatch to the appropriate handler.
      * Returns false if the command was "exit" (caller should stop the loop),
      * true otherwise (even on error — errors are reported but the loop continues).
+     * Public so headless drivers (e.g. the soak harness) can replay command scripts.
      */
     bool parseCommand(const std::string& line);
 
+    // The View this controller renders with
+    const View& getView() const;
+
+    // The world this controller drives
+    Model& getModel() const;
+
+    // Every command keyword; resolved once per token through a perfect-hash table
+    enum Command : uint8_t {
+        CmdExit,
+        // view group
+        CmdDefault, CmdSize, CmdZoom, CmdPan, CmdShow,
+        // model group
+        CmdStatus, CmdGo, CmdCreate, CmdTrack, CmdEncounters, CmdRemove, CmdPorts, CmdProfile,
+        // ship group (order matches SHIP_HANDLERS)
+        CmdCourse, CmdPosition, CmdDestination, CmdLoadAt, CmdUnloadAt,
+        CmdDockAt, CmdVoyage, CmdAttack, CmdRefuel, CmdStop,
+        CmdNone // not a keyword
+    };
+
+    // Resolve a token to its keyword in O(1); CmdNone if it is not a keyword
+    static Command lookupCommand(const std::string& token);
+
+    // A command line split at its first token; everything here is Model-independent,
+    // so it can be produced off the model thread
+    struct ParsedCommand {
+        std::string line;        // raw input line
+        std::string first;       // first token (keyword or ship name); empty for a blank line
+        Command     cmd = CmdNone; // keyword for first, CmdNone if first is not a keyword
+        size_t      argsPos = 0; // offset in line just past the first token
+        bool        eof = false; // end-of-input marker (no line)
+    };
+
+    // Split a line into a ParsedCommand (thread-safe, touches no Model state)
+    static ParsedCommand tokenize(const std::string& line);
+
+    // Execute a tokenized command; same contract as parseCommand()
+    bool execute(const ParsedCommand& pc);
+
+    /**
+     * Run a compiled script (see CommandScript.h) from the top; prints exactly
+     * what replaying its text lines would. Returns false if it reached "exit".
+     */
+    bool execute(const CommandScript& script);
+
+    // "(x,y)" as one token or split after the comma, as create and position take it
+    enum CoordStatus : uint8_t { CoordOk, CoordMissing, CoordInvalid };
+    static CoordStatus readCoordinates(std::istringstream& args, double& x, double& y);
+
+    // "Freighter" / "Patrol_boat" / "Cruiser"; false for anything else
+    static bool parseShipType(const std::string& token, ShipType& type);
+
+    // What `profile [on|off|reset]` asks for
+    enum ProfileAction : uint8_t { ProfileReport, ProfileOn, ProfileOff, ProfileReset };
+
+    // The filters, ranking and page of a status query (see statusCommand()); false with a reason if malformed
+    static bool parseStatusQuery(std::istringstream& args, StatusQuery& query, std::string& reason);
+
+    // create <name> <type> (<x>,<y>) <stat> [<extra>]
+    struct CreateArgs {
+        std::string name; // set once read and valid, even if a later argument is not
+        ShipType    type = FreighterType;
+        double      x = 0, y = 0;
+        int         stat = 0, extra = 0;
+    };
+
+    // track <ship> [N] [file]
+    struct TrackArgs {
+        std::string name;      // set once read, even if a later argument is not
+        size_t      count = 0; // hours; 0 = all the log holds
+        std::string file;      // empty = print
+    };
+
+    // A ship sub-command's arguments (each uses only its own)
+    struct ShipArgs {
+        double      heading = 0;  // course
+        double      x = 0, y = 0; // position
+        double      speed = 0;    // course, position, destination
+        double      hours = 0;    // voyage
+        int         count = 0;    // unload_at
+        std::string other;        // the port, or attack's target
+    };
+
+    /**
+     * Argument parsers, one per command, shared by the typed handlers and the
+     * script compiler: false with the error line the command prints in error.
+     * The optional arguments' flags (encounters, ports) say whether one was given.
+     */
+    static bool parseSize(std::istringstream& args, int& size, std::string& error);
+    static bool parseZoom(std::istringstream& args, double& scale, std::string& error);
+    static bool parsePan(std::istringstream& args, double& x, double& y, std::string& error);
+    static bool parseCreate(std::istringstream& args, CreateArgs& create, std::string& error);
+    static bool parseTrack(std::istringstream& args, TrackArgs& track, std::string& error);
+    static bool parseEncounters(std::istringstream& args, bool& given, double& nm, std::string& error);
+    static bool parsePorts(std::istringstream& args, size_t& limit, std::string& error);
+    static bool parseProfile(std::istringstream& args, ProfileAction& action, std::string& error);
+    static bool parseRemove(std::istringstream& args, std::string& name, std::string& error);
+    static bool parseShipArgs(Command cmd, std::istringstream& args, ShipArgs& ship, std::string& error);
+
+private:
+    Model&        model;
+    std::ostream& out;
+    std::ostream& err;
+    std::shared_ptr<View> view_ptr;
+    bool          snapshotStale = true; // a command may have changed the Model since its latest snapshot
+
     /**
      * Handle view-group commands: default, size, zoom, pan, show.
-     * @param cmd   The command keyword (already extracted).
+     * @param cmd   The command keyword (already resolved).
      * @param args  The rest of the input line after the command word.
      * @return true on success, false on illegal command / bad arguments.
      */
-    bool handleViewCommand(const std::string& cmd, std::istringstream& args);
+    bool handleViewCommand(Command cmd, std::istringstream& args);
 
     /**
-     * Handle model-group commands: status, go, create.
-     * @param cmd   The command keyword (already extracted).
+     * Handle model-group commands: status, go, create, track, encounters, remove, ports, profile.
+     * @param cmd   The command keyword (already resolved).
      * @param args  The rest of the input line after the command word.
      * @return true on success, false on illegal command / bad arguments.
      */
-    bool handleModelCommand(const std::string& cmd, std::istringstream& args);
+    bool handleModelCommand(Command cmd, std::istringstream& args);
+
+    // status [filters] [top N by field] [page P] [per N]: every object, or the ships a query picks
+    bool statusCommand(std::istringstream& args);
+
+    // track <ship> [N] [file]: print (or write as CSV) the ship's last N recorded hours
+    bool trackCommand(std::istringstream& args);
+
+    // encounters [nm]: list the last tick's proximity events, or set the threshold (0 = off)
+    bool encountersCommand(std::istringstream& args);
+
+    // ports [N]: fuel outlook of the (N) ports with the largest projected shortfall
+    bool portsCommand(std::istringstream& args);
+
+    // profile [on|off|reset]: report the running profile, or start, stop or clear it
+    bool profileCommand(std::istringstream& args);
+
+    // show: draw the map from a fresh snapshot, into the profile if one is running
+    void show();
 
     /**
      * Handle ship-specific commands: course, position, destination,
-     * load_at, unload_at, dock_at, attack, refuel, stop.
-     * @param shipName  The ship name (already extracted as the first token).
+     * load_at, unload_at, dock_at, voyage, attack, refuel, stop.
+     * Checks the ship's type tag against the command's allowed types, then
+     * calls the handler from SHIP_HANDLERS.
+     * @param shipId    The ship's interned name (resolved from the first token).
      * @param args      The rest of the input line after the ship name.
      * @return true on success, false on illegal command / bad arguments.
      */
-    bool handleShipCommand(const std::string& shipName, std::istringstream& args);
+    bool handleShipCommand(NameId shipId, std::istringstream& args);
+
+    // Ship sub-command handlers; the ship's type has already been validated and its arguments parsed
+    using ShipHandler = bool (Controller::*)(Ship& ship, const ShipArgs& args);
+    static const ShipHandler SHIP_HANDLERS[];
+
+    bool shipCourse(Ship& ship, const ShipArgs& args);
+    bool shipPosition(Ship& ship, const ShipArgs& args);
+    bool shipDestination(Ship& ship, const ShipArgs& args);
+    bool shipLoadAt(Ship& ship, const ShipArgs& args);
+    bool shipUnloadAt(Ship& ship, const ShipArgs& args);
+    bool shipDockAt(Ship& ship, const ShipArgs& args);
+    bool shipVoyage(Ship& ship, const ShipArgs& args);
+    bool shipAttack(Ship& ship, const ShipArgs& args);
+    bool shipRefuel(Ship& ship, const ShipArgs& args);
+    bool shipStop(Ship& ship, const ShipArgs& args);
+
+    // The world-dependent half of each command, after its arguments are parsed;
+    // shared by typed commands and compiled scripts
+    bool applyCreate(const std::string& name, ShipType type, double x, double y, int stat, int extra);
+    bool applyRemove(const std::string& name);
+    bool applyTrack(NameId ship, size_t count, const std::string& file);
+    bool applyEncounters(double nm);
+    bool listStatus(const StatusQuery& query);
+    bool listEncounters();
+    bool listPorts(size_t limit);
+    bool applyProfile(ProfileAction action);
+    bool applyRefuel(Ship& ship);
+    bool applyCourse(Ship& ship, double heading, double speed);
+    bool applyPosition(Ship& ship, double x, double y, double speed);
+    bool applyDestination(Ship& ship, NameId port, const std::string& portName, double speed);
+    bool applyLoadAt(Freighter& frtr, NameId port, const std::string& portName);
+    bool applyUnloadAt(Freighter& frtr, NameId port, const std::string& portName, int count);
+    bool applyDockAt(Freighter& frtr, NameId port, const std::string& portName);
+    bool applyVoyage(Freighter& frtr, NameId port, const std::string& portName, double hours);
+    bool applyAttack(Cruiser& crs, NameId target, const std::string& targetName);
+
+    // The checks typed commands make before parsing arguments: track's ship and log
+    bool trackAllowed(NameId ship, const std::string& name);
+
+    // Run one compiled op; same contract as execute(const ParsedCommand&)
+    bool execute(const CommandScript& script, const ScriptOp& op);
+    bool executeShipOp(const ScriptOp& op);
 };
\ No newline at end of file
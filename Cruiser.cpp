@@ -9,12 +9,12 @@ using namespace std;
 
 // Default constructor
 Cruiser::Cruiser()
-    : Ship(), attackRange(0) {}
+    : attackRange(0) {}
 
 
 /**
  * Create a cruiser (pirate ship).
- * Fuel is not simulated, so fuel and fuelConsumption are set to 0.
+ * Fuel is not simulated: CruiserTraits has no tank and no burn rate.
  * @param name        Ship name
  * @param corX        Starting X coordinate
  * @param corY        Starting Y coordinate
@@ -22,23 +22,22 @@ Cruiser::Cruiser()
  * @param attackRange Attack range in nm
  */
 Cruiser::Cruiser(const string& name, double corX, double corY, int force, int attackRange)
-    : Ship(name, corX, corY, 0.0, 0.0, 0.0, 0, force, CRUISER_MAX_SPEED, 0.0),
+    : ShipKind(name, corX, corY, force),
       attackRange(attackRange) {}
 
 int Cruiser::getAttackRange() const { return attackRange; }
 
 /**
  * Attack target ship.
- * Victory if cruiser force > target resistance.
  * Win:  target->setAttackStat(true),  cruiser force +1
  * Lose: target->setAttackStat(false), cruiser force -1
  * Either way: target is stopped.
  */
-void Cruiser::attack(Ship* target) {
-    bool victory = (attackStat > target->getAttackStat());
+void Cruiser::attack(Ship* target, bool victory) {
     target->setAttackStat(victory);
     if (victory) attackStat++;
     else         attackStat--;
+    touch();
     target->stop();
 }
 
@@ -46,11 +45,12 @@ void Cruiser::attack(Ship* target) {
  * Format:
  * Cruiser <name> at (<x>, <y>), force: <force>, <nav state>
  */
-void Cruiser::printStatus() const {
-    cout << fixed << setprecision(2);
-    cout << "Cruiser " << getName()
+void Cruiser::formatStatus(ostream& out) const {
+    out << fixed << setprecision(2);
+    out << "Cruiser " << getName()
          << " at (" << getCorX() << ", " << getCorY() << ")"
          << ", force: " << attackStat
-         << ", " << navString()
-         << "\n";
+         << ", ";
+    printNav(out);
+    out << "\n";
 }
\ No newline at end of file
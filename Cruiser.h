@@ -4,17 +4,15 @@
 
 #ifndef INC_74_EX3_CRUISER_H
 #define INC_74_EX3_CRUISER_H
-#include "Ship.h"
+#include "ShipKind.h"
 
-// Cruiser (pirate ship) constants
-static const double CRUISER_MAX_SPEED = 75.0; // nm/h
-// No fuel simulation for cruiser (fuel parameters unused)
+// Cruiser constants (CruiserTraits) live in ShipTraits.h; fuel is not simulated
 
 /**
  * Pirate cruiser: attacks freighters and patrol boats within its attack range.
  * Cannot dock at ports. Fuel is not simulated.
  */
-class Cruiser : public Ship {
+class Cruiser : public ShipKind<CruiserTraits> {
 private:
     int attackRange; // attack range in nm
 
@@ -29,19 +27,21 @@ public:
     int getAttackRange() const;
 
     /**
-     * Attack a target ship that is in range.
-     * Victory if this cruiser's force > target's resistance.
+     * Carry out an attack on a target ship that is in range, with its outcome
+     * already decided (Model::attack draws it, see Combat.h).
      * - Freighter victory: target loses all cargo, cruiser force +1.
      * - Freighter defeat:  no cargo change,       cruiser force -1.
      * - Patrol victory:    patrol resistance -1,   cruiser force +1.
      * - Patrol defeat:     patrol resistance +1,   cruiser force -1.
      * Either way, target is stopped (all movement cancelled).
-     * @param target Pointer to the ship being attacked (must be in range).
+     * @param target  Pointer to the ship being attacked (must be in range).
+     * @param victory Whether the cruiser won.
      */
-    void attack(Ship* target);
+    void attack(Ship* target, bool victory);
 
-    // Print detailed status (no fuel shown for cruiser)
-    void printStatus() const override;
+protected:
+    // Status line (no fuel shown for cruiser)
+    void formatStatus(ostream& out) const override;
 };
 
 #endif //INC_74_EX3_CRUISER_H
@@ -0,0 +1,223 @@
+//
+// Ensemble implementation (POSIX: fork, pipe, waitpid)
+//
+#include "Ensemble.h"
+#include "Controller.h"
+#include "Model.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+namespace {
+
+// Every ship's force or resistance, in creation order
+vector<pair<NameId, int>> strengths(const Model& model) {
+    vector<pair<NameId, int>> result;
+    for (const auto& obj : model.getStatusOrder()) {
+        NameId id = obj->getNameId();
+        if (model.shipExists(id)) result.emplace_back(id, model.getShip(id)->getAttackStat());
+    }
+    return result;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+string readAll(int fd) {
+    string data;
+    char buf[65536];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        data.append(buf, static_cast<size_t>(n));
+    }
+    return data;
+}
+
+// Wire format: attacks, victories, containersLost, ship count (uint64 each), then (NameId, int32) per ship
+string encode(const BranchOutcome& o) {
+    uint64_t head[4] = { o.tally.attacks, o.tally.victories, o.tally.containersLost, o.strength.size() };
+    string data(reinterpret_cast<const char*>(head), sizeof(head));
+    for (const auto& s : o.strength) {
+        uint32_t id = s.first;
+        int32_t value = s.second;
+        data.append(reinterpret_cast<const char*>(&id), sizeof(id));
+        data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    return data;
+}
+
+bool decode(const string& data, BranchOutcome& o) {
+    uint64_t head[4];
+    if (data.size() < sizeof(head)) return false;
+    memcpy(head, data.data(), sizeof(head));
+    if (data.size() != sizeof(head) + head[3] * 8) return false;
+    o.tally.attacks        = head[0];
+    o.tally.victories      = head[1];
+    o.tally.containersLost = head[2];
+    o.strength.resize(head[3]);
+    const char* p = data.data() + sizeof(head);
+    for (auto& s : o.strength) {
+        uint32_t id;
+        int32_t value;
+        memcpy(&id, p, 4);
+        memcpy(&value, p + 4, 4);
+        s = make_pair(id, value);
+        p += 8;
+    }
+    return true;
+}
+
+// Child side: play the future of branch b and send the outcome to fd; never returns
+void runBranch(Model& model, const CommandScript& future, const EnsembleSettings& settings, size_t b, int fd) {
+    int status = 1;
+    try {
+        cout.rdbuf(nullptr); // a branch's chatter has nowhere to go
+        cerr.rdbuf(nullptr);
+        ostream discard(nullptr);
+        const CombatTally before = model.getCombatTally();
+        const long until = model.getTime() + settings.ticks;
+        model.seed(branchSeed(settings.seed, b));
+
+        Controller controller(model, discard, discard);
+        controller.execute(future);
+        while (model.getTime() < until) model.go();
+
+        BranchOutcome outcome;
+        outcome.tally.attacks        = model.getCombatTally().attacks - before.attacks;
+        outcome.tally.victories      = model.getCombatTally().victories - before.victories;
+        outcome.tally.containersLost = model.getCombatTally().containersLost - before.containersLost;
+        outcome.strength = strengths(model);
+        string data = encode(outcome);
+        if (writeAll(fd, data.data(), data.size())) status = 0;
+    } catch (...) {
+    }
+    _exit(status); // no atexit handlers or stdio flushing: those belong to the parent
+}
+
+Distribution distributionOf(vector<double> sample) {
+    Distribution d;
+    if (sample.empty()) return d;
+    sort(sample.begin(), sample.end());
+    double sum = 0, squares = 0;
+    for (double v : sample) sum += v;
+    d.mean = sum / sample.size();
+    for (double v : sample) squares += (v - d.mean) * (v - d.mean);
+    d.stddev = sqrt(squares / sample.size());
+    auto at = [&](double p) { return sample[static_cast<size_t>(p / 100.0 * (sample.size() - 1) + 0.5)]; };
+    d.min = sample.front();
+    d.p5  = at(5);
+    d.p50 = at(50);
+    d.p95 = at(95);
+    d.max = sample.back();
+    return d;
+}
+
+} // namespace
+
+/**
+ * Keeps up to jobs children alive. The parent reads each child's pipe to the
+ * end before reaping it, oldest first; a child blocked on a full pipe is
+ * drained in its turn, so nothing waits in a cycle.
+ */
+vector<BranchOutcome> runEnsemble(Model& model, const CommandScript& future, const EnsembleSettings& settings) {
+    if (model.isExporting()) throw runtime_error("cannot branch a world while it is exporting");
+    unsigned jobs = settings.jobs > 0 ? settings.jobs : max(1u, thread::hardware_concurrency());
+
+    struct Child {
+        pid_t  pid;
+        int    fd;
+        size_t branch;
+    };
+    vector<BranchOutcome> outcomes(settings.branches);
+    deque<Child> running;
+    string failure;
+    size_t next = 0;
+    cout.flush();
+    cerr.flush();
+    fflush(nullptr);
+    while ((next < settings.branches && failure.empty()) || !running.empty()) {
+        while (next < settings.branches && failure.empty() && running.size() < jobs) {
+            int fds[2];
+            if (pipe(fds) != 0) { failure = string("pipe: ") + strerror(errno); break; }
+            pid_t pid = fork();
+            if (pid < 0) {
+                failure = string("fork: ") + strerror(errno);
+                close(fds[0]);
+                close(fds[1]);
+                break;
+            }
+            if (pid == 0) {
+                close(fds[0]);
+                for (const Child& c : running) close(c.fd);
+                runBranch(model, future, settings, next, fds[1]);
+            }
+            close(fds[1]);
+            running.push_back(Child{ pid, fds[0], next++ });
+        }
+        if (running.empty()) break;
+
+        Child child = running.front();
+        running.pop_front();
+        string data = readAll(child.fd);
+        close(child.fd);
+        int status = 0;
+        while (waitpid(child.pid, &status, 0) < 0 && errno == EINTR) {}
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && decode(data, outcomes[child.branch]);
+        if (!ok && failure.empty()) failure = "branch " + to_string(child.branch) + " failed";
+    }
+    if (!failure.empty()) throw runtime_error(failure);
+    return outcomes;
+}
+
+EnsembleSummary summarizeEnsemble(const Model& checkpoint, const vector<BranchOutcome>& outcomes) {
+    EnsembleSummary summary;
+    summary.branches = outcomes.size();
+    vector<double> attacks, victories, lost;
+    for (const auto& o : outcomes) {
+        attacks.push_back(static_cast<double>(o.tally.attacks));
+        victories.push_back(static_cast<double>(o.tally.victories));
+        lost.push_back(static_cast<double>(o.tally.containersLost));
+    }
+    summary.attacks        = distributionOf(move(attacks));
+    summary.victories      = distributionOf(move(victories));
+    summary.containersLost = distributionOf(move(lost));
+
+    // Per ship of the checkpoint (ships created in branches are left out), gathered by NameId
+    vector<pair<NameId, int>> start = strengths(checkpoint);
+    vector<int32_t> index(NameTable::get().size(), -1);
+    for (size_t k = 0; k < start.size(); ++k) index[start[k].first] = static_cast<int32_t>(k);
+    vector<vector<double>> values(start.size());
+    for (const auto& o : outcomes)
+        for (const auto& s : o.strength)
+            if (s.first < index.size() && index[s.first] >= 0) values[index[s.first]].push_back(s.second);
+
+    for (size_t k = 0; k < start.size(); ++k) {
+        StrengthSpread spread{ start[k].first, start[k].second, Distribution(), map<int, size_t>() };
+        for (double v : values[k]) ++spread.histogram[static_cast<int>(v)];
+        if (spread.histogram.empty()) continue; // removed in every branch
+        if (spread.histogram.size() == 1 && spread.histogram.begin()->first == spread.start) continue;
+        spread.spread = distributionOf(move(values[k]));
+        summary.ships.push_back(move(spread));
+    }
+    return summary;
+}
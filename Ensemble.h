@@ -0,0 +1,79 @@
+//
+// Ensemble: many possible futures of one world, sampled in parallel.
+//
+// A world is brought to a checkpoint (a state worth asking "what if" about),
+// then branched: every branch gets a copy of the world as it stands, reseeds
+// its random stream with its own branch seed (see Combat.h), replays the same
+// script of future commands and reports how its combat went. With stochastic
+// combat the branches differ only in their draws, so together they sample the
+// distribution of outcomes from the checkpoint.
+//
+// The future script is compiled once, before the first fork (CommandScript.h),
+// so no branch parses it again.
+//
+// Branches are forked processes: fork() copies the world copy-on-write, so a
+// branch costs only the pages it writes, however large the world, and no
+// Model state needs a copy routine. Up to `jobs` branches run at once, each
+// sending its outcome back over a pipe; the checkpointed world in the parent
+// is left untouched. Fork only from a single-threaded state: not while the
+// world is exporting (the exporter runs a thread).
+//
+
+#ifndef INC_74_EX3_ENSEMBLE_H
+#define INC_74_EX3_ENSEMBLE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "Combat.h"
+#include "CommandScript.h"
+#include "NameTable.h"
+using namespace std;
+
+class Model;
+
+struct EnsembleSettings {
+    size_t   branches = 100;
+    unsigned jobs     = 0; // branches running at once (0 = one per hardware thread)
+    uint64_t seed     = 1; // branch b is seeded with branchSeed(seed, b)
+    long     ticks    = 0; // after its script a branch runs until this many hours past the checkpoint
+};
+
+// What one branch ended with
+struct BranchOutcome {
+    CombatTally               tally;    // attacks made in the branch (after the checkpoint)
+    vector<pair<NameId, int>> strength; // per ship: cruiser force or resistance, creation order
+};
+
+// Summary of one quantity over the branches
+struct Distribution {
+    double mean = 0, stddev = 0;
+    double min = 0, p5 = 0, p50 = 0, p95 = 0, max = 0;
+};
+
+// A ship whose force or resistance ended off its checkpoint value in some branch
+struct StrengthSpread {
+    NameId           ship;
+    int              start;     // at the checkpoint
+    Distribution     spread;
+    map<int, size_t> histogram; // final value -> branches
+};
+
+struct EnsembleSummary {
+    size_t branches = 0;
+    Distribution attacks, victories, containersLost;
+    vector<StrengthSpread> ships; // in the checkpoint's creation order
+};
+
+/**
+ * Branch model (at its checkpoint) settings.branches times, replay future in
+ * every branch and return the outcomes in branch order. Throws runtime_error
+ * if the model is exporting, a process cannot be forked, or a branch fails.
+ */
+vector<BranchOutcome> runEnsemble(Model& model, const CommandScript& future, const EnsembleSettings& settings);
+
+// Aggregate outcomes of branches taken from checkpoint
+EnsembleSummary summarizeEnsemble(const Model& checkpoint, const vector<BranchOutcome>& outcomes);
+
+#endif //INC_74_EX3_ENSEMBLE_H
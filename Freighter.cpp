@@ -9,7 +9,8 @@ using namespace std;
 
 // Default constructor
 Freighter::Freighter()
-    : Ship(), containers(0), maxContainers(0), unloadAmount(0) {}
+    : containers(0), maxContainers(0),
+      loadPort(NO_NAME), unloadPort(NO_NAME), unloadAmount(0) {}
 
 
 /**
@@ -22,21 +23,21 @@ Freighter::Freighter()
  */
 Freighter::Freighter(const string& name, double corX, double corY,
                      int resistance, int maxContainers)
-    : Ship(name, corX, corY, 0.0, 0.0, FREIGHTER_MAX_FUEL,
-           FREIGHTER_FUEL_RATE, resistance,
-           FREIGHTER_MAX_SPEED, FREIGHTER_MAX_FUEL),
-      containers(0), maxContainers(maxContainers), unloadAmount(0) {}
+    : ShipKind(name, corX, corY, resistance),
+      containers(0), maxContainers(maxContainers),
+      loadPort(NO_NAME), unloadPort(NO_NAME), unloadAmount(0) {}
 
 // Getters
 int Freighter::getContainers()    const { return containers; }
 int Freighter::getMaxContainers() const { return maxContainers; }
-const string& Freighter::getLoadPort()   const { return loadPort; }
-const string& Freighter::getUnloadPort() const { return unloadPort; }
+NameId Freighter::getLoadPort()   const { return loadPort; }
+NameId Freighter::getUnloadPort() const { return unloadPort; }
 int Freighter::getUnloadAmount()  const { return unloadAmount; }
 
 // Fill cargo to capacity
 void Freighter::loadCargo() {
     containers = maxContainers;
+    touch();
 }
 
 // Unload up to amount; warn if insufficient stock
@@ -47,26 +48,22 @@ void Freighter::unloadCargo(int amount) {
     } else {
         containers -= amount;
     }
+    touch();
 }
 
-void Freighter::setLoadPort(const string& portName)  { loadPort = portName; }
-void Freighter::clearLoadPort()                       { loadPort.clear(); }
-void Freighter::setUnloadPort(const string& portName, int amount) {
-    unloadPort   = portName;
+void Freighter::setLoadPort(NameId port) { loadPort = port; touch(); }
+void Freighter::clearLoadPort()          { loadPort = NO_NAME; touch(); }
+void Freighter::setUnloadPort(NameId port, int amount) {
+    unloadPort   = port;
     unloadAmount = amount;
+    touch();
 }
-void Freighter::clearUnloadPort() { unloadPort.clear(); unloadAmount = 0; }
-
-// Refuel capped at tank capacity
-void Freighter::refuel(double amount) {
-    double newFuel = getFuel() + amount;
-    if (newFuel > FREIGHTER_MAX_FUEL) newFuel = FREIGHTER_MAX_FUEL;
-    setFuel(newFuel);
-}
+void Freighter::clearUnloadPort() { unloadPort = NO_NAME; unloadAmount = 0; touch(); }
 
 // Pirate victory: lose all cargo (resistance unchanged)
 void Freighter::setAttackStat(bool victory) {
     if (victory) containers = 0;
+    touch();
 }
 
 /**
@@ -79,23 +76,24 @@ void Freighter::setAttackStat(bool victory) {
  *   "moving to unloading destination" — only unload port set
  *   "no cargo destinations"           — neither set
  */
-void Freighter::printStatus() const {
+void Freighter::formatStatus(ostream& out) const {
     // Cargo destination label
-    string cargoDest;
-    if (!loadPort.empty())
+    const char* cargoDest;
+    if (loadPort != NO_NAME)
         cargoDest = "moving to loading destination";
-    else if (!unloadPort.empty())
+    else if (unloadPort != NO_NAME)
         cargoDest = "moving to unloading destination";
     else
         cargoDest = "no cargo destinations";
 
-    cout << fixed << setprecision(2);
-    cout << "Freighter " << getName()
+    out << fixed << setprecision(2);
+    out << "Freighter " << getName()
          << " at (" << getCorX() << ", " << getCorY() << ")"
          << ", fuel: " << getFuel() << " kl"
          << ", resistance: " << attackStat
-         << ", " << navString()
-         << ", Containers: " << containers
+         << ", ";
+    printNav(out);
+    out << ", Containers: " << containers
          << ", " << cargoDest
          << "\n";
 }
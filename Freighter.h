@@ -4,23 +4,20 @@
 
 #ifndef INC_74_EX3_FREIGHTER_H
 #define INC_74_EX3_FREIGHTER_H
-#include "Ship.h"
+#include "ShipKind.h"
 
-// Freighter ship constants
-static const double FREIGHTER_MAX_SPEED = 40.0;  // nm/h
-static const double FREIGHTER_MAX_FUEL  = 500.0; // kl
-static const int    FREIGHTER_FUEL_RATE = 1;     // kl per nm
+// Freighter constants (FreighterTraits) live in ShipTraits.h
 
 /**
  * Cargo ship: moves containers between ports.
  * Fuel tank starts full on construction.
  */
-class Freighter : public Ship {
+class Freighter : public ShipKind<FreighterTraits> {
 private:
     int containers;    // current cargo count
     int maxContainers; // maximum capacity
-    string loadPort;   // port name to load at (empty if none set)
-    string unloadPort; // port name to unload at (empty if none set)
+    NameId loadPort;   // port to load at (NO_NAME if none set)
+    NameId unloadPort; // port to unload at (NO_NAME if none set)
     int unloadAmount;  // containers to unload when arriving at unloadPort
 
 public:
@@ -33,8 +30,8 @@ public:
     // Getters
     int getContainers()    const;
     int getMaxContainers() const;
-    const string& getLoadPort()   const;
-    const string& getUnloadPort() const;
+    NameId getLoadPort()   const;
+    NameId getUnloadPort() const;
     int getUnloadAmount()  const;
 
     // Cargo operations (called by model when docked at the relevant port)
@@ -42,18 +39,16 @@ public:
     void unloadCargo(int amount);
 
     // Set cargo destinations (called by controller)
-    void setLoadPort(const string& portName);
-    void setUnloadPort(const string& portName, int amount);
+    void setLoadPort(NameId port);
+    void setUnloadPort(NameId port, int amount);
     void clearLoadPort();
     void clearUnloadPort();
 
-    // Refuel capped at FREIGHTER_MAX_FUEL
-    void refuel(double amount) override;
-
     // On pirate victory: lose all containers (resistance unchanged)
     void setAttackStat(bool victory) override;
 
-    void printStatus() const override;
+protected:
+    void formatStatus(ostream& out) const override;
 };
 
 #endif //INC_74_EX3_FREIGHTER_H
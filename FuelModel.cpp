@@ -0,0 +1,30 @@
+//
+// FuelModel implementation
+//
+#include "FuelModel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+double ConstantFuelModel::perNm(const ShipTraits& traits, double) const { return traits.fuelRate; }
+double ConstantFuelModel::economicalSpeed(const ShipTraits& traits) const { return traits.maxSpeed; }
+
+/**
+ * d/dv of (1 - s)(v/vmax)^2 + s*vmax/v is zero at v/vmax = cbrt(s / (2(1 - s))),
+ * about 0.38 of full speed for the default hotel share.
+ */
+CubicFuelModel::CubicFuelModel(double hotelShare)
+    : hotel(hotelShare), economy(min(1.0, cbrt(hotelShare / (2 * (1 - hotelShare))))) {}
+
+double CubicFuelModel::perNm(const ShipTraits& traits, double speed) const {
+    double x = speed / traits.maxSpeed;
+    return traits.fuelRate * ((1 - hotel) * x * x + hotel / x);
+}
+
+double CubicFuelModel::economicalSpeed(const ShipTraits& traits) const { return economy * traits.maxSpeed; }
+
+shared_ptr<const FuelModel> makeFuelModel(const string& name) {
+    if (name == "constant") return make_shared<ConstantFuelModel>();
+    if (name == "cubic")    return make_shared<CubicFuelModel>();
+    throw runtime_error("unknown fuel model: " + name);
+}
@@ -0,0 +1,58 @@
+//
+// FuelModel: how much fuel a ship burns per nautical mile at a given speed.
+//
+// Each world has its own (see Model::setFuelModel). The default burns the
+// SHIP_TRAITS fuelRate per nm at any speed, as ships always have. The cubic
+// model follows the propeller law: propulsion power grows with the cube of
+// speed, on top of a fixed hotel load (generators, pumps) burned every hour
+// underway. Per nm that is a quadratic rise with speed plus a term that grows
+// as the ship slows, so there is an economical speed below which crawling
+// costs more, not less. Both are calibrated to burn fuelRate per nm at full
+// speed, so tank ranges at full speed do not change.
+//
+
+#ifndef INC_74_EX3_FUELMODEL_H
+#define INC_74_EX3_FUELMODEL_H
+
+#include <memory>
+#include <string>
+#include "ShipTraits.h"
+using namespace std;
+
+static const double CUBIC_HOTEL_SHARE = 0.1; // share of the full-speed burn that does not depend on speed
+
+class FuelModel {
+public:
+    virtual ~FuelModel() = default;
+
+    // kl burned per nm at speed (nm/hr, above 0) by a ship with these traits
+    virtual double perNm(const ShipTraits& traits, double speed) const = 0;
+
+    // Speed in (0, maxSpeed] that burns least per nm; perNm must not fall as speed rises above it
+    virtual double economicalSpeed(const ShipTraits& traits) const = 0;
+};
+
+// fuelRate per nm regardless of speed (the original behaviour)
+class ConstantFuelModel : public FuelModel {
+public:
+    double perNm(const ShipTraits& traits, double speed) const override;
+    double economicalSpeed(const ShipTraits& traits) const override; // any speed; full speed arrives first
+};
+
+// Propeller law plus a hotel load: fuelRate * ((1 - s)(v/vmax)^2 + s * vmax/v), s = hotel share
+class CubicFuelModel : public FuelModel {
+public:
+    explicit CubicFuelModel(double hotelShare = CUBIC_HOTEL_SHARE);
+    double perNm(const ShipTraits& traits, double speed) const override;
+    double economicalSpeed(const ShipTraits& traits) const override;
+
+private:
+    double hotel;    // s
+    double economy;  // economical speed as a fraction of maxSpeed
+};
+
+// By name: "constant" or "cubic" (throws runtime_error for anything else).
+// Models hold no state, so one can be shared by any number of worlds.
+shared_ptr<const FuelModel> makeFuelModel(const string& name);
+
+#endif //INC_74_EX3_FUELMODEL_H
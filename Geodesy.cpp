@@ -0,0 +1,209 @@
+//
+// Geodesy implementation
+//
+#include "Geodesy.h"
+#include <cmath>
+#include <initializer_list>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+const double DEG = 180.0 / M_PI;
+const double RAD = M_PI / 180.0;
+
+// atan(r) for r in [0, 1] at ATAN_STEPS + 1 evenly spaced points
+const int ATAN_STEPS = 4096;
+struct AtanTable {
+    double v[ATAN_STEPS + 1];
+    AtanTable() {
+        for (int i = 0; i <= ATAN_STEPS; ++i) v[i] = atan(static_cast<double>(i) / ATAN_STEPS);
+    }
+};
+const AtanTable ATAN_TABLE;
+
+// Above this step angle (about 344 nm) the cos/sin series is not used
+const double SERIES_LIMIT = 0.1;
+
+// cos/sin of a small angle: Taylor terms to a^7, as multiplications
+inline void seriesCosSin(double a, double& c, double& s) {
+    double a2 = a * a;
+    c = 1 - a2 * (1.0 / 2 - a2 * (1.0 / 24 - a2 * (1.0 / 720)));
+    s = a * (1 - a2 * (1.0 / 6 - a2 * (1.0 / 120 - a2 * (1.0 / 5040))));
+}
+
+UnitVector unitVector(double lon, double lat) {
+    double cl = cos(lat * RAD);
+    return UnitVector{ cl * cos(lon * RAD), cl * sin(lon * RAD), sin(lat * RAD) };
+}
+
+double dot(const UnitVector& a, const UnitVector& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// Great-circle angle between two unit vectors (stable for short and near-antipodal legs)
+double angleBetween(const UnitVector& a, const UnitVector& b) {
+    double cx = a.y * b.z - a.z * b.y;
+    double cy = a.z * b.x - a.x * b.z;
+    double cz = a.x * b.y - a.y * b.x;
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), dot(a, b));
+}
+
+// Local North / East unit vectors at (lon, lat)
+void localFrame(double lon, double lat, UnitVector& north, UnitVector& east) {
+    double so = sin(lon * RAD), co = cos(lon * RAD);
+    double sa = sin(lat * RAD), ca = cos(lat * RAD);
+    north = UnitVector{ -sa * co, -sa * so, ca };
+    east  = UnitVector{ -so, co, 0 };
+}
+
+} // namespace
+
+double distanceNm(Navigation mode, double x1, double y1, double x2, double y2) {
+    if (mode == Planar) return hypot(x2 - x1, y2 - y1);
+    return EARTH_RADIUS_NM * angleBetween(unitVector(x1, y1), unitVector(x2, y2));
+}
+
+/**
+ * Reduce to atan(r) with r = min/max in [0, 1], interpolate in the table, then
+ * unfold the octant.
+ */
+double tableAtan2(double y, double x) {
+    double ax = fabs(x), ay = fabs(y);
+    bool steep = ay > ax; // selects, not branches: octants are unpredictable
+    double lo = steep ? ax : ay, hi = steep ? ay : ax;
+    if (hi == 0) return 0;
+    double r = lo / hi * ATAN_STEPS;
+    int i = static_cast<int>(r);
+    i = i < ATAN_STEPS ? i : ATAN_STEPS - 1;
+    double a = ATAN_TABLE.v[i] + (r - i) * (ATAN_TABLE.v[i + 1] - ATAN_TABLE.v[i]);
+    a = steep ? M_PI / 2 - a : a;
+    a = x < 0 ? M_PI - a : a;
+    return copysign(a, y);
+}
+
+GeoArc GeoArc::toward(double lon, double lat, double toLon, double toLat, double& distance) {
+    GeoArc arc;
+    arc.p = unitVector(lon, lat);
+    UnitVector q = unitVector(toLon, toLat);
+    distance = EARTH_RADIUS_NM * angleBetween(arc.p, q);
+    // Direction of travel: the part of q orthogonal to p
+    double d = dot(arc.p, q);
+    UnitVector t{ q.x - d * arc.p.x, q.y - d * arc.p.y, q.z - d * arc.p.z };
+    double norm = sqrt(dot(t, t));
+    if (norm < 1e-12) {
+        UnitVector east;
+        localFrame(lon, lat, arc.t, east);
+    } else {
+        arc.t = UnitVector{ t.x / norm, t.y / norm, t.z / norm };
+    }
+    return arc;
+}
+
+GeoArc GeoArc::onHeading(double lon, double lat, double headingDeg) {
+    GeoArc arc;
+    arc.p = unitVector(lon, lat);
+    UnitVector north, east;
+    localFrame(lon, lat, north, east);
+    double c = cos(headingDeg * RAD), s = sin(headingDeg * RAD);
+    arc.t = UnitVector{ c * north.x + s * east.x, c * north.y + s * east.y, c * north.z + s * east.z };
+    return arc;
+}
+
+uint32_t ArcTable::add(const GeoArc& a) {
+    px.push_back(a.p.x); py.push_back(a.p.y); pz.push_back(a.p.z);
+    tx.push_back(a.t.x); ty.push_back(a.t.y); tz.push_back(a.t.z);
+    steps.push_back(0);
+    return static_cast<uint32_t>(steps.size() - 1);
+}
+
+void ArcTable::set(uint32_t slot, const GeoArc& a) {
+    px[slot] = a.p.x; py[slot] = a.p.y; pz[slot] = a.p.z;
+    tx[slot] = a.t.x; ty[slot] = a.t.y; tz[slot] = a.t.z;
+    steps[slot] = 0;
+}
+
+GeoArc ArcTable::get(uint32_t slot) const {
+    return GeoArc{ UnitVector{ px[slot], py[slot], pz[slot] }, UnitVector{ tx[slot], ty[slot], tz[slot] } };
+}
+
+uint32_t ArcTable::remove(uint32_t slot) {
+    uint32_t last = static_cast<uint32_t>(steps.size() - 1);
+    for (vector<double>* column : { &px, &py, &pz, &tx, &ty, &tz, &steps }) {
+        (*column)[slot] = column->back();
+        column->pop_back();
+    }
+    return last;
+}
+
+void ArcTable::rotate(size_t i, double c, double s) {
+    double x = px[i], y = py[i], z = pz[i];
+    px[i] = x * c + tx[i] * s;
+    py[i] = y * c + ty[i] * s;
+    pz[i] = z * c + tz[i] * s;
+    tx[i] = tx[i] * c - x * s;
+    ty[i] = ty[i] * c - y * s;
+    tz[i] = tz[i] * c - z * s;
+}
+
+void ArcTable::advanceOne(uint32_t slot) {
+    double a = steps[slot] * (1 / EARTH_RADIUS_NM);
+    double c, s;
+    if (fabs(a) < SERIES_LIMIT) {
+        seriesCosSin(a, c, s);
+    } else {
+        c = cos(a);
+        s = sin(a);
+    }
+    rotate(slot, c, s);
+    steps[slot] = 0;
+}
+
+/**
+ * Rotate each (p, t) by a = step / R within their plane. Steps are a fraction
+ * of a degree, where the series is exact to double precision (and still within
+ * 1e-11 at SERIES_LIMIT); the rare longer step is redone with cos/sin before
+ * the rotation. The two loops over the columns have no calls or branches, so
+ * they vectorize. Lengths of p and t may drift by rounding over many steps;
+ * the degrees do not depend on them.
+ */
+void ArcTable::advance() {
+    const size_t n = steps.size();
+    cosA.resize(n);
+    sinA.resize(n);
+    bool anyLong = false;
+    for (size_t i = 0; i < n; ++i) {
+        double a = steps[i] * (1 / EARTH_RADIUS_NM);
+        seriesCosSin(a, cosA[i], sinA[i]);
+        anyLong |= fabs(a) >= SERIES_LIMIT;
+    }
+    if (anyLong) {
+        for (size_t i = 0; i < n; ++i) {
+            double a = steps[i] * (1 / EARTH_RADIUS_NM);
+            if (fabs(a) < SERIES_LIMIT) continue;
+            cosA[i] = cos(a);
+            sinA[i] = sin(a);
+        }
+    }
+    for (size_t i = 0; i < n; ++i) rotate(i, cosA[i], sinA[i]);
+    movedSlots.clear();
+    for (size_t i = 0; i < n; ++i) {
+        if (steps[i] == 0) continue;
+        movedSlots.push_back(static_cast<uint32_t>(i));
+        steps[i] = 0;
+    }
+}
+
+void ArcTable::position(uint32_t slot, double& lon, double& lat) const {
+    double x = px[slot], y = py[slot], z = pz[slot];
+    lon = tableAtan2(y, x) * DEG;
+    lat = tableAtan2(z, sqrt(x * x + y * y)) * DEG;
+}
+
+double GeoArc::heading() const {
+    // East and North components of t, both scaled by cos(latitude)
+    double e = t.y * p.x - t.x * p.y;
+    double n = t.z * (p.x * p.x + p.y * p.y) - p.z * (t.x * p.x + t.y * p.y);
+    double h = atan2(e, n) * DEG;
+    return h < 0 ? h + 360.0 : h;
+}
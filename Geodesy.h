@@ -0,0 +1,99 @@
+//
+// Geodesy: optional great-circle navigation.
+//
+// Each world chooses its mode (see Model::setNavigation). Planar navigation
+// (the default) treats (x, y) as nautical miles on a flat plane. Geodesic navigation treats them as (longitude, latitude) in degrees on
+// a sphere of EARTH_RADIUS_NM, and ships follow great circles: to a destination
+// the shortest route, on a course the great circle leaving on that heading.
+//
+// Everything with trigonometry happens when a leg is set up (GeoArc::toward,
+// GeoArc::onHeading). The arcs of a world live in one ArcTable, column by
+// column; each hour the ships only note how far they go, and the table then
+// rotates every arc in one loop (a series for cos/sin of the small step angle,
+// no libm calls) and converts the moved ones back to degrees through a
+// lookup-table atan2.
+//
+
+#ifndef INC_74_EX3_GEODESY_H
+#define INC_74_EX3_GEODESY_H
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+enum Navigation : uint8_t { Planar, Geodesic };
+
+static const double EARTH_RADIUS_NM = 3440.065; // mean Earth radius
+
+// Distance in nm between two locations under navigation mode
+double distanceNm(Navigation mode, double x1, double y1, double x2, double y2);
+
+// atan2 from a 4096-entry table with linear interpolation (error below 5e-9 rad,
+// about 0.00002 nm on the Earth's surface)
+double tableAtan2(double y, double x);
+
+struct UnitVector {
+    double x, y, z;
+};
+
+/**
+ * A ship's great-circle motion: its position and direction of travel as two
+ * orthogonal unit vectors. Moving along the circle is a rotation of the pair.
+ */
+struct GeoArc {
+    UnitVector p; // position
+    UnitVector t; // direction of travel at p
+
+    // Arc from (lon, lat) toward (toLon, toLat); sets distance to the great-circle distance in nm.
+    // A zero-length (or antipodal) leg leaves due North.
+    static GeoArc toward(double lon, double lat, double toLon, double toLat, double& distance);
+
+    // Arc leaving (lon, lat) on a compass heading (degrees, 0 = N, 90 = E)
+    static GeoArc onHeading(double lon, double lat, double headingDeg);
+
+    // Compass heading at the current position in degrees [0, 360) (display only)
+    double heading() const;
+};
+
+/**
+ * The great-circle arcs of a world as columns (struct of arrays), kept dense:
+ * removing an arc moves the last one into its slot. A ship sets its arc up
+ * with add() or set(), notes each step with step() as it moves, and the owner
+ * calls advance() once per pass to move every noted arc at once.
+ */
+class ArcTable {
+public:
+    static const uint32_t NO_ARC = UINT32_MAX;
+
+    size_t size() const { return steps.size(); }
+    // Append a (no step pending); returns its slot
+    uint32_t add(const GeoArc& a);
+    void set(uint32_t slot, const GeoArc& a);
+    GeoArc get(uint32_t slot) const;
+    // Remove the arc in slot; the last arc moves into it. Returns the slot it moved from.
+    uint32_t remove(uint32_t slot);
+
+    // Move the arc in slot nm along its circle at the next advance()
+    void step(uint32_t slot, double nm) { steps[slot] = nm; }
+    bool stepPending(uint32_t slot) const { return steps[slot] != 0; }
+    // Take the arc in slot's pending step now, ahead of the others
+    void advanceOne(uint32_t slot);
+
+    // Move every arc by its step and clear the steps; moved() lists the slots that had one
+    void advance();
+    const vector<uint32_t>& moved() const { return movedSlots; }
+    // Current position of the arc in slot, in degrees
+    void position(uint32_t slot, double& lon, double& lat) const;
+
+private:
+    vector<double> px, py, pz; // position
+    vector<double> tx, ty, tz; // direction of travel
+    vector<double> steps;      // nm to move at the next advance(); 0 for none
+    vector<double> cosA, sinA; // scratch for advance()
+    vector<uint32_t> movedSlots;
+
+    // Rotate the arc in slot by the angle with cosine c and sine s
+    void rotate(size_t slot, double c, double s);
+};
+
+#endif //INC_74_EX3_GEODESY_H
@@ -2,131 +2,707 @@
 // Created by hadar on 25/02/2026.
 //
 #include "Model.h"
+#include "TickExport.h"
+#include "Profiler.h"
+#include "FuelModel.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #include <stdexcept>
 #include <iostream>
 using namespace std;
-// model is a singleton, so constructor is private and get() returns the single instance
-Model& Model::get() {
-    static Model instance;
-    return instance;
-}
-// Private constructor: always creates the mandatory Nagoya port
-Model::Model() : time(0) {
+// Every world starts with the mandatory Nagoya port
+Model::Model(ostream& log) : time(0), log(log), fuelModel(make_shared<ConstantFuelModel>()) {
+    shipTables.setFuelModel(*fuelModel);
+    planner.setFuelModel(*fuelModel);
     addPort("Nagoya", 50.0, 5.0, 1000000.0, 1000.0);
+    publishSnapshot();
+}
+// Ships may outlive the world (shared with a caller); they leave its tables
+Model::~Model() {
+    for (const auto& ship : ships) shipTables.detach(*ship);
 }
 //Time
 int Model::getTime() const { return time; }
+//World rules
+// Ports only hold coordinates, but a ship already moving would have to be re-aimed
+void Model::setNavigation(Navigation mode) {
+    if (!ships.empty()) throw runtime_error("navigation must be chosen before any ship is created");
+    navigation = mode;
+    shipTables.setNavigation(mode);
+    statusIndex.setNavigation(mode);
+    planner.setNavigation(mode);
+}
+Navigation Model::getNavigation() const { return navigation; }
+void Model::setFuelModel(shared_ptr<const FuelModel> model) {
+    fuelModel = move(model);
+    shipTables.setFuelModel(*fuelModel);
+    planner.setFuelModel(*fuelModel);
+}
+const FuelModel& Model::getFuelModel() const { return *fuelModel; }
 /**
  * Advance one time step:
- *   1. Update all ports (fuel production).
- *   2. Update all ships in insertion order (movement, fuel consumption).
+ *   1. Produce fuel at every port (PortEconomy: one vectorized pass).
+ *   2. Update all ships in storage order (movement, fuel consumption), then
+ *      move the ships on great-circle arcs in one pass over the arc table.
+ *   3. Record the new hour in the trajectory log and publish a snapshot.
+ *   4. Hand the snapshot to the exporter, if one is running.
+ * Voyage legs that ended during the hour are followed up before publishing.
+ * With proximity detection on, positions before and after step 2 give each
+ * ship's swept segment for the encounter search.
  */
 void Model::go() {
-    for (auto& kv : ports)
-        kv.second->update();
-    for (const auto& name : shipOrder) {
-        if (freighters.count(name))
-            freighters.at(name)->update();
-        else if (patrols.count(name))
-            patrols.at(name)->update();
-        else if (cruisers.count(name))
-            cruisers.at(name)->update();
+    TickProfiler* prof = profiler.get();
+    if (prof) prof->beginTick();
+    economy.produce();
+    if (prof) prof->mark(PhasePorts, ports.size());
+    const bool tracking = trajectories.enabled();
+    if (tracking) trajectories.beginTick(time + 1);
+    if (proximity.enabled()) proximity.begin(ships);
+    // Ships on great-circle arcs reach their new positions only in advanceArcs()
+    const bool recordAfter = tracking && (substeps > 1 || navigation == Geodesic);
+    if (substeps > 1) {
+        advanceShipsSubstepped();
+        if (prof) prof->mark(PhaseSubstepped, ships.size());
+    } else if (prof) {
+        updateShipsProfiled(*prof, tracking && !recordAfter);
+    } else {
+        for (size_t i = 0; i < ships.size(); ++i) {
+            ships[i]->update(log);
+            if (tracking && !recordAfter) trajectories.record(i, *ships[i]); // while the ship is still in cache
+        }
     }
+    shipTables.advanceArcs();
+    if (recordAfter)
+        for (size_t i = 0; i < ships.size(); ++i) trajectories.record(i, *ships[i]);
+    if (proximity.enabled()) proximity.finish(ships, shipSeq, time, encounters);
     ++time;
+    if (tracking) trajectories.publish(time);
+    if (!voyages.empty()) advanceVoyages();
+    shared_ptr<const ModelSnapshot> tick = publishSnapshot();
+    if (exporter) exporter->append(move(tick));
+    if (prof) prof->mark(PhaseBookkeeping, ships.size());
+}
+void Model::updateShipsProfiled(TickProfiler& prof, bool tracking) {
+    const size_t n = ships.size();
+    for (size_t i = 0; i < n;) {
+        const ShipType type = ships[i]->getType();
+        const size_t first = i;
+        for (; i < n && ships[i]->getType() == type; ++i) {
+            ships[i]->update(log);
+            if (tracking) trajectories.record(i, *ships[i]);
+        }
+        prof.mark(TickProfiler::phaseOf(type), i - first);
+    }
+}
+//--Snapshots--
+// Rebuild records chunk by chunk; untouched and unchanged chunks are shared with the previous epoch
+shared_ptr<const ModelSnapshot> Model::publishSnapshot() {
+    shared_ptr<const ModelSnapshot> prev = atomic_load(&snapshot);
+    // Epochs nobody reads any more give their chunks back before any are taken
+    snapshotPool.forEachFree([](ModelSnapshot& old) {
+        old.ports.clear();
+        old.ships.clear();
+    });
+    shared_ptr<ModelSnapshot> next = snapshotPool.take();
+    next->epoch = prev ? prev->epoch + 1 : 0;
+    next->time  = time;
+    next->ports.build(portOrder.size(), prev ? &prev->ports : nullptr, portChunks,
+                      [this](size_t i, PortRecord& r) {
+        const Port& p = *ports[portOrder[i]];
+        Location loc = p.getLocation();
+        r.name = p.getNameId();
+        r.x    = loc.first;
+        r.y    = loc.second;
+        r.fuel = p.getFuel();
+    });
+    const vector<uint32_t>& order = creationOrder();
+    next->ships.build(ships.size(), prev ? &prev->ships : nullptr, shipChunks,
+                      [this, &order](size_t i, ShipRecord& r) {
+        const Ship& s = *ships[order[i]];
+        r.name       = s.getNameId();
+        r.type       = s.getType();
+        r.state      = s.getState();
+        r.attackStat = s.getAttackStat();
+        r.containers = s.getType() == FreighterType ? static_cast<const Freighter&>(s).getContainers() : 0;
+        r.x          = s.getCorX();
+        r.y          = s.getCorY();
+        r.fuel       = s.getFuel();
+    }, [this](size_t c) { return shipTables.chunkChanged(c); });
+    shipTables.published(order);
+    shared_ptr<const ModelSnapshot> published = next;
+    atomic_store(&snapshot, published);
+    return published;
+}
+shared_ptr<const ModelSnapshot> Model::getSnapshot() const {
+    return atomic_load(&snapshot);
+}
+//--Name directory--
+const Model::Slot* Model::findSlot(NameId id) const {
+    auto it = slots.find(id);
+    return it == slots.end() ? nullptr : &it->second;
+}
+// Intern the name and point its slot at (kind, index); throws if the name is taken
+NameId Model::registerName(const string& name, ObjKind kind, uint32_t index) {
+    NameId id = NameTable::get().intern(name);
+    if (findSlot(id))
+        throw runtime_error("Name already exists: " + name);
+    slots[id] = Slot{ kind, index, nextGeneration++ };
+    return id;
+}
+vector<uint32_t>::iterator Model::portPosition(const string& name) {
+    return lower_bound(portOrder.begin(), portOrder.end(), name,
+                       [this](uint32_t i, const string& n) { return ports[i]->getName() < n; });
 }
 //--Object creation--
 // add new port with the given name, position, initial fuel, and fuel production rate
 void Model::addPort(const string& name, double x, double y,
-                    double initialFuel, double fuelRate) {
-    if (nameExists(name))
-        throw runtime_error("Name already exists: " + name);
-    ports[name] = make_shared<Port>(name, x, y, initialFuel, fuelRate);
+                    double initialFuel, double fuelRate, double capacity) {
+    if (initialFuel > capacity) throw runtime_error("initial fuel exceeds the storage capacity of " + name);
+    uint32_t index = static_cast<uint32_t>(ports.size());
+    registerName(name, PortKind, index);
+    uint32_t row = economy.add(initialFuel, fuelRate, capacity);
+    ports.push_back(make_shared<Port>(name, x, y, economy, row));
+    portOrder.insert(portPosition(name), index); // keep portOrder sorted by name
+    planner.addPort(ports.back()->getNameId(), ports.back()->getLocation());
+}
+template <class Kind, class... Args>
+void Model::createShip(const string& name, Args&&... args) {
+    registerName(name, shipKind(Kind::Traits::type), static_cast<uint32_t>(ships.size()));
+    appendShip(make_shared<Kind>(name, forward<Args>(args)...));
 }
 // add new freighter with the given name, starting position, resistance stat, and container capacity
 void Model::addFreighter(const string& name, double x, double y,
                          int resistance, int maxContainers) {
-    if (nameExists(name))
-        throw runtime_error("Name already exists: " + name);
-    freighters[name] = make_shared<Freighter>(name, x, y, resistance, maxContainers);
-    shipOrder.push_back(name);
+    createShip<Freighter>(name, x, y, resistance, maxContainers);
 }
 // add a patrol boat with the given name, starting position, and resistance stat
 void Model::addPatrol(const string& name, double x, double y, int resistance) {
-    if (nameExists(name))
-        throw runtime_error("Name already exists: " + name);
-    patrols[name] = make_shared<Patrol>(name, x, y, resistance);
-    shipOrder.push_back(name);
+    createShip<Patrol>(name, x, y, resistance);
 }
 // add a cruiser with the given name, starting position, attack force, and attack range
 void Model::addCruiser(const string& name, double x, double y,
                        int force, int attackRange) {
-    if (nameExists(name))
-        throw runtime_error("Name already exists: " + name);
-    cruisers[name] = make_shared<Cruiser>(name, x, y, force, attackRange);
-    shipOrder.push_back(name);
+    createShip<Cruiser>(name, x, y, force, attackRange);
+}
+void Model::appendShip(shared_ptr<Ship> ship) {
+    if (!shipOrderStale) shipOrder.push_back(static_cast<uint32_t>(ships.size()));
+    ships.push_back(move(ship));
+    shipSeq.push_back(nextSeq++);
+    uint32_t index = static_cast<uint32_t>(ships.size() - 1);
+    shipTables.addShip(*ships.back(), index);
+    trajectories.addShip(*ships.back(), time);
+    statusIndex.addShip(index, *ships.back(), shipSeq.back());
+}
+//--Removal--
+void Model::remove(const string& name) {
+    NameId id = NameTable::get().find(name);
+    if (!findSlot(id)) throw runtime_error("No object named: " + name);
+    if (id == ports.front()->getNameId()) throw runtime_error("Nagoya cannot be removed");
+    if (findSlot(id)->kind == PortKind) removePort(id);
+    else                            removeShip(id);
+}
+bool Model::remove(ObjectHandle handle) {
+    if (!getShip(handle) && !getPort(handle)) return false;
+    remove(NameTable::get().str(handle.id));
+    return true;
+}
+/**
+ * Swap-remove: the last ship takes the removed one's index, in every array
+ * indexed like ships (its slot, sequence number, side tables, trajectory ring
+ * and status index entries follow it).
+ */
+void Model::removeShip(NameId id) {
+    uint32_t index = findSlot(id)->index;
+    uint32_t last  = static_cast<uint32_t>(ships.size() - 1);
+    shipTables.removeShip(*ships[index], ships[last].get());
+    statusIndex.removeShip(index);
+    if (index != last) {
+        ships[index]   = move(ships[last]);
+        shipSeq[index] = shipSeq[last];
+        slots[ships[index]->getNameId()].index = index;
+    }
+    ships.pop_back();
+    shipSeq.pop_back();
+    trajectories.removeShip(index);
+    targetsByX.clear(); // holds ship indices; rebuilt on the next sub-stepped tick
+    shipOrderStale = true;
+    slots.erase(id);
+}
+/**
+ * Swap-remove, like ships: the last port takes the removed one's index and
+ * economy row. portOrder (the name order) loses the port's entry and points
+ * the moved port's entry at its new index.
+ */
+void Model::removePort(NameId id) {
+    uint32_t index = findSlot(id)->index;
+    uint32_t last  = static_cast<uint32_t>(ports.size() - 1);
+    ports[index]->detach(); // whoever still holds it must not read the row's next owner
+    economy.erase(index);
+    portOrder.erase(portPosition(ports[index]->getName()));
+    if (index != last) {
+        *portPosition(ports[last]->getName()) = index;
+        ports[index] = move(ports[last]);
+        ports[index]->row = index;
+        slots[ports[index]->getNameId()].index = index;
+    }
+    ports.pop_back();
+    slots.erase(id);
+    for (const auto& ship : ships) { // nothing may name the port any more
+        if (ship->getDestPort() == id) ship->forgetDestPort();
+        if (ship->getType() != FreighterType) continue;
+        Freighter& f = static_cast<Freighter&>(*ship);
+        if (f.getLoadPort() == id) f.clearLoadPort();
+        if (f.getUnloadPort() == id) f.clearUnloadPort();
+    }
+    router.forgetPort(id);
+    planner.removePort(id);
+}
+ObjectHandle Model::getHandle(NameId id) const {
+    const Slot* slot = findSlot(id);
+    if (!slot) throw runtime_error("No object named: " + NameTable::get().str(id));
+    return ObjectHandle{ id, slot->generation };
+}
+shared_ptr<Ship> Model::getShip(ObjectHandle handle) const {
+    const Slot* slot = findSlot(handle.id);
+    if (!slot || slot->kind == PortKind || slot->generation != handle.generation) return nullptr;
+    return ships[slot->index];
+}
+shared_ptr<Port> Model::getPort(ObjectHandle handle) const {
+    const Slot* slot = findSlot(handle.id);
+    if (!slot || slot->kind != PortKind || slot->generation != handle.generation) return nullptr;
+    return ports[slot->index];
+}
+const vector<uint32_t>& Model::creationOrder() const {
+    if (shipOrderStale) {
+        shipOrder.resize(ships.size());
+        for (uint32_t i = 0; i < shipOrder.size(); ++i) shipOrder[i] = i;
+        sort(shipOrder.begin(), shipOrder.end(), [this](uint32_t a, uint32_t b) { return shipSeq[a] < shipSeq[b]; });
+        shipOrderStale = false;
+    }
+    return shipOrder;
+}
+//--Sub-stepping--
+void Model::setSubsteps(int n) {
+    if (n < 1) throw runtime_error("sub-steps per hour must be at least 1");
+    substeps = n;
+}
+int Model::getSubsteps() const { return substeps; }
+
+/**
+ * One hour with sub-steps where they matter:
+ *   1. Broad phase: freighters/patrol boats sorted by x (kept from the last
+ *      hour and insertion-sorted, since ships usually move past few others per
+ *      hour; a full sort takes over when that is not so); every moving cruiser
+ *      scans the x-window it could cover this hour and keeps targets whose
+ *      distance could shrink into attack range (targets already in range are
+ *      left alone, so a pair is reported once as it closes, not every hour).
+ *   2. Each pursuit needs enough sub-steps that the pair closes at most half
+ *      the attack range per step; the hour uses the largest such count
+ *      (capped at substeps) for every ship in a pursuit.
+ *   3. Everyone else advances one whole hour; pursuit ships advance in
+ *      sub-steps, tracking how close each pair gets.
+ *   4. Pairs that came into attack range are reported with their closest
+ *      approach. Cruisers keep their course: no command asked them to stop.
+ */
+void Model::advanceShipsSubstepped() {
+    auto isUnderway = [](const Ship& s) { return s.getState() == Moving || s.getState() == Course; };
+
+    // 1. Broad phase
+    pursuits.clear();
+    fineStep.assign(ships.size(), 0);
+    double maxTargetSpeed = 0;
+    bool anyHunter = false;
+    size_t targets = 0;
+    for (uint32_t i = 0; i < ships.size(); ++i) {
+        const Ship& s = *ships[i];
+        if (s.getType() == CruiserType) { anyHunter = anyHunter || isUnderway(s); continue; }
+        ++targets;
+        if (isUnderway(s)) maxTargetSpeed = max(maxTargetSpeed, s.getSpeed());
+    }
+    int fineK = 1;
+    if (anyHunter) {
+        auto byX = [](const XKey& a, const XKey& b) { return a.x < b.x; };
+        if (targetsByX.size() != targets) { // ships were added: rebuild the list
+            targetsByX.clear();
+            for (uint32_t i = 0; i < ships.size(); ++i)
+                if (ships[i]->getType() != CruiserType) targetsByX.push_back(XKey{ships[i]->getCorX(), i});
+            sort(targetsByX.begin(), targetsByX.end(), byX);
+        } else {
+            for (XKey& k : targetsByX) k.x = ships[k.index]->getCorX();
+            size_t budget = 8 * targetsByX.size(); // moves before giving up on insertion sort
+            for (size_t i = 1; i < targetsByX.size() && budget > 0; ++i) {
+                XKey k = targetsByX[i];
+                size_t j = i;
+                for (; j > 0 && targetsByX[j - 1].x > k.x && budget > 0; --j, --budget)
+                    targetsByX[j] = targetsByX[j - 1];
+                targetsByX[j] = k;
+            }
+            if (budget == 0) sort(targetsByX.begin(), targetsByX.end(), byX);
+        }
+        for (uint32_t c = 0; c < ships.size(); ++c) {
+            const Ship& hunter = *ships[c];
+            if (hunter.getType() != CruiserType || !isUnderway(hunter)) continue;
+            double range = static_cast<const Cruiser&>(hunter).getAttackRange();
+            double cx = hunter.getCorX(), cy = hunter.getCorY(), vc = hunter.getSpeed();
+            double reach = range + vc + maxTargetSpeed;
+            // Under Geodesic navigation x is longitude, which wraps and has no fixed
+            // length in nm, so every target is a candidate there
+            double lo = cx - reach, hi = cx + reach;
+            if (navigation == Geodesic) lo = -HUGE_VAL, hi = HUGE_VAL;
+            auto it = lower_bound(targetsByX.begin(), targetsByX.end(), lo,
+                                  [](const XKey& k, double x) { return k.x < x; });
+            double closing = 0;
+            for (; it != targetsByX.end() && it->x <= hi; ++it) {
+                const Ship& t = *ships[it->index];
+                double vt = isUnderway(t) ? t.getSpeed() : 0;
+                double d = distanceNm(navigation, cx, cy, t.getCorX(), t.getCorY());
+                if (d <= range || d > range + vc + vt) continue;
+                pursuits.push_back(Pursuit{c, it->index, HUGE_VAL});
+                fineStep[it->index] = 1;
+                closing = max(closing, vc + vt);
+            }
+            if (closing == 0) continue;
+            fineStep[c] = 1;
+            // 2. sub-steps so the pair closes at most range/2 per step
+            int k = range > 0 ? static_cast<int>(ceil(closing / (range / 2))) : substeps;
+            fineK = max(fineK, min(max(k, 2), substeps));
+        }
+    }
+
+    // 3. Whole-hour ships, then the pursuits in sub-steps
+    fineShips.clear();
+    for (uint32_t i = 0; i < ships.size(); ++i) {
+        if (fineStep[i]) fineShips.push_back(i);
+        else             ships[i]->advance(1.0, log);
+    }
+    if (fineShips.empty()) return;
+    double dt = 1.0 / fineK;
+    for (int step = 0; step < fineK; ++step) {
+        for (uint32_t i : fineShips) ships[i]->advance(dt, log);
+        shipTables.advanceArcs();
+        for (Pursuit& p : pursuits) {
+            const Ship& hunter = *ships[p.cruiser], & t = *ships[p.target];
+            p.closest = min(p.closest, distanceNm(navigation, hunter.getCorX(), hunter.getCorY(), t.getCorX(), t.getCorY()));
+        }
+    }
+    // 4. Report the pairs that came into attack range (grouped by cruiser, in insertion order)
+    for (const Pursuit& p : pursuits) {
+        const Ship& hunter = *ships[p.cruiser];
+        if (p.closest > static_cast<const Cruiser&>(hunter).getAttackRange()) continue;
+        log << hunter.getName() << " comes within " << round(p.closest * 100) / 100 << " nm of "
+            << ships[p.target]->getName() << ".\n";
+    }
+}
+//--Proximity--
+void Model::setProximityThreshold(double nm) {
+    proximity.setThreshold(nm);
+    encounters.clear();
+}
+double Model::getProximityThreshold() const { return proximity.getThreshold(); }
+const vector<Encounter>& Model::getEncounters() const { return encounters; }
+//--Routing--
+void Model::setObstacles(vector<Polygon> polygons) {
+    router.setObstacles(move(polygons));
+    planner.invalidate();
+}
+const Router& Model::getRouter() const { return router; }
+
+void Model::sendShip(Ship& ship, double x, double y, double speed, NameId port) {
+    if (!router.enabled()) {
+        if (port != NO_NAME) ship.setPortDestination(x, y, speed, port);
+        else                 ship.setDestination(x, y, speed);
+        return;
+    }
+    Location from = ship.getLocation(), to{x, y};
+    shared_ptr<Port> origin = port != NO_NAME ? getPortAt(from.first, from.second) : nullptr;
+    shared_ptr<const Route> route = origin ? router.portRoute(origin->getNameId(), from, port, to)
+                                           : router.route(from, to);
+    if (!route) throw runtime_error("no sea route to the destination");
+    ship.setRoute(move(route), speed, port);
+}
+//--Voyages--
+shared_ptr<const VoyagePlan> Model::planVoyage(const Ship& ship, NameId port, double hours) {
+    return planVoyage(ship, port, hours, 0);
+}
+
+// extra: fuel the ship will take on at its port before sailing
+shared_ptr<const VoyagePlan> Model::planVoyage(const Ship& ship, NameId port, double hours, double extra) {
+    if (ship.getMaxFuel() <= 0) throw runtime_error("fuel is not simulated for " + ship.getName());
+    shared_ptr<Port> origin = getPortAt(ship.getCorX(), ship.getCorY());
+    if (origin && origin->getNameId() == port) throw runtime_error("already at " + origin->getName());
+    return planner.plan(ship.getType(), ship.getLocation(), origin ? origin->getNameId() : NO_NAME,
+                        ship.getFuel() + extra, port, hours);
+}
+
+shared_ptr<const VoyagePlan> Model::startVoyage(Freighter& ship, NameId port, double hours) {
+    shared_ptr<Port> origin = getPortAt(ship.getCorX(), ship.getCorY());
+    double topUp = origin ? min(origin->getFuel(), ship.getMaxFuel() - ship.getFuel()) : 0;
+    shared_ptr<const VoyagePlan> plan = planVoyage(ship, port, hours, topUp);
+    if (!plan) throw runtime_error("no voyage reaches " + NameTable::get().str(port) + " in time");
+    if (topUp > 0) ship.refuel(origin->dispenseFuel(topUp));
+    const VoyageLeg& leg = plan->legs.front();
+    Location to = getPort(leg.port)->getLocation();
+    sendShip(ship, to.first, to.second, leg.speed, leg.port);
+    voyages.erase(remove_if(voyages.begin(), voyages.end(),
+                            [&ship](const Voyage& v) { return v.ship.id == ship.getNameId(); }),
+                  voyages.end());
+    voyages.push_back(Voyage{ getHandle(ship.getNameId()), port, time + hours, plan });
+    return plan;
+}
+
+const VoyagePlanner& Model::getPlanner() const { return planner; }
+
+// Kept in place, in order; finished and abandoned voyages are dropped
+void Model::advanceVoyages() {
+    size_t kept = 0;
+    for (size_t i = 0; i < voyages.size(); ++i) {
+        Voyage& v = voyages[i];
+        shared_ptr<Ship> sailing = getShip(v.ship);
+        if (!sailing) continue; // removed
+        Ship& ship = *sailing;
+        const VoyageLeg& leg = v.plan->legs.front();
+        if (ship.getState() != Moving || ship.getDestPort() != leg.port) continue; // other orders, out of fuel, port removed
+        if (ship.hasArrived()) {
+            ship.changeState(Docked);
+            if (v.plan->legs.size() == 1) continue; // at the destination
+            // Refuel stop: fill up with what the port has, then replan the rest from here
+            Port& stop = *ports[findSlot(leg.port)->index];
+            ship.refuel(stop.dispenseFuel(ship.getMaxFuel() - ship.getFuel()));
+            shared_ptr<const VoyagePlan> rest = planner.plan(ship.getType(), ship.getLocation(), leg.port,
+                                                             ship.getFuel(), v.port, v.deadline - time);
+            if (!rest) {
+                log << ship.getName() << " cannot reach " << NameTable::get().str(v.port)
+                     << " in time and waits at " << stop.getName() << ".\n";
+                continue;
+            }
+            v.plan = move(rest);
+            Location to = ports[findSlot(v.plan->legs[0].port)->index]->getLocation();
+            sendShip(ship, to.first, to.second, v.plan->legs[0].speed, v.plan->legs[0].port);
+        }
+        if (kept != i) voyages[kept] = move(v);
+        ++kept;
+    }
+    voyages.resize(kept);
+}
+//--Port economy--
+/**
+ * Arrivals: every freighter or patrol boat sailing to a port, at the hour its
+ * distance to go and speed give, wanting its tank's empty space after the
+ * fuel that distance burns (ships that would run dry first never arrive).
+ * A freighter on a voyage also arrives at its later stops, as planned: it
+ * leaves each stop with a full tank once the hour it arrived in is over.
+ */
+vector<PortForecast> Model::forecastPorts(size_t limit) const {
+    auto hoursUntil = [](double eta) { return eta < INT_MAX ? static_cast<int>(ceil(eta)) : INT_MAX; };
+    arrivals.clear();
+    for (const auto& sp : ships) {
+        const Ship& ship = *sp;
+        if (ship.getType() == CruiserType || ship.getState() != Moving || ship.getMaxFuel() <= 0) continue;
+        const Slot* port = findSlot(ship.getDestPort());
+        if (!port || port->kind != PortKind || ship.getSpeed() <= 0) continue;
+        double distance = ship.distanceToGo();
+        double burn = distance * fuelModel->perNm(SHIP_TRAITS[ship.getType()], ship.getSpeed());
+        if (burn > ship.getFuel()) continue;
+        double eta = distance / ship.getSpeed();
+        arrivals.push_back(PortArrival{ port->index, hoursUntil(eta), eta, ship.getMaxFuel() - (ship.getFuel() - burn) });
+    }
+    for (const Voyage& v : voyages) {
+        shared_ptr<Ship> ship = getShip(v.ship);
+        if (!ship || ship->getState() != Moving || ship->getDestPort() != v.plan->legs[0].port) continue;
+        if (ship->getSpeed() <= 0) continue;
+        double eta = ship->distanceToGo() / ship->getSpeed();
+        for (size_t k = 1; k < v.plan->legs.size(); ++k) {
+            const VoyageLeg& leg = v.plan->legs[k];
+            const Slot* port = findSlot(leg.port);
+            if (!port || port->kind != PortKind) break;
+            eta = ceil(eta) + leg.distance / leg.speed; // sails on the hour after it reached the stop
+            arrivals.push_back(PortArrival{ port->index, hoursUntil(eta), eta, leg.fuel });
+        }
+    }
+    economy.forecast(arrivals, outlooks);
+
+    // Name rank breaks ties, so equal outlooks list in name order
+    vector<uint32_t> rank(ports.size());
+    for (uint32_t r = 0; r < portOrder.size(); ++r) rank[portOrder[r]] = r;
+    auto before = [&rank](const PortOutlook& a, const PortOutlook& b) {
+        if (a.shortfall != b.shortfall) return a.shortfall > b.shortfall;
+        if (a.demand != b.demand) return a.demand > b.demand;
+        return rank[a.row] < rank[b.row];
+    };
+    size_t shown = limit > 0 ? min(limit, outlooks.size()) : outlooks.size();
+    partial_sort(outlooks.begin(), outlooks.begin() + shown, outlooks.end(), before);
+    vector<PortForecast> result;
+    result.reserve(shown);
+    for (size_t i = 0; i < shown; ++i) result.push_back(PortForecast{ ports[outlooks[i].row], outlooks[i] });
+    return result;
+}
+//--Export--
+void Model::startExport(const string& path) {
+    stopExport();
+    exporter.reset(new TickExporter(path));
+    exporter->append(getSnapshot()); // starting state
+}
+bool Model::stopExport() {
+    if (!exporter) return true;
+    bool ok = exporter->finish();
+    exporter.reset();
+    return ok;
+}
+bool Model::isExporting() const { return exporter != nullptr; }
+//--Profiling--
+void Model::startProfiling() { profiler.reset(new TickProfiler()); }
+void Model::stopProfiling() { profiler.reset(); }
+TickProfiler* Model::getProfiler() const { return profiler.get(); }
+//--Combat--
+void Model::setCombat(CombatMode mode) { combat = mode; }
+CombatMode Model::getCombat() const { return combat; }
+void Model::seed(uint64_t value) { rng = CombatRng(value); }
+const CombatTally& Model::getCombatTally() const { return tally; }
+
+bool Model::attack(Cruiser& cruiser, Ship& target) {
+    int force = cruiser.getAttackStat(), resistance = target.getAttackStat();
+    bool victory = combat == StochasticCombat ? rng.uniform() < winProbability(force, resistance)
+                                              : force > resistance;
+    int cargo = target.getType() == FreighterType ? static_cast<Freighter&>(target).getContainers() : 0;
+    cruiser.attack(&target, victory);
+    ++tally.attacks;
+    if (victory) {
+        ++tally.victories;
+        if (target.getType() == FreighterType)
+            tally.containersLost += cargo - static_cast<Freighter&>(target).getContainers();
+    }
+    return victory;
+}
+//--Trajectories--
+// Restart the log at the current hour; every existing ship gets a fresh ring
+void Model::setTrackDepth(size_t hours) {
+    trajectories.reset(hours, time);
+    for (const auto& ship : ships)
+        trajectories.addShip(*ship, time);
+}
+size_t Model::getTrackDepth() const { return trajectories.getDepth(); }
+
+void Model::getTrack(NameId ship, size_t count, vector<int>& times, vector<TrackPoint>& points) const {
+    const Slot* slot = findSlot(ship);
+    if (!slot || slot->kind == PortKind)
+        throw runtime_error("No ship named: " + NameTable::get().str(ship));
+    trajectories.history(slot->index, count, times, points);
 }
 
 // Typed lookup
-// Returns a pointer to the object with the given name and type, or throws if not found, separated by specific type for better clarity.
+// Names are resolved to IDs once, then the slot gives the object directly.
 shared_ptr<Port> Model::getPort(const string& name) const {
-    auto it = ports.find(name);
-    if (it == ports.end())
+    const Slot* slot = findSlot(NameTable::get().find(name));
+    if (!slot || slot->kind != PortKind)
         throw runtime_error("No port named: " + name);
-    return it->second;
+    return ports[slot->index];
+}
+shared_ptr<Ship> Model::getShipOfKind(const string& name, ShipType type, const string& what) const {
+    const Slot* slot = findSlot(NameTable::get().find(name));
+    if (!slot || slot->kind != shipKind(type))
+        throw runtime_error("No " + what + " named: " + name);
+    return ships[slot->index];
 }
 shared_ptr<Freighter> Model::getFreighter(const string& name) const {
-    auto it = freighters.find(name);
-    if (it == freighters.end())
-        throw runtime_error("No freighter named: " + name);
-    return it->second;
+    return static_pointer_cast<Freighter>(getShipOfKind(name, FreighterType, "freighter"));
 }
 shared_ptr<Patrol> Model::getPatrol(const string& name) const {
-    auto it = patrols.find(name);
-    if (it == patrols.end())
-        throw runtime_error("No patrol boat named: " + name);
-    return it->second;
+    return static_pointer_cast<Patrol>(getShipOfKind(name, PatrolType, "patrol boat"));
 }
 shared_ptr<Cruiser> Model::getCruiser(const string& name) const {
-    auto it = cruisers.find(name);
-    if (it == cruisers.end())
-        throw runtime_error("No cruiser named: " + name);
-    return it->second;
+    return static_pointer_cast<Cruiser>(getShipOfKind(name, CruiserType, "cruiser"));
 }
 shared_ptr<Ship> Model::getShip(const string& name) const {
-    if (freighters.count(name)) return freighters.at(name);
-    if (patrols.count(name))    return patrols.at(name);
-    if (cruisers.count(name))   return cruisers.at(name);
-    throw runtime_error("No ship named: " + name);
+    NameId id = NameTable::get().find(name);
+    if (!shipExists(id))
+        throw runtime_error("No ship named: " + name);
+    return ships[findSlot(id)->index];
+}
+shared_ptr<Port> Model::getPort(NameId id) const {
+    if (!portExists(id))
+        throw runtime_error("No port named: " + NameTable::get().str(id));
+    return ports[findSlot(id)->index];
+}
+shared_ptr<Ship> Model::getShip(NameId id) const {
+    if (!shipExists(id))
+        throw runtime_error("No ship named: " + NameTable::get().str(id));
+    return ships[findSlot(id)->index];
+}
+// Port at exactly (x, y): a docked ship sits on its port's coordinates
+shared_ptr<Port> Model::getPortAt(double x, double y) const {
+    for (uint32_t i : portOrder) {
+        Location loc = ports[i]->getLocation();
+        if (loc.first == x && loc.second == y) return ports[i];
+    }
+    return nullptr;
 }
 // Returns true if any object (ship or port) has this name
 bool Model::nameExists(const string& name) const {
-    return ports.count(name) || freighters.count(name)
-        || patrols.count(name) || cruisers.count(name);
+    return findSlot(NameTable::get().find(name)) != nullptr;
 }
 // Returns true if a ship (any type) has this name
 bool Model::shipExists(const string& name) const {
-    return freighters.count(name) || patrols.count(name) || cruisers.count(name);
+    return shipExists(NameTable::get().find(name));
+}
+bool Model::shipExists(NameId id) const {
+    const Slot* slot = findSlot(id);
+    return slot && slot->kind != PortKind;
+}
+bool Model::portExists(NameId id) const {
+    const Slot* slot = findSlot(id);
+    return slot && slot->kind == PortKind;
 }
 // View support
 // Returns all objects; View iterates to place 2-char labels on the map
 vector<shared_ptr<Sim_object>> Model::getAllObjects() const {
     vector<shared_ptr<Sim_object>> result;
-    for (auto& kv : ports)      result.push_back(kv.second);
-    for (auto& kv : freighters) result.push_back(kv.second);
-    for (auto& kv : patrols)    result.push_back(kv.second);
-    for (auto& kv : cruisers)   result.push_back(kv.second);
+    result.reserve(ports.size() + ships.size());
+    for (uint32_t i : portOrder) result.push_back(ports[i]);
+
+    // ships grouped by type, then by name (matches the map output order users know)
+    vector<uint32_t> order(ships.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        ObjKind ka = findSlot(ships[a]->getNameId())->kind;
+        ObjKind kb = findSlot(ships[b]->getNameId())->kind;
+        if (ka != kb) return ka < kb;
+        return ships[a]->getName() < ships[b]->getName();
+    });
+    for (uint32_t i : order) result.push_back(ships[i]);
+    return result;
+}
+// Same order as printStatus(): ports by name, then ships by insertion
+vector<shared_ptr<Sim_object>> Model::getStatusOrder() const {
+    vector<shared_ptr<Sim_object>> result;
+    result.reserve(ports.size() + ships.size());
+    for (uint32_t i : portOrder) result.push_back(ports[i]);
+    for (uint32_t i : creationOrder()) result.push_back(ships[i]);
     return result;
 }
 // Status
-void Model::printStatus() const {
-    for (auto& kv : ports)
-        kv.second->printStatus();
-    for (const auto& name : shipOrder) {
-        if (freighters.count(name))
-            freighters.at(name)->printStatus();
-        else if (patrols.count(name))
-            patrols.at(name)->printStatus();
-        else if (cruisers.count(name))
-            cruisers.at(name)->printStatus();
+void Model::printStatus(ostream& out) const {
+    for (uint32_t i : portOrder)
+        ports[i]->printStatus(out);
+    for (uint32_t i : creationOrder())
+        ships[i]->printStatus(out);
+}
+
+// Build the indexes on the first query; later, fold in the ships queued since the last one
+StatusPage Model::queryStatus(const StatusQuery& query) const {
+    if (!statusIndex.isBuilt()) {
+        statusIndex.build(ships, shipSeq);
+        shipTables.watch(&statusIndex);
     }
+    for (NameId id : statusIndex.getPending()) {
+        const Slot* slot = findSlot(id);
+        if (slot && slot->kind != PortKind) statusIndex.refresh(slot->index, *ships[slot->index]);
+    }
+    statusIndex.clearPending();
+
+    StatusPage page;
+    statusIndex.query(query, statusPage, page.matches);
+    page.ships.reserve(statusPage.size());
+    for (uint32_t i : statusPage) page.ships.push_back(ships[i]);
+    return page;
 }
@@ -1,29 +1,67 @@
 //
-// Model: Singleton that owns all simulation objects (ports and ships).
+// Model: one simulated world, owning all its objects (ports and ships).
 // Responsible for time advancement, object creation/lookup, and view support.
 //
 
 #ifndef INC_74_EX3_MODEL_H
 #define INC_74_EX3_MODEL_H
 
-#include <map>
+#include <cstdint>
+#include <iostream>
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include "Port.h"
+#include "PortEconomy.h"
 #include "Freighter.h"
 #include "Patrol.h"
 #include "Cruiser.h"
+#include "ModelSnapshot.h"
+#include "TrajectoryLog.h"
+#include "Proximity.h"
+#include "VoyagePlanner.h"
+#include "Combat.h"
+#include "StatusIndex.h"
 using namespace std;
 
+class FuelModel;
+class TickExporter;
+class TickProfiler;
+
 /**
- * Model (Singleton): sole owner of all simulation objects.
- * Access via Model::get().
+ * A reference to a ship or port that notices removal: it stays valid only as
+ * long as the object it was taken from exists, even if a new object later
+ * takes the same name.
+ */
+struct ObjectHandle {
+    NameId   id         = NO_NAME;
+    uint32_t generation = 0;
+};
+
+// A port and its fuel outlook (see Model::forecastPorts)
+struct PortForecast {
+    shared_ptr<Port> port;
+    PortOutlook      outlook;
+};
+
+// One page of a status query's answer (see Model::queryStatus)
+struct StatusPage {
+    vector<shared_ptr<Ship>> ships;   // in query order
+    size_t                   matches = 0; // ships matching in all
+};
+
+/**
+ * Model: sole owner of a world's simulation objects. Worlds are independent of
+ * each other, so several can run at once, each on one thread at a time (see
+ * ScenarioRunner.h); all they share is the process-wide interned names, which
+ * are safe to read and add from any thread.
  */
 class Model {
 public:
-    // Singleton access
-    static Model& get();
+    // A new world at time 0 with the mandatory Nagoya port; events of its ticks are reported to log
+    explicit Model(ostream& log = cout);
+    ~Model();
 
     // Non-copyable
     Model(const Model&)            = delete;
@@ -32,17 +70,136 @@ public:
     // Time
     int getTime() const;
 
+    // World geometry (see Geodesy.h), Planar by default: choose it before the first
+    // ship is created (throws runtime_error once there is one)
+    void setNavigation(Navigation mode);
+    Navigation getNavigation() const;
+
+    // Fuel burn of the world's ships and voyage plans (see FuelModel.h), constant by default
+    void setFuelModel(shared_ptr<const FuelModel> model);
+    const FuelModel& getFuelModel() const;
+
     /**
      * Advance simulation by one hour:
-     *   1. Update all ports (fuel production).
-     *   2. Update all ships in insertion order (movement, fuel consumption).
+     *   1. Produce fuel at every port (one pass over the port economy).
+     *   2. Update all ships in storage order (movement, fuel consumption):
+     *      creation order, except where removals swapped ships around.
      *   3. Increment the time counter.
+     *   4. Record every ship's trajectory sample for the new hour and, if
+     *      proximity detection is on, the encounters of the hour.
+     *   5. Move freighters on planned voyages to their next leg.
+     *   6. Publish a snapshot of the new state (and queue it for export, if on).
+     * With profiling on, each step is measured into its phase (see Profiler.h).
      */
     void go();
 
+    // Snapshots (see ModelSnapshot.h)
+    // Publish the current state as a new epoch and return it (model thread only)
+    shared_ptr<const ModelSnapshot> publishSnapshot();
+
+    // Latest published epoch; safe from any thread, held without locking the Model
+    shared_ptr<const ModelSnapshot> getSnapshot() const;
+
+    /**
+     * Sub-stepped motion. With n > 1 every ship advances exactly (a tank that
+     * empties mid-hour leaves the ship where the fuel ran out), and moving
+     * cruisers that could reach a freighter or patrol boat during the hour are
+     * stepped together with those targets in up to n sub-steps, sized to the
+     * cruiser's attack range; a target that comes into range is reported
+     * with its closest approach (the cruiser sails on). All other ships keep
+     * one whole-hour step.
+     * n = 1 (default) keeps whole-hour steps for everyone, as originally.
+     */
+    void setSubsteps(int n);
+    int getSubsteps() const;
+
+    // Proximity events (see Proximity.h)
+    // Report ships passing within nm of each other during a tick (0 turns detection off).
+    // Planar navigation only: under Geodesic, positions are degrees, not nm.
+    void setProximityThreshold(double nm);
+    double getProximityThreshold() const;
+
+    // Encounters of the last tick, ordered by time
+    const vector<Encounter>& getEncounters() const;
+
+    // Routing (see Routing.h)
+    // Land and no-go areas ships are routed around (replaces earlier ones; none = open sea)
+    void setObstacles(vector<Polygon> polygons);
+    const Router& getRouter() const;
+
+    /**
+     * Send a ship to (x, y) at speed; port names the port there, or NO_NAME.
+     * With obstacles the ship follows a route around them, cached when it sails
+     * from one port to another; otherwise it goes in a straight line as before.
+     * Throws runtime_error if the destination cannot be reached by sea.
+     */
+    void sendShip(Ship& ship, double x, double y, double speed, NameId port = NO_NAME);
+
+    // Voyage planning (see VoyagePlanner.h, FuelModel.h)
+    // Least-fuel voyage for ship from where it is to port within hours; nullptr if none makes it
+    shared_ptr<const VoyagePlan> planVoyage(const Ship& ship, NameId port, double hours);
+
+    /**
+     * Plan a freighter's voyage and start it, filling up first if it sits on a
+     * port. Each leg is sailed at its planned speed; at a refuel stop the ship
+     * docks, fills up from the port and replans the rest against the deadline
+     * before sailing on; at the destination it docks. Any other order given to
+     * the ship ends the voyage. Returns the plan; throws runtime_error if no
+     * voyage makes the deadline.
+     */
+    shared_ptr<const VoyagePlan> startVoyage(Freighter& ship, NameId port, double hours);
+    const VoyagePlanner& getPlanner() const;
+
+    // Combat (see Combat.h)
+    void setCombat(CombatMode mode);
+    CombatMode getCombat() const;
+
+    // Restart the world's random stream; the same seed and commands replay the same way
+    void seed(uint64_t value);
+
+    /**
+     * Resolve cruiser's attack on target: a win if its force exceeds the
+     * target's resistance, or a draw at winProbability() under stochastic
+     * combat. Both ships change as Cruiser::attack describes and the outcome
+     * is added to the tally. Returns true if the cruiser won.
+     */
+    bool attack(Cruiser& cruiser, Ship& target);
+    const CombatTally& getCombatTally() const;
+
+    // Columnar export (see TickExport.h)
+    // Write the current state and every following tick to path (throws runtime_error if it cannot be opened)
+    void startExport(const string& path);
+
+    // Flush and close the export; false if writing failed. No-op when not exporting.
+    bool stopExport();
+    bool isExporting() const;
+
+    // Profiling (see Profiler.h)
+    /**
+     * Attribute time and hardware counters of every following tick to its
+     * phases, on the calling thread (which must be the one running the world).
+     * Starting again starts over; stopping drops the profile.
+     */
+    void startProfiling();
+    void stopProfiling();
+
+    // The running profile, or nullptr when off (the Controller adds View::draw to it)
+    TickProfiler* getProfiler() const;
+
+    // Port economy (see PortEconomy.h)
+    /**
+     * Ports by projected shortfall, largest first (then by demand, then by
+     * name): the fuel that freighters and patrol boats now bound for each port,
+     * and freighters on voyages at their later stops, will want on arrival
+     * beyond what the port will hold by then. limit > 0 keeps only the first
+     * limit ports. Linear in ports plus ships, besides the sort.
+     */
+    vector<PortForecast> forecastPorts(size_t limit = 0) const;
+
     // Object creation (throws runtime_error if name already exists)
+    // capacity caps the port's stock (throws runtime_error if initialFuel is above it)
     void addPort(const string& name, double x, double y,
-                 double initialFuel, double fuelRate);
+                 double initialFuel, double fuelRate, double capacity = UNLIMITED_STORAGE);
 
     void addFreighter(const string& name, double x, double y,
                       int resistance, int maxContainers);
@@ -53,7 +210,28 @@ public:
     void addCruiser(const string& name, double x, double y,
                     int force, int attackRange);
 
-    // Typed lookup (throws runtime_error if not found)
+    /**
+     * Remove a ship or port (throws runtime_error if the name is unknown, or is
+     * the mandatory Nagoya port). Ships are swap-removed from dense storage in
+     * O(1); their memory (object, trajectory ring) is released. Ports are
+     * swap-removed too, but removing one takes a pass over the ships (those
+     * bound for it sail on to its coordinates); its cached routes and the
+     * voyage plans are dropped. Status output keeps creation order (ships) and
+     * name order (ports).
+     */
+    void remove(const string& name);
+
+    // Remove the object a handle refers to; false if it is gone already
+    bool remove(ObjectHandle handle);
+
+    // Handle to the object named id (throws runtime_error if there is none)
+    ObjectHandle getHandle(NameId id) const;
+
+    // The object behind a handle, or nullptr if it has been removed
+    shared_ptr<Ship> getShip(ObjectHandle handle) const;
+    shared_ptr<Port> getPort(ObjectHandle handle) const;
+
+    // Typed lookup by name (throws runtime_error if not found)
     shared_ptr<Port>      getPort(const string& name)      const;
     shared_ptr<Freighter> getFreighter(const string& name) const;
     shared_ptr<Patrol>    getPatrol(const string& name)    const;
@@ -62,33 +240,188 @@ public:
     // Returns a ship by name regardless of type (throws if not found)
     shared_ptr<Ship> getShip(const string& name) const;
 
+    // Typed lookup by interned ID: O(1) array indexing (throws runtime_error if not found)
+    shared_ptr<Port> getPort(NameId id) const;
+    shared_ptr<Ship> getShip(NameId id) const;
+
+    // Port located exactly at (x, y), or nullptr if there is none
+    shared_ptr<Port> getPortAt(double x, double y) const;
+
     // Returns true if any object (ship or port) has this name
     bool nameExists(const string& name) const;
 
-    // Returns true if a ship (any type) has this name
+    // Returns true if a ship (any type) has this name / ID
     bool shipExists(const string& name) const;
+    bool shipExists(NameId id) const;
+
+    // Returns true if a port has this ID
+    bool portExists(NameId id) const;
+
+    // Trajectory history (see TrajectoryLog.h)
+    // Keep `hours` samples per ship from now on (0 disables); existing history is dropped
+    void setTrackDepth(size_t hours);
+    size_t getTrackDepth() const;
+
+    // Last `count` samples (0 = all held) of a ship, oldest first (throws if id is not a ship)
+    void getTrack(NameId ship, size_t count, vector<int>& times, vector<TrackPoint>& points) const;
 
     // View support
-    // Flat list of all simulation objects; the View iterates this to render the map
+    // Flat list of all simulation objects; the View iterates this to render the map.
+    // Order: ports by name, then freighters, patrol boats and cruisers, each by name.
     vector<shared_ptr<Sim_object>> getAllObjects() const;
 
     // Status output
-    // Print status of every object: ports first (map order), then ships (insertion order)
-    void printStatus() const;
+    // Print status of every object: ports first (name order), then ships (insertion order)
+    void printStatus(ostream& out = cout) const;
+
+    // All objects in printStatus() order
+    vector<shared_ptr<Sim_object>> getStatusOrder() const;
+
+    /**
+     * Apply fn(NameId, const string& line, uint64_t version) to every object's
+     * status line in printStatus() order, without building a list. A ship's
+     * version changes whenever its line does; a port's is always 0 (its stock
+     * moves every hour).
+     */
+    template <typename Fn>
+    void forEachStatusLine(Fn fn) const {
+        for (uint32_t i : portOrder) fn(ports[i]->getNameId(), ports[i]->currentLine(), uint64_t(0));
+        for (uint32_t i : creationOrder()) {
+            const Ship& ship = *ships[i];
+            const string& line = shipTables.statusLine(ship);
+            fn(ship.getNameId(), line, shipTables.lineVersion(ship));
+        }
+    }
+
+    /**
+     * Ships matching a status query (see StatusIndex.h): the requested page,
+     * ranked or in creation order. Ships changed since the last query are
+     * reindexed first; the rest costs what the matches cost, not the fleet.
+     */
+    StatusPage queryStatus(const StatusQuery& query) const;
 
 private:
-    Model(); // creates mandatory Nagoya port
+    // What a NameId refers to in this Model: a port, or a ship of the type shipKind() maps
+    enum ObjKind : uint8_t { PortKind, FirstShipKind };
+
+    // Slot kind of a ship type (the ship kinds follow ShipType from FirstShipKind)
+    static constexpr ObjKind shipKind(ShipType type) { return static_cast<ObjKind>(FirstShipKind + type); }
+    struct Slot {
+        ObjKind  kind;
+        uint32_t index;      // into ports or ships, depending on kind
+        uint32_t generation; // registration stamp, unique in this Model (see ObjectHandle)
+    };
 
     int time; // current simulation time (hours)
+    ostream& log; // out of fuel, cruiser approaches, voyages
+    Navigation navigation = Planar;
+    shared_ptr<const FuelModel> fuelModel; // shared with shipTables and planner by reference
+
+    // Directory of the names in use here: resolves an ID to its object in O(1).
+    // Sized by this world's objects; a removal drops its entry.
+    unordered_map<NameId, Slot> slots;
+    uint32_t nextGeneration = 1; // stamp of the next registration (0 is the empty handle's)
+
+    PortEconomy              economy;   // fuel of every port, rows indexed like ports (outlives them)
+    vector<shared_ptr<Port>> ports;     // dense, creation order
+    vector<uint32_t>         portOrder; // indices into ports, sorted by name
+    vector<shared_ptr<Ship>> ships;     // dense; insertion order until a removal swaps the last one in
+    vector<uint64_t>         shipSeq;   // per ship (indexed like ships): creation sequence number
+    mutable ShipTables       shipTables; // per-ship state few ships need (routes, arcs, status lines)
+    uint64_t                 nextSeq = 0;
+
+    // Indices into ships in creation order, for status and snapshots; appended
+    // to as ships are created, re-sorted by shipSeq on first use after a removal
+    mutable vector<uint32_t> shipOrder;
+    mutable bool             shipOrderStale = false;
+    const vector<uint32_t>&  creationOrder() const;
+
+    shared_ptr<const ModelSnapshot> snapshot; // latest epoch; atomic_load / atomic_store only
+    RecyclePool<ModelSnapshot> snapshotPool; // epochs and chunks refilled once readers let go
+    RecyclePool<ChunkedRecords<PortRecord>::Chunk> portChunks;
+    RecyclePool<ChunkedRecords<ShipRecord>::Chunk> shipChunks;
+
+    TrajectoryLog trajectories; // per-ship history rings, indexed like ships
+    unique_ptr<TickExporter> exporter; // background columnar export; null when off
+    unique_ptr<TickProfiler> profiler; // null when off
+
+    int substeps = 1; // max sub-steps per hour; 1 = whole-hour steps
+
+    ProximityDetector proximity; // swept-segment encounter detection; off by default
+    vector<Encounter> encounters; // found during the last tick
+
+    Router router; // obstacle-aware routes and the port-to-port route cache
+
+    VoyagePlanner planner{router}; // port graph and memoized voyage plans
+    struct Voyage {
+        ObjectHandle ship;
+        NameId port;     // destination
+        double deadline; // time it must arrive by
+        shared_ptr<const VoyagePlan> plan; // from the last stop; its first leg is being sailed
+    };
+    vector<Voyage> voyages; // in progress, in start order
+
+    CombatMode  combat = DeterministicCombat;
+    CombatRng   rng;
+    CombatTally tally;
+
+    // Secondary indexes for queryStatus(), indexed like ships once the first query builds them
+    mutable StatusIndex statusIndex;
+    mutable vector<uint32_t> statusPage; // queryStatus() scratch
+
+    // forecastPorts() scratch
+    mutable vector<PortArrival> arrivals;
+    mutable vector<PortOutlook> outlooks;
+
+    // planVoyage() for a ship that first takes on extra kl at its port
+    shared_ptr<const VoyagePlan> planVoyage(const Ship& ship, NameId port, double hours, double extra);
+
+    // Dock ships that finished a leg; refuel, replan and sail on from stops (after each tick's motion)
+    void advanceVoyages();
+
+    // Sub-stepping scratch, reused every tick
+    struct Pursuit {
+        uint32_t cruiser; // index into ships
+        uint32_t target;
+        double   closest; // nm, over this hour's sub-steps
+    };
+    struct XKey {
+        double   x;
+        uint32_t index; // into ships
+    };
+    vector<XKey>     targetsByX; // freighters and patrol boats, sorted by x
+    vector<Pursuit>  pursuits;   // pairs that may close to attack range this hour
+    vector<uint8_t>  fineStep;   // per ship: stepped in sub-steps this hour
+    vector<uint32_t> fineShips;  // indices with fineStep set, insertion order
+
+    // go() body for substeps > 1
+    void advanceShipsSubstepped();
+
+    // go() ship loop while profiling: same order, one sample per run of same-type ships
+    void updateShipsProfiled(TickProfiler& prof, bool tracking);
+
+    // Slot for an ID, or nullptr if the ID names nothing in this Model
+    const Slot* findSlot(NameId id) const;
+
+    // Intern name, reject duplicates, and record where the object lives
+    NameId registerName(const string& name, ObjKind kind, uint32_t index);
+
+    // Where name stands (or would stand) in portOrder
+    vector<uint32_t>::iterator portPosition(const string& name);
+
+    // The add* methods for any ship kind (see ShipKind.h): name, then the Kind's constructor arguments
+    template <class Kind, class... Args>
+    void createShip(const string& name, Args&&... args);
+
+    // Shared tail of createShip(): dense storage, order, trajectory ring
+    void appendShip(shared_ptr<Ship> ship);
 
-    // One container per type for O(log n) typed lookup
-    map<string, shared_ptr<Port>>      ports;
-    map<string, shared_ptr<Freighter>> freighters;
-    map<string, shared_ptr<Patrol>>    patrols;
-    map<string, shared_ptr<Cruiser>>   cruisers;
+    // Remove the object in slot id (which must exist)
+    void removeShip(NameId id);
+    void removePort(NameId id);
 
-    // Insertion-order list of ship names for deterministic update/status order
-    vector<string> shipOrder;
+    // Ship of the given kind by name (throws with "No <what> named: <name>")
+    shared_ptr<Ship> getShipOfKind(const string& name, ShipType type, const string& what) const;
 };
 
 #endif //INC_74_EX3_MODEL_H
@@ -0,0 +1,181 @@
+//
+// ModelSnapshot: immutable, epoch-numbered copy of the Model's dynamic state
+// (positions, navigation states, fuel) that readers can hold without locking.
+//
+// Records are stored in fixed-size chunks held by shared_ptr. When the Model
+// publishes a new epoch, a chunk of ships none of which was touched since the
+// previous epoch (see Ship::touch()) is shared with it as it is; the others
+// are filled again, and shared too if they come out identical. Ports are all
+// refilled (their fuel changes every hour). Publishing costs the ships that
+// changed, and memory grows only by the chunks that differ. Snapshots and
+// chunks come from RecyclePools: one that no reader holds any more is
+// refilled in place, so once the pools have grown to the number of epochs
+// readers keep alive, publishing allocates nothing.
+//
+
+#ifndef INC_74_EX3_MODELSNAPSHOT_H
+#define INC_74_EX3_MODELSNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "NameTable.h"
+#include "Ship.h"
+using namespace std;
+
+// Records per copy-on-write chunk
+static const size_t SNAPSHOT_CHUNK_SIZE = 1024;
+
+struct ShipRecord {
+    NameId   name;
+    ShipType type;
+    State    state;
+    int      attackStat;
+    int      containers; // freighters only; 0 otherwise
+    double   x;
+    double   y;
+    double   fuel;
+
+    bool operator==(const ShipRecord& o) const {
+        return name == o.name && type == o.type && state == o.state && attackStat == o.attackStat
+            && containers == o.containers && x == o.x && y == o.y && fuel == o.fuel;
+    }
+};
+
+struct PortRecord {
+    NameId name;
+    double x;
+    double y;
+    double fuel;
+
+    bool operator==(const PortRecord& o) const {
+        return name == o.name && x == o.x && y == o.y && fuel == o.fuel;
+    }
+};
+
+/**
+ * Objects handed out by shared_ptr and taken back once only the pool holds
+ * them. Used by the publishing thread alone; readers just drop their copies.
+ */
+template <typename T>
+class RecyclePool {
+public:
+    // An object no reader holds (with whatever it held last), or a new one
+    shared_ptr<T> take() {
+        for (size_t tried = 0; tried < items.size(); ++tried) {
+            shared_ptr<T>& item = items[cursor];
+            cursor = cursor + 1 < items.size() ? cursor + 1 : 0;
+            if (item.use_count() == 1) {
+                atomic_thread_fence(memory_order_acquire); // pairs with the last reader's release
+                return item;
+            }
+        }
+        items.push_back(make_shared<T>());
+        return items.back();
+    }
+
+    // Apply fn to every object no reader holds
+    template <typename Fn>
+    void forEachFree(Fn fn) {
+        for (auto& item : items)
+            if (item.use_count() == 1) {
+                atomic_thread_fence(memory_order_acquire);
+                fn(*item);
+            }
+    }
+
+    size_t size() const { return items.size(); }
+
+private:
+    vector<shared_ptr<T>> items;
+    size_t cursor = 0; // where the next search starts: the oldest items are freed first
+};
+
+/**
+ * Chunked, shareable array of records. Index i lives in chunk i / SNAPSHOT_CHUNK_SIZE.
+ */
+template <typename Record>
+class ChunkedRecords {
+public:
+    using Chunk = vector<Record>;
+
+    size_t size() const { return count; }
+
+    const Record& operator[](size_t i) const {
+        return (*chunks[i / SNAPSHOT_CHUNK_SIZE])[i % SNAPSHOT_CHUNK_SIZE];
+    }
+
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (const auto& chunk : chunks)
+            for (const Record& r : *chunk) fn(r);
+    }
+
+    // Number of chunks physically shared with another ChunkedRecords
+    size_t sharedWith(const ChunkedRecords& other) const {
+        size_t n = 0;
+        for (size_t c = 0; c < chunks.size() && c < other.chunks.size(); ++c)
+            if (chunks[c] == other.chunks[c]) ++n;
+        return n;
+    }
+
+    size_t chunkCount() const { return chunks.size(); }
+
+    /**
+     * Build from `fill(i, record)` for i in [0, n), reusing chunks of prev that
+     * come out identical. Each chunk is filled into a free chunk from pool,
+     * which is kept if it differs from prev's and goes back otherwise. A chunk
+     * of prev's length for which `changed(c)` is false is shared unfilled.
+     */
+    template <typename Fill, typename Changed>
+    void build(size_t n, const ChunkedRecords* prev, RecyclePool<Chunk>& pool, Fill fill, Changed changed) {
+        count = n;
+        chunks.clear();
+        shared_ptr<Chunk> chunk;
+        for (size_t begin = 0; begin < n; begin += SNAPSHOT_CHUNK_SIZE) {
+            size_t len = n - begin < SNAPSHOT_CHUNK_SIZE ? n - begin : SNAPSHOT_CHUNK_SIZE;
+            size_t c = begin / SNAPSHOT_CHUNK_SIZE;
+            bool inPrev = prev && c < prev->chunks.size() && prev->chunks[c]->size() == len;
+            if (inPrev && !changed(c)) {
+                chunks.push_back(prev->chunks[c]);
+                continue;
+            }
+            if (!chunk) chunk = pool.take();
+            chunk->resize(len);
+            for (size_t k = 0; k < len; ++k) fill(begin + k, (*chunk)[k]);
+            if (inPrev && *prev->chunks[c] == *chunk)
+                chunks.push_back(prev->chunks[c]); // chunk stays ours for the next one
+            else
+                chunks.push_back(move(chunk));
+        }
+    }
+
+    template <typename Fill>
+    void build(size_t n, const ChunkedRecords* prev, RecyclePool<Chunk>& pool, Fill fill) {
+        build(n, prev, pool, fill, [](size_t) { return true; });
+    }
+
+    // Let go of every chunk (keeps the capacity of the chunk list)
+    void clear() {
+        count = 0;
+        chunks.clear();
+    }
+
+private:
+    size_t count = 0;
+    vector<shared_ptr<const Chunk>> chunks;
+};
+
+/**
+ * One published epoch. Ports are in name order, ships in insertion order
+ * (the same order as Model::printStatus()).
+ */
+struct ModelSnapshot {
+    uint64_t                 epoch = 0;
+    int                      time  = 0;
+    ChunkedRecords<PortRecord> ports;
+    ChunkedRecords<ShipRecord> ships;
+};
+
+#endif //INC_74_EX3_MODELSNAPSHOT_H
@@ -0,0 +1,82 @@
+//
+// Created by hadar on 25/02/2026.
+//
+
+#include "NameTable.h"
+#include <algorithm>
+#include <functional>
+using namespace std;
+
+NameTable& NameTable::get() {
+    static NameTable instance;
+    return instance;
+}
+
+NameTable::NameTable() {
+    index.store(&newIndex(INDEX_SLOTS), memory_order_release);
+}
+
+NameTable::Index& NameTable::newIndex(size_t slots) {
+    unique_ptr<Index> ix(new Index);
+    ix->mask  = slots - 1;
+    ix->slots.reset(new atomic<NameId>[slots]);
+    for (size_t i = 0; i < slots; ++i) ix->slots[i].store(NO_NAME, memory_order_relaxed);
+    indexes.push_back(move(ix));
+    return *indexes.back();
+}
+
+void NameTable::insert(const Index& ix, NameId id, size_t hash) {
+    size_t i = hash & ix.mask;
+    while (ix.slots[i].load(memory_order_relaxed) != NO_NAME) i = (i + 1) & ix.mask;
+    ix.slots[i].store(id, memory_order_release); // the name is in place before its ID can be found
+}
+
+NameId NameTable::find(const string& name) const {
+    const Index* ix = index.load(memory_order_acquire);
+    for (size_t i = hash<string>()(name) & ix->mask;; i = (i + 1) & ix->mask) {
+        NameId id = ix->slots[i].load(memory_order_acquire);
+        if (id == NO_NAME) return NO_NAME;
+        if (str(id) == name) return id;
+    }
+}
+
+/**
+ * A new name goes into the next free place of the last chunk (a new chunk
+ * every CHUNK_SIZE names, a larger directory when it runs out of room), then
+ * into the index (rebuilt twice as large first if that would fill it over
+ * half). Readers only reach it through the index or the published count, both
+ * stored after it.
+ */
+NameId NameTable::intern(const string& name) {
+    NameId id = find(name);
+    if (id != NO_NAME) return id;
+    lock_guard<mutex> guard(writer);
+    id = find(name); // another thread may have added it in between
+    if (id != NO_NAME) return id;
+
+    size_t n = count.load(memory_order_relaxed);
+    if (n % CHUNK_SIZE == 0) {
+        chunks.emplace_back(new string[CHUNK_SIZE]);
+        if (chunks.size() > directoryCapacity) {
+            directoryCapacity = max<size_t>(16, 2 * directoryCapacity);
+            directories.emplace_back(new string*[directoryCapacity]);
+            for (size_t c = 0; c < chunks.size(); ++c) directories.back()[c] = chunks[c].get();
+            directory.store(directories.back().get(), memory_order_release);
+        } else {
+            directories.back()[chunks.size() - 1] = chunks.back().get(); // past every published ID
+        }
+    }
+    chunks.back()[n % CHUNK_SIZE] = name;
+    id = static_cast<NameId>(n);
+
+    const Index* ix = index.load(memory_order_relaxed);
+    if (2 * (n + 1) > ix->mask + 1) {
+        Index& grown = newIndex(2 * (ix->mask + 1));
+        for (size_t k = 0; k < n; ++k) insert(grown, static_cast<NameId>(k), hash<string>()(str(static_cast<NameId>(k))));
+        index.store(&grown, memory_order_release);
+        ix = &grown;
+    }
+    insert(*ix, id, hash<string>()(name));
+    count.store(n + 1, memory_order_release);
+    return id;
+}
@@ -0,0 +1,86 @@
+//
+// NameTable: process-wide interner mapping object names to compact integer IDs.
+// Ports and ships are referenced by NameId internally; strings are only
+// resolved at the I/O boundary (command parsing and status/map output).
+//
+
+#ifndef INC_74_EX3_NAMETABLE_H
+#define INC_74_EX3_NAMETABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+using NameId = uint32_t;
+
+// "No name" sentinel (e.g. a ship with no destination port)
+static const NameId NO_NAME = UINT32_MAX;
+
+/**
+ * NameTable (Singleton): IDs are dense (0, 1, 2, ...) in first-seen order and
+ * never reused, so they can index flat arrays. Access via NameTable::get().
+ * Shared by every world in the process, and lookups take no lock: names are
+ * stored in fixed-size chunks that never move, and the reverse index is an
+ * open-addressed table whose slots are written once. When the chunk directory
+ * or the index fills up a larger copy is published, and the old one is kept
+ * for readers that may still hold it. Only interning a new name locks (against
+ * other new names). Returned string references stay valid for the process
+ * lifetime.
+ */
+class NameTable {
+public:
+    static NameTable& get();
+
+    NameTable(const NameTable&)            = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    // Return the ID for name, issuing a new one if it has not been seen
+    NameId intern(const string& name);
+
+    // Return the ID for name, or NO_NAME if it was never interned
+    NameId find(const string& name) const;
+
+    // Resolve an ID back to its string (empty string for NO_NAME)
+    const string& str(NameId id) const {
+        static const string empty;
+        if (id == NO_NAME) return empty;
+        string** chunks = directory.load(memory_order_acquire);
+        return chunks[id / CHUNK_SIZE][id % CHUNK_SIZE];
+    }
+
+    // Number of IDs issued so far
+    size_t size() const { return count.load(memory_order_acquire); }
+
+private:
+    NameTable();
+
+    static const size_t CHUNK_SIZE  = 1024; // names per storage chunk
+    static const size_t INDEX_SLOTS = 1024; // initial reverse index size; kept at most half full
+
+    // Reverse index: each slot is NO_NAME or the ID of a name hashing there (linear probing)
+    struct Index {
+        size_t mask; // slot count - 1 (a power of two)
+        unique_ptr<atomic<NameId>[]> slots;
+    };
+
+    mutex writer;                 // held by intern() while it adds a name
+    atomic<size_t> count{0};      // names issued
+    atomic<string**> directory{nullptr}; // chunk pointers, in ID order
+    atomic<const Index*> index{nullptr};
+
+    // Everything ever published, owned until exit (writer only)
+    vector<unique_ptr<string[]>>  chunks;
+    vector<unique_ptr<string*[]>> directories;
+    size_t                        directoryCapacity = 0;
+    vector<unique_ptr<Index>>     indexes;
+
+    // A new, empty index of slots slots (a power of two), kept in indexes
+    Index& newIndex(size_t slots);
+    static void insert(const Index& ix, NameId id, size_t hash);
+};
+
+#endif //INC_74_EX3_NAMETABLE_H
@@ -0,0 +1,59 @@
+//
+// ObstacleFile implementation
+//
+
+#include "ObstacleFile.h"
+#include "Model.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+// Build "Error (line N): msg"
+static runtime_error lineError(int lineNum, const string& msg) {
+    return runtime_error("Error (line " + to_string(lineNum) + "): " + msg);
+}
+
+vector<Polygon> readObstacleFile(const string& path) {
+    ifstream obstacleFile(path);
+    if (!obstacleFile.is_open())
+        throw runtime_error("Error: cannot open obstacle file '" + path + "'");
+
+    vector<Polygon> polygons;
+    string line;
+    int lineNum = 0;
+    while (getline(obstacleFile, line)) {
+        ++lineNum;
+
+        // Skip blanks
+        istringstream probe(line);
+        string name;
+        if (!(probe >> name)) continue;
+
+        // vertices: "(x," and "y)" pairs; strip parentheses/commas and read numbers
+        string rest, inner;
+        getline(probe, rest);
+        for (char c : rest) {
+            if (c == '(' || c == ')' || c == ',') inner += ' ';
+            else inner += c;
+        }
+        istringstream coordSS(inner);
+        Polygon poly;
+        double x, y;
+        while (coordSS >> x) {
+            if (!(coordSS >> y))
+                throw lineError(lineNum, "invalid coordinates in obstacle " + name);
+            poly.emplace_back(x, y);
+        }
+        if (!coordSS.eof())
+            throw lineError(lineNum, "invalid coordinates in obstacle " + name);
+        if (poly.size() < 3)
+            throw lineError(lineNum, "obstacle " + name + " needs at least three vertices");
+        polygons.push_back(move(poly));
+    }
+    return polygons;
+}
+
+void loadObstacleFile(Model& model, const string& path) {
+    model.setObstacles(readObstacleFile(path));
+}
@@ -0,0 +1,28 @@
+//
+// ObstacleFile: loader for the land / no-go polygons ships are routed around
+// (see Routing.h). Shared by the interactive simulator and the headless tools.
+//
+
+#ifndef INC_74_EX3_OBSTACLEFILE_H
+#define INC_74_EX3_OBSTACLEFILE_H
+
+#include <string>
+#include <vector>
+#include "Routing.h"
+using namespace std;
+
+class Model;
+
+/**
+ * Parse an obstacle file into its polygons.
+ * Format per line:  <name> (<x1>, <y1>) (<x2>, <y2>) (<x3>, <y3>) ...
+ * At least three vertices; the polygon closes back to the first one by itself.
+ * Empty lines and lines consisting only of whitespace are skipped.
+ * Throws runtime_error with a ready-to-print message on any file or parse error.
+ */
+vector<Polygon> readObstacleFile(const string& path);
+
+// Parse an obstacle file and hand its polygons to model (same errors)
+void loadObstacleFile(Model& model, const string& path);
+
+#endif //INC_74_EX3_OBSTACLEFILE_H
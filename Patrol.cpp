@@ -8,8 +8,7 @@
 using namespace std;
 
 // Default constructor
-Patrol::Patrol()
-    : Ship() {}
+Patrol::Patrol() {}
 
 // Destructor
 
@@ -21,16 +20,7 @@ Patrol::Patrol()
  * @param resistance Resistance value against pirate attacks
  */
 Patrol::Patrol(const string& name, double corX, double corY, int resistance)
-    : Ship(name, corX, corY, 0.0, 0.0, PATROL_MAX_FUEL,
-           PATROL_FUEL_RATE, resistance,
-           PATROL_MAX_SPEED, PATROL_MAX_FUEL) {}
-
-// Add fuel up to the tank capacity
-void Patrol::refuel(double amount) {
-    double newFuel = getFuel() + amount;
-    if (newFuel > PATROL_MAX_FUEL) newFuel = PATROL_MAX_FUEL;
-    setFuel(newFuel);
-}
+    : ShipKind(name, corX, corY, resistance) {}
 
 /**
  * On pirate attack result:
@@ -40,19 +30,21 @@ void Patrol::refuel(double amount) {
 void Patrol::setAttackStat(bool victory) {
     if (victory) attackStat--;
     else         attackStat++;
+    touch();
 }
 
 /**
- * Print patrol boat status.
+ * Patrol boat status line.
  * Format:
  *   Patrol_boat <name> at (<x>, <y>), fuel: <fuel> kl, resistance: <res>, <nav state>
  */
-void Patrol::printStatus() const {
-    cout << fixed << setprecision(2);
-    cout << "Patrol_boat " << getName()
+void Patrol::formatStatus(ostream& out) const {
+    out << fixed << setprecision(2);
+    out << "Patrol_boat " << getName()
          << " at (" << getCorX() << ", " << getCorY() << ")"
          << ", fuel: " << getFuel() << " kl"
          << ", resistance: " << attackStat
-         << ", " << navString()
-         << "\n";
+         << ", ";
+    printNav(out);
+    out << "\n";
 }
@@ -4,31 +4,26 @@
 
 #ifndef INC_74_EX3_PATROL_H
 #define INC_74_EX3_PATROL_H
-#include "Ship.h"
+#include "ShipKind.h"
 
-// Patrol boat constants
-static const double PATROL_MAX_SPEED = 15.0;  // nm/h
-static const double PATROL_MAX_FUEL  = 900.0; // kl
-static const int    PATROL_FUEL_RATE = 2;     // kl per nm
+// Patrol boat constants (PatrolTraits) live in ShipTraits.h
 
 /**
  * Patrol boat: automatically visits all ports in a Hamiltonian circuit.
- * Destination port name is tracked by the Ship base class (destPortName).
+ * The port it is heading to is tracked by the Ship base class (destPort, an interned NameId).
  */
-class Patrol : public Ship {
+class Patrol : public ShipKind<PatrolTraits> {
 public:
     Patrol();
     ~Patrol() override = default;
 
     Patrol(const string& name, double corX, double corY, int resistance);
 
-    // Refuel capped at PATROL_MAX_FUEL
-    void refuel(double amount) override;
-
     // Pirate victory: patrol resistance -1; defeat: resistance +1
     void setAttackStat(bool victory) override;
 
-    void printStatus() const override;
+protected:
+    void formatStatus(ostream& out) const override;
 };
 
 #endif //INC_74_EX3_PATROL_H
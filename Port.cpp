@@ -3,33 +3,51 @@
 //
 
 #include "Port.h"
+#include "StringSink.h"
 #include <iostream>
 #include <iomanip>
+#include <cmath>
 using namespace std;
 
-Port::Port(const string& name, double corX, double corY,
-           double initialFuel, double fuelRate)
-    : Sim_object(name, corX, corY), fuel(initialFuel), fuelRate(fuelRate) {}
+Port::Port(const string& name, double corX, double corY, PortEconomy& economy, uint32_t row)
+    : Sim_object(name, corX, corY), economy(economy), row(row), statusFuel(NAN) {}
 
 // Produce fuel each time step
-void Port::update() {
-    fuel += fuelRate;
+void Port::update(ostream&) {
+    if (row != DETACHED) economy.produce(row);
 }
 
-double Port::getFuel()     const { return fuel; }
-double Port::getFuelRate() const { return fuelRate; }
+double Port::getFuel()     const { return row == DETACHED ? detachedFuel : economy.getStock(row); }
+double Port::getFuelRate() const { return row == DETACHED ? 0.0 : economy.getRate(row); }
+double Port::getCapacity() const { return row == DETACHED ? detachedCapacity : economy.getCapacity(row); }
 
-// Dispense up to requested kl; return actual amount given
+// Dispense up to requested kl; return actual amount given (nothing once removed)
 double Port::dispenseFuel(double requested) {
-    double dispensed = (requested <= fuel) ? requested : fuel;
-    fuel -= dispensed;
-    return dispensed;
+    return row == DETACHED ? 0.0 : economy.dispense(row, requested);
+}
+
+void Port::detach() {
+    detachedFuel     = getFuel();
+    detachedCapacity = getCapacity();
+    row = DETACHED;
 }
 
 // "Port Nagoya at position (50.00, 5.00), Fuel available: 1001000.0 kl"
-void Port::printStatus() const {
-    cout << fixed << setprecision(1);
-    cout << "Port " << getName()
-         << " at position (" << corX << ", " << corY << ")"
-         << ", Fuel available: " << fuel << " kl\n";
+void Port::printStatus(ostream& out) const {
+    out << fixed << setprecision(1) << currentLine();
+}
+
+const string& Port::currentLine() const {
+    const double fuel = getFuel();
+    if (fuel != statusFuel) { // never equal to the initial NaN
+        statusLine.clear();
+        StringSink sink(statusLine);
+        ostream line(&sink);
+        line << fixed << setprecision(1);
+        line << "Port " << getName()
+             << " at position (" << corX << ", " << corY << ")"
+             << ", Fuel available: " << fuel << " kl\n";
+        statusFuel = fuel;
+    }
+    return statusLine;
 }
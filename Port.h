@@ -6,30 +6,53 @@
 #define INC_74_EX3_PORT_H
 
 #include "Sim_object.h"
+#include "PortEconomy.h"
 
 /**
  * Port: a fixed simulation object with a fuel supply and a production rate.
- * Fuel is produced at fuelRate kl per time step (via update()).
- * Ships can request fuel via dispenseFuel() on a first-come-first-served basis.
+ * Fuel is produced at fuelRate kl per time step, up to the port's storage
+ * capacity. Ships can request fuel via dispenseFuel() on a first-come-first-served basis.
+ * The numbers live in the world's PortEconomy (row `row`), which produces
+ * every port's fuel in one pass; the Port is their named face. A port removed
+ * from the world is detached: it keeps the stock it had and stops reading
+ * the economy, whose rows now belong to other ports.
  */
 class Port : public Sim_object {
 private:
-    double fuel;      // current fuel stock in kl
-    double fuelRate;  // kl produced per time step
+    PortEconomy& economy;
+    uint32_t     row; // in economy; the Model renumbers it when the port takes a removed one's place
+
+    // row of a detached port; its figures are the ones below from then on
+    static const uint32_t DETACHED = UINT32_MAX;
+    double detachedFuel     = 0;
+    double detachedCapacity = 0;
+
+    // Freeze the figures and let go of the row (Model::removePort)
+    void detach();
+
+    // printStatus() output and the stock it shows; the economy changes the
+    // stock behind the port's back, so the line is rebuilt when that differs
+    mutable string statusLine;
+    mutable double statusFuel;
+
+    // statusLine, rebuilt first if the stock moved
+    const string& currentLine() const;
+
+    friend class Model;
 
 public:
-    Port(const string& name, double corX, double corY,
-         double initialFuel, double fuelRate);
+    Port(const string& name, double corX, double corY, PortEconomy& economy, uint32_t row);
 
-    // Produce fuel for this time step
-    void update() override;
+    // Produce fuel for this time step (Model::go() produces every port at once instead)
+    void update(ostream& log) override;
 
     // Print status: "Port <name> at position (<x>, <y>), Fuel available: <fuel> kl"
-    void printStatus() const override;
+    void printStatus(ostream& out) const override;
 
     // Getters
     double getFuel()     const;
     double getFuelRate() const;
+    double getCapacity() const; // UNLIMITED_STORAGE if the port has no storage limit
 
     /**
      * Dispense up to 'requested' kl of fuel (FCFS).
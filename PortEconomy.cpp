@@ -0,0 +1,80 @@
+//
+// PortEconomy implementation
+//
+#include "PortEconomy.h"
+#include <algorithm>
+using namespace std;
+
+uint32_t PortEconomy::add(double initial, double perTick, double limit) {
+    stock.push_back(initial);
+    rate.push_back(perTick);
+    capacity.push_back(limit);
+    return static_cast<uint32_t>(stock.size() - 1);
+}
+
+void PortEconomy::erase(uint32_t row) {
+    stock[row]    = stock.back();
+    rate[row]     = rate.back();
+    capacity[row] = capacity.back();
+    stock.pop_back();
+    rate.pop_back();
+    capacity.pop_back();
+}
+
+// Release builds vectorize this loop (packed adds and mins, after a runtime overlap check)
+void PortEconomy::produce() {
+    double* s = stock.data();
+    const double* r = rate.data();
+    const double* c = capacity.data();
+    const size_t n = stock.size();
+    for (size_t i = 0; i < n; ++i) s[i] = min(s[i] + r[i], c[i]);
+}
+
+void PortEconomy::produce(uint32_t row) {
+    stock[row] = min(stock[row] + rate[row], capacity[row]);
+}
+
+double PortEconomy::dispense(uint32_t row, double requested) {
+    double given = requested <= stock[row] ? requested : stock[row];
+    stock[row] -= given;
+    return given;
+}
+
+/**
+ * A port's stock between two arrivals grows by rate per tick up to capacity;
+ * starting at or below capacity, k ticks of min(s + rate, capacity) are
+ * min(s + k * rate, capacity), so each arrival costs O(1) however far off.
+ */
+void PortEconomy::forecast(const vector<PortArrival>& arrivals, vector<PortOutlook>& out) const {
+    const size_t n = stock.size();
+    out.assign(n, PortOutlook());
+    offsets.assign(n + 1, 0);
+    for (const PortArrival& a : arrivals) ++offsets[a.row + 1];
+    for (size_t i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+    byRow.resize(arrivals.size());
+    for (const PortArrival& a : arrivals) byRow[offsets[a.row]++] = a;
+    for (size_t i = n; i > 0; --i) offsets[i] = offsets[i - 1]; // back to bucket starts
+    offsets[0] = 0;
+
+    for (uint32_t row = 0; row < n; ++row) {
+        PortOutlook& o = out[row];
+        o.row = row;
+        auto first = byRow.begin() + offsets[row], last = byRow.begin() + offsets[row + 1];
+        if (first == last) continue;
+        sort(first, last, [](const PortArrival& a, const PortArrival& b) { return a.eta < b.eta; });
+        double s = stock[row];
+        int at = 0;
+        for (auto it = first; it != last; ++it) {
+            if (it->hours > at) {
+                s  = min(s + (it->hours - at) * rate[row], capacity[row]);
+                at = it->hours;
+            }
+            double given = min(it->demand, s);
+            s -= given;
+            o.demand    += it->demand;
+            o.shortfall += it->demand - given;
+        }
+        o.arrivals  = static_cast<uint32_t>(last - first);
+        o.firstHour = first->hours;
+    }
+}
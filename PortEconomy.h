@@ -0,0 +1,83 @@
+//
+// PortEconomy: the fuel stocks of a world's ports, and where they are heading.
+//
+// Stocks, production rates and storage capacities live in parallel arrays,
+// one row per port (rows follow the Model's port order), so a tick's
+// production is one branch-free pass that optimized builds vectorize:
+// stock = min(stock + rate, capacity). Ports without a storage limit have an
+// infinite capacity, which the same pass leaves alone.
+//
+// The forecast plays the known arrivals against each port: every freighter
+// and patrol boat bound for a port is expected to fill its tank there when it
+// arrives, at the hour its distance and speed give. Arrivals are bucketed by
+// port (a counting sort, linear in ports plus arrivals) and each port's few
+// are served in arrival order from the stock it will have produced by then;
+// what they ask for beyond that is the port's projected shortfall.
+//
+
+#ifndef INC_74_EX3_PORTECONOMY_H
+#define INC_74_EX3_PORTECONOMY_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+static const double UNLIMITED_STORAGE = HUGE_VAL; // capacity of a port without a storage limit
+
+// A ship expected at a port
+struct PortArrival {
+    uint32_t row;    // the port's row
+    int      hours;  // ticks until it arrives (the port produces this many times first)
+    double   eta;    // exact hours from now, orders arrivals within a tick
+    double   demand; // kl it will take: its tank's empty space on arrival
+};
+
+// One port's outlook over the arrivals known now
+struct PortOutlook {
+    uint32_t row       = 0;
+    uint32_t arrivals  = 0;
+    int      firstHour = -1; // ticks until the first arrival; -1 if none is expected
+    double   demand    = 0;  // kl asked for by the arrivals
+    double   shortfall = 0;  // kl of that the port will not have
+};
+
+class PortEconomy {
+public:
+    // New row at the end; returns its index
+    uint32_t add(double stock, double rate, double capacity);
+
+    // Drop a row; the last row takes its place
+    void erase(uint32_t row);
+
+    size_t size() const { return stock.size(); }
+
+    // One tick of production at every port / at one port
+    void produce();
+    void produce(uint32_t row);
+
+    // Hand out up to requested kl from row's stock; returns what was given
+    double dispense(uint32_t row, double requested);
+
+    double getStock(uint32_t row)    const { return stock[row]; }
+    double getRate(uint32_t row)     const { return rate[row]; }
+    double getCapacity(uint32_t row) const { return capacity[row]; }
+
+    /**
+     * Outlook of every row (indexed by row) when the arrivals come in, from
+     * the stocks now; production is counted per tick before the ships of
+     * that tick arrive, as Model::go() runs it.
+     */
+    void forecast(const vector<PortArrival>& arrivals, vector<PortOutlook>& out) const;
+
+private:
+    vector<double> stock;    // kl held
+    vector<double> rate;     // kl produced per tick
+    vector<double> capacity; // kl the port can hold; UNLIMITED_STORAGE if no limit
+
+    // forecast() scratch
+    mutable vector<uint32_t>    offsets;
+    mutable vector<PortArrival> byRow;
+};
+
+#endif //INC_74_EX3_PORTECONOMY_H
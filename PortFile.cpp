@@ -0,0 +1,92 @@
+//
+// Created by hadar on 25/02/2026.
+//
+
+#include "PortFile.h"
+#include "Model.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+
+// Build "Error (line N): msg"
+static runtime_error lineError(int lineNum, const string& msg) {
+    return runtime_error("Error (line " + to_string(lineNum) + "): " + msg);
+}
+
+PortTable readPortFile(const string& path) {
+    ifstream portFile(path);
+    if (!portFile.is_open())
+        throw runtime_error("Error: cannot open port file '" + path + "'");
+
+    PortTable ports;
+    string line;
+    int lineNum = 0;
+    while (getline(portFile, line)) {
+        ++lineNum;
+
+        // Skip blanks
+        istringstream probe(line);
+        string firstTok;
+        if (!(probe >> firstTok)) continue;
+
+        //name
+        string name = firstTok;
+        if (name.size() > 12)
+            throw lineError(lineNum, "port name too long: " + name);
+
+        // coordinates: "(x," and "y)" as two tokens
+        string coordA, coordB;
+        if (!(probe >> coordA >> coordB))
+            throw lineError(lineNum, "expected coordinates after port name");
+        // Join and strip parentheses/comma
+        string coordStr = coordA + coordB;
+        string inner;
+        for (char c : coordStr)
+            if (c != '(' && c != ')') inner += c;
+        for (char& c : inner)
+            if (c == ',') c = ' ';
+        istringstream coordSS(inner);
+        double x, y;
+        if (!(coordSS >> x >> y))
+            throw lineError(lineNum, "invalid coordinates");
+
+        // initialFuel and fuelRate
+        double initialFuel, fuelRate;
+        if (!(probe >> initialFuel >> fuelRate))
+            throw lineError(lineNum, "expected initialFuel and fuelRate");
+        if (initialFuel < 0 || fuelRate < 0)
+            throw lineError(lineNum, "fuel values must be non-negative");
+
+        // optional storage capacity
+        double capacity = UNLIMITED_STORAGE;
+        string capTok;
+        if (probe >> capTok) {
+            size_t idx = 0;
+            try { capacity = stod(capTok, &idx); }
+            catch (...) { idx = 0; }
+            if (idx != capTok.size() || !(capacity > 0))
+                throw lineError(lineNum, "capacity must be a positive number");
+            if (initialFuel > capacity)
+                throw lineError(lineNum, "initialFuel exceeds capacity");
+        }
+
+        ports.push_back(PortSpec{ name, x, y, initialFuel, fuelRate, capacity, lineNum });
+    }
+    return ports;
+}
+
+void addPorts(Model& model, const PortTable& ports) {
+    for (const PortSpec& p : ports) {
+        // throws if the name already exists
+        try {
+            model.addPort(p.name, p.x, p.y, p.initialFuel, p.fuelRate, p.capacity);
+        } catch (const runtime_error& e) {
+            throw lineError(p.line, e.what());
+        }
+    }
+}
+
+void loadPortFile(Model& model, const string& path) {
+    addPorts(model, readPortFile(path));
+}
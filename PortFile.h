@@ -0,0 +1,43 @@
+//
+// PortFile: loader for the port definition file given on the command line.
+// Shared by the interactive simulator and the headless tools.
+//
+
+#ifndef INC_74_EX3_PORTFILE_H
+#define INC_74_EX3_PORTFILE_H
+
+#include <string>
+#include <vector>
+#include "PortEconomy.h"
+using namespace std;
+
+class Model;
+
+// One port as defined in the file
+struct PortSpec {
+    string name;
+    double x, y;
+    double initialFuel, fuelRate;
+    double capacity; // UNLIMITED_STORAGE when the line gives none
+    int    line;     // in the file, for error messages
+};
+
+// A parsed port file; immutable once read, so any number of worlds can be built from one
+using PortTable = vector<PortSpec>;
+
+/**
+ * Parse a port file.
+ * Format per line:  <name> (<x>, <y>) <initialFuel> <fuelRate> [<capacity>]
+ * capacity caps the port's stock (kl); without it the port has no storage limit.
+ * Empty lines and lines consisting only of whitespace are skipped.
+ * Throws runtime_error with a ready-to-print message on any file or parse error.
+ */
+PortTable readPortFile(const string& path);
+
+// Add every port to model (throws runtime_error "Error (line N): ..." on a duplicate name)
+void addPorts(Model& model, const PortTable& ports);
+
+// readPortFile() and addPorts() in one
+void loadPortFile(Model& model, const string& path);
+
+#endif //INC_74_EX3_PORTFILE_H
@@ -0,0 +1,200 @@
+//
+// Profiler implementation
+//
+#include "Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+namespace {
+
+const char* const EVENT_NAMES[PERF_EVENTS] = { "cycles", "instructions", "cache misses", "branch misses" };
+
+const char* const PHASE_NAMES[PROFILE_PHASES] = {
+    "ports", "freighters", "patrol boats", "cruisers", "sub-stepped", "bookkeeping", "draw"
+};
+
+const int CALIBRATION_SAMPLES = 32;
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef __linux__
+const uint64_t EVENT_CONFIG[PERF_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// Why perf_event_open failed, in the terms someone tuning would act on
+string openError(int code) {
+    switch (code) {
+    case ENOENT:
+    case ENODEV:
+    case EOPNOTSUPP: return "no hardware counters on this machine";
+    case EACCES:
+    case EPERM:      return "not permitted (see /proc/sys/kernel/perf_event_paranoid)";
+    case ENOSYS:     return "perf_event_open is not supported by this kernel";
+    default:         return strerror(code);
+    }
+}
+#endif
+
+} // namespace
+
+// PerfCounters
+
+PerfCounters::PerfCounters() {
+    fill(fd, fd + PERF_EVENTS, -1);
+    fill(slot, slot + PERF_EVENTS, -1);
+#ifdef __linux__
+    string reason;
+    for (int e = 0; e < PERF_EVENTS; ++e) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.config         = EVENT_CONFIG[e];
+        attr.disabled       = leader < 0; // the group starts when its leader is enabled
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long r = syscall(SYS_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+        if (r < 0) {
+            reason = openError(errno);
+            if (!error.empty()) error += ", ";
+            error += string(EVENT_NAMES[e]) + ": " + reason;
+            continue;
+        }
+        fd[e] = static_cast<int>(r);
+        if (leader < 0) leader = fd[e];
+        slot[e] = opened++;
+    }
+    if (leader < 0) error = reason; // every event failed, most likely for the same reason
+    if (leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+    error = "hardware counters need Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int f : fd)
+        if (f >= 0) close(f);
+#endif
+}
+
+void PerfCounters::read(PerfSample& s) const {
+    s.ns = nowNs();
+#ifdef __linux__
+    if (leader < 0) return;
+    uint64_t buf[3 + PERF_EVENTS]; // nr, time enabled, time running, values
+    if (::read(leader, buf, sizeof(buf)) < static_cast<ssize_t>((3 + opened) * sizeof(uint64_t))) return;
+    // Multiplexed with other groups: scale up by the share of time the group was counting
+    double scale = buf[2] > 0 && buf[2] < buf[1] ? static_cast<double>(buf[1]) / buf[2] : 1.0;
+    for (int e = 0; e < PERF_EVENTS; ++e)
+        if (slot[e] >= 0) s.count[e] = static_cast<uint64_t>(buf[3 + slot[e]] * scale);
+#endif
+}
+
+// TickProfiler
+
+TickProfiler::TickProfiler() {
+    PerfSample a, b;
+    for (int e = 0; e < PERF_EVENTS; ++e) cost.count[e] = UINT64_MAX;
+    cost.ns = UINT64_MAX;
+    for (int i = 0; i < CALIBRATION_SAMPLES; ++i) {
+        counters.read(a);
+        counters.read(b);
+        for (int e = 0; e < PERF_EVENTS; ++e) cost.count[e] = min(cost.count[e], b.count[e] - a.count[e]);
+        cost.ns = min(cost.ns, b.ns - a.ns);
+    }
+    counters.read(last);
+}
+
+void TickProfiler::beginTick() {
+    ++ticks;
+    counters.read(last);
+}
+
+void TickProfiler::beginDraw() {
+    ++draws;
+    counters.read(last);
+}
+
+void TickProfiler::mark(ProfilePhase phase, size_t items) {
+    PerfSample now;
+    counters.read(now);
+    Totals& t = phases[phase];
+    since(last, now, cost, t);
+    ++t.runs;
+    t.items += items;
+    last = now;
+}
+
+void TickProfiler::since(const PerfSample& from, const PerfSample& to, const PerfSample& bias, Totals& into) {
+    auto net = [](uint64_t delta, uint64_t b) { return delta > b ? delta - b : 0; };
+    for (int e = 0; e < PERF_EVENTS; ++e) into.count[e] += net(to.count[e] - from.count[e], bias.count[e]);
+    into.ns += net(to.ns - from.ns, bias.ns);
+}
+
+void TickProfiler::reset() {
+    for (Totals& t : phases) t = Totals();
+    ticks = draws = 0;
+}
+
+void TickProfiler::report(ostream& out) const {
+    const bool cyc = counters.has(PerfCycles), ins = counters.has(PerfInstructions);
+    const bool cm = counters.has(PerfCacheMisses), bm = counters.has(PerfBranchMisses);
+    auto per = [](uint64_t n, uint64_t d) { return d ? static_cast<double>(n) / d : 0.0; };
+
+    out << fixed << setprecision(2);
+    out << "Profile over " << ticks << (ticks == 1 ? " tick, " : " ticks, ") << draws << (draws == 1 ? " draw" : " draws");
+    if (!counters.any()) out << " (wall time only: " << counters.getError() << ")\n";
+    else if (!counters.getError().empty()) out << " (missing " << counters.getError() << ")\n";
+    else out << "\n";
+
+    out << "  " << left << setw(13) << "phase" << right << setw(8) << "runs" << setw(10) << "objects"
+        << setw(10) << "ms" << setw(10) << "ns/obj";
+    if (cyc) out << setw(10) << "cyc/obj";
+    if (cyc && ins) out << setw(7) << "IPC";
+    if (cm) out << setw(11) << "cmiss/obj";
+    if (bm) out << setw(11) << "bmiss/obj";
+    out << "\n";
+
+    Totals tick;
+    for (int p = 0; p < PROFILE_PHASES; ++p) {
+        const Totals& t = phases[p];
+        if (t.runs == 0) continue;
+        if (p != PhaseDraw) {
+            for (int e = 0; e < PERF_EVENTS; ++e) tick.count[e] += t.count[e];
+            tick.ns += t.ns;
+        }
+        out << "  " << left << setw(13) << PHASE_NAMES[p] << right << setw(8) << t.runs << setw(10) << t.items
+            << setw(10) << t.ns / 1e6 << setw(10) << per(t.ns, t.items);
+        if (cyc) out << setw(10) << per(t.count[PerfCycles], t.items);
+        if (cyc && ins) out << setw(7) << per(t.count[PerfInstructions], t.count[PerfCycles]);
+        if (cm) out << setw(11) << per(t.count[PerfCacheMisses], t.items);
+        if (bm) out << setw(11) << per(t.count[PerfBranchMisses], t.items);
+        out << "\n";
+    }
+    if (ticks == 0) return;
+    out << "  per tick: " << per(tick.ns, ticks) / 1e6 << " ms";
+    for (int e = 0; e < PERF_EVENTS; ++e)
+        if (counters.has(static_cast<PerfEvent>(e)))
+            out << ", " << setprecision(0) << per(tick.count[e], ticks) << " " << EVENT_NAMES[e] << setprecision(2);
+    if (cyc && ins) out << ", IPC " << per(tick.count[PerfInstructions], tick.count[PerfCycles]);
+    out << "\n";
+}
@@ -0,0 +1,121 @@
+//
+// Profiler: hardware counters (cycles, instructions, cache misses, branch
+// misses) and wall time attributed to the phases of a tick and to drawing,
+// for checking what a layout change does to the hot loops.
+//
+// PerfCounters is one perf_event_open group on the calling thread, read with
+// a single read() per sample. TickProfiler samples it at each phase boundary
+// of Model::go() and around View::draw() and adds the delta to the phase that
+// just ran; ship updates are split by type at every change of type in storage
+// order (one sample per run of same-type ships). The cost of a sample itself,
+// measured when profiling starts, is taken off every delta. A read() of the
+// group is a system call (some 0.3 us), so a fleet whose types interleave in
+// storage ticks markedly slower while profiled, though its counts stay clean.
+//
+// Counters are per thread: they count the thread that started profiling,
+// which must be the one that runs the world. Where counters cannot be opened
+// (not Linux, no PMU in a VM, perf_event_paranoid too strict) the profile
+// keeps wall time only and says why.
+//
+
+#ifndef INC_74_EX3_PROFILER_H
+#define INC_74_EX3_PROFILER_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "ShipTraits.h"
+using namespace std;
+
+// Counted events, in group order
+enum PerfEvent : uint8_t { PerfCycles, PerfInstructions, PerfCacheMisses, PerfBranchMisses, PERF_EVENTS };
+
+// Cumulative counts since the group was opened (0 for an event that is not open)
+struct PerfSample {
+    uint64_t count[PERF_EVENTS] = {};
+    uint64_t ns = 0; // steady clock
+};
+
+class PerfCounters {
+public:
+    // Open every event it can on the calling thread, user space only, and start counting
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool has(PerfEvent e) const { return fd[e] >= 0; }
+    bool any() const { return leader >= 0; }
+
+    // Why events are missing ("" if all are open)
+    const string& getError() const { return error; }
+
+    // Current counts, scaled up if the kernel multiplexed the group
+    void read(PerfSample& s) const;
+
+private:
+    int fd[PERF_EVENTS];
+    int leader = -1;
+    int slot[PERF_EVENTS]; // position of each event's value in a group read
+    int opened = 0;
+    string error;
+};
+
+// What a profile attributes time and counts to
+enum ProfilePhase : uint8_t {
+    PhasePorts,       // fuel production
+    PhaseFreighters,  // ship updates, by type
+    PhasePatrols,
+    PhaseCruisers,
+    PhaseSubstepped,  // all ship motion when sub-stepping (see Model::setSubsteps)
+    PhaseBookkeeping, // the rest of a tick: trajectories, encounters, voyages, snapshot
+    PhaseDraw,        // View::draw
+    PROFILE_PHASES
+};
+
+class TickProfiler {
+public:
+    // Opens the counters on the calling thread and calibrates the cost of a sample
+    TickProfiler();
+
+    // Start of a tick / of a draw: the next mark() measures from here
+    void beginTick();
+    void beginDraw();
+
+    // The phase that ran since the last mark or begin is over; it handled items objects
+    void mark(ProfilePhase phase, size_t items);
+
+    // Phase of a ship type's updates
+    static ProfilePhase phaseOf(ShipType type) { return static_cast<ProfilePhase>(PhaseFreighters + type); }
+    static_assert(PhaseSubstepped - PhaseFreighters == SHIP_KINDS,
+                  "one ship update phase per ShipType, in ShipType order, from PhaseFreighters");
+
+    // Drop what has been gathered (counters stay open)
+    void reset();
+
+    /**
+     * Per phase: runs, objects, time, and (with counters) cycles, IPC, and
+     * cache and branch misses per object, plus totals per tick.
+     */
+    void report(ostream& out) const;
+
+private:
+    struct Totals {
+        uint64_t runs  = 0;
+        uint64_t items = 0;
+        uint64_t count[PERF_EVENTS] = {};
+        uint64_t ns = 0;
+    };
+
+    PerfCounters counters;
+    PerfSample   last;
+    PerfSample   cost;  // least delta between back-to-back samples
+    Totals       phases[PROFILE_PHASES];
+    uint64_t     ticks = 0;
+    uint64_t     draws = 0;
+
+    static void since(const PerfSample& from, const PerfSample& to, const PerfSample& bias, Totals& into);
+};
+
+#endif //INC_74_EX3_PROFILER_H
@@ -0,0 +1,135 @@
+//
+// Proximity implementation
+//
+#include "Proximity.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+using namespace std;
+
+ProximityDetector::ProximityDetector(double threshold) : threshold(0) {
+    setThreshold(threshold);
+}
+
+void ProximityDetector::setThreshold(double nm) {
+    if (nm < 0) throw runtime_error("proximity threshold must not be negative");
+    threshold = nm;
+}
+
+void ProximityDetector::begin(const vector<shared_ptr<Ship>>& ships) {
+    size_t n = ships.size();
+    x0.resize(n);
+    y0.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        x0[i] = ships[i]->getCorX();
+        y0[i] = ships[i]->getCorY();
+    }
+}
+
+bool ProximityDetector::closestApproach(const Body& a, const Body& b, double& t, double& distance) const {
+    double vx = b.dx - a.dx, vy = b.dy - a.dy;
+    double px = b.x0 - a.x0, py = b.y0 - a.y0;
+    double limit = threshold * threshold;
+    if (px * px + py * py <= limit) return false; // already this close when the hour began
+    double vv = vx * vx + vy * vy;
+    if (vv == 0) return false; // same motion (or neither moved): the distance never changes
+    t = -(px * vx + py * vy) / vv;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    double cx = px + vx * t, cy = py + vy * t;
+    double d2 = cx * cx + cy * cy;
+    if (d2 > limit) return false;
+    distance = sqrt(d2);
+    return true;
+}
+
+void ProximityDetector::finish(const vector<shared_ptr<Ship>>& ships, const vector<uint64_t>& seq,
+                               int tickStart, vector<Encounter>& out) {
+    out.clear();
+    size_t n = ships.size();
+    if (n < 2 || x0.size() != n) return;
+
+    // Motion over the hour and the largest bounding box extent
+    dx.resize(n);
+    dy.resize(n);
+    double extent = 0;
+    for (size_t i = 0; i < n; ++i) {
+        dx[i] = ships[i]->getCorX() - x0[i];
+        dy[i] = ships[i]->getCorY() - y0[i];
+        extent = max(extent, max(fabs(dx[i]), fabs(dy[i])));
+    }
+    if (extent == 0) return; // nobody moved
+
+    // Bin every ship by the centre of its swept segment. Cells are at least as
+    // wide as any grown bounding box; coordinates are clamped far outside any
+    // sensible world so the packed key cannot overflow.
+    const double cell = extent + threshold;
+    const double LIMIT = 1e9;
+    auto coord = [&](double v) {
+        double c = floor(v / cell);
+        c = c < -LIMIT ? -LIMIT : (c > LIMIT ? LIMIT : c);
+        return static_cast<uint64_t>(static_cast<int64_t>(c) + (int64_t(1) << 31));
+    };
+    auto keyOf = [&](uint32_t i) { return coord(y0[i] + dy[i] / 2) << 32 | coord(x0[i] + dx[i] / 2); };
+    auto before = [](const Keyed& a, const Keyed& b) {
+        return a.cell != b.cell ? a.cell < b.cell : a.ship < b.ship;
+    };
+    if (keyed.size() != n) { // first tick or ships were added: full sort
+        keyed.resize(n);
+        for (uint32_t i = 0; i < n; ++i) keyed[i] = Keyed{ keyOf(i), i };
+        sort(keyed.begin(), keyed.end(), before);
+    } else {
+        // Last tick's order is nearly right (few ships change cell per hour):
+        // insertion sort, unless that turns out to be a lot of work
+        for (Keyed& k : keyed) k.cell = keyOf(k.ship);
+        size_t budget = 8 * n;
+        for (size_t i = 1; i < n && budget > 0; ++i) {
+            Keyed k = keyed[i];
+            size_t j = i;
+            for (; j > 0 && before(k, keyed[j - 1]) && budget > 0; --j, --budget) keyed[j] = keyed[j - 1];
+            keyed[j] = k;
+        }
+        if (budget == 0) sort(keyed.begin(), keyed.end(), before);
+    }
+    bodies.resize(n);
+    cells.clear();
+    for (uint32_t k = 0; k < n; ++k) {
+        uint32_t i = keyed[k].ship;
+        bodies[k] = Body{x0[i], y0[i], dx[i], dy[i], i};
+        if (cells.empty() || cells.back().key != keyed[k].cell) cells.push_back(Cell{keyed[k].cell, k, k});
+        cells.back().end = k + 1;
+    }
+
+    // Each cell against itself and four of its neighbours (the other four see it
+    // from their side): the next column, found right after it in key order, and
+    // the three cells of the next row, found with a cursor that only moves forward
+    const uint64_t ROW = uint64_t(1) << 32;
+    hits.clear();
+    double t, distance;
+    auto test = [&](const Body& a, const Body& b) {
+        if (closestApproach(a, b, t, distance))
+            hits.push_back(seq[a.ship] < seq[b.ship] ? Hit{a.ship, b.ship, t, distance}
+                                                     : Hit{b.ship, a.ship, t, distance});
+    };
+    auto testCells = [&](const Cell& a, const Cell& b) {
+        for (uint32_t i = a.begin; i < a.end; ++i)
+            for (uint32_t j = b.begin; j < b.end; ++j) test(bodies[i], bodies[j]);
+    };
+    size_t up = 0;
+    for (size_t ci = 0; ci < cells.size(); ++ci) {
+        const Cell& c = cells[ci];
+        for (uint32_t i = c.begin; i < c.end; ++i)
+            for (uint32_t j = i + 1; j < c.end; ++j) test(bodies[i], bodies[j]);
+        if (ci + 1 < cells.size() && cells[ci + 1].key == c.key + 1) testCells(c, cells[ci + 1]);
+        uint64_t first = c.key + ROW - 1; // next row, previous column
+        while (up < cells.size() && cells[up].key < first) ++up;
+        for (size_t u = up; u < cells.size() && cells[u].key <= first + 2; ++u) testCells(c, cells[u]);
+    }
+
+    sort(hits.begin(), hits.end(), [&seq](const Hit& p, const Hit& q) {
+        if (p.t != q.t) return p.t < q.t;
+        return seq[p.a] != seq[q.a] ? seq[p.a] < seq[q.a] : seq[p.b] < seq[q.b];
+    });
+    out.reserve(hits.size());
+    for (const Hit& h : hits)
+        out.push_back(Encounter{ ships[h.a]->getNameId(), ships[h.b]->getNameId(), tickStart + h.t, h.distance });
+}
@@ -0,0 +1,92 @@
+//
+// Proximity: detects ships coming within a threshold distance of each other
+// during a tick, using the swept segment each ship travelled (start to end of
+// the hour, at constant velocity), not just the end positions.
+//
+// Broad phase: a uniform grid whose cells are at least as large as any swept
+// segment's bounding box grown by the threshold, so a pair only needs testing
+// when the two ships sit in the same or adjacent cells (each adjacent pair of
+// cells is visited once). The grid is unbounded: ships are sorted by cell key
+// (row-major) and neighbouring cells are found by walking that order, so a few
+// far-flung ships do not blow up the grid. Narrow phase: exact closest approach
+// of the two linear motions over the hour.
+//
+// Events are edge-triggered: a pair is reported when it comes within the
+// threshold during the hour having started the hour further apart, so escorts
+// and ships moored side by side are reported once, not every tick.
+//
+
+#ifndef INC_74_EX3_PROXIMITY_H
+#define INC_74_EX3_PROXIMITY_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "NameTable.h"
+#include "Ship.h"
+using namespace std;
+
+struct Encounter {
+    NameId first;    // the ship created earlier
+    NameId second;
+    double time;     // simulation time of closest approach (fractional hours)
+    double distance; // closest approach in nm
+};
+
+class ProximityDetector {
+public:
+    // threshold in nm; 0 disables detection
+    explicit ProximityDetector(double threshold = 0);
+
+    void   setThreshold(double nm);
+    double getThreshold() const { return threshold; }
+    bool   enabled()      const { return threshold > 0; }
+
+    // Capture every ship's position before the tick moves them
+    void begin(const vector<shared_ptr<Ship>>& ships);
+
+    // Compare with the positions after the tick; events for the hour starting at
+    // tickStart replace the contents of out, ordered by time then by creation
+    // order (seq: each ship's creation sequence number, indexed like ships)
+    void finish(const vector<shared_ptr<Ship>>& ships, const vector<uint64_t>& seq,
+                int tickStart, vector<Encounter>& out);
+
+private:
+    double threshold;
+
+    // Per ship (indexed like Model's ships): motion over the tick
+    vector<double> x0, y0, dx, dy;
+
+    // A ship's motion, copied into cell order so the pair loops read memory sequentially
+    struct Body {
+        double   x0, y0, dx, dy;
+        uint32_t ship; // index into ships
+    };
+
+    struct Keyed {
+        uint64_t cell; // packed (row, column)
+        uint32_t ship;
+    };
+    struct Cell {
+        uint64_t key;
+        uint32_t begin, end; // range in bodies
+    };
+
+    // A pair found by the narrow phase, before it is turned into an Encounter
+    struct Hit {
+        uint32_t a, b; // ship indices, a created before b
+        double   t;    // fraction of the hour
+        double   distance;
+    };
+
+    // Grid (rebuilt every tick)
+    vector<Keyed> keyed;  // ships sorted by cell
+    vector<Body>  bodies; // grouped by cell, in that order
+    vector<Cell>  cells;  // non-empty cells, sorted by key
+    vector<Hit>   hits;   // pairs found this tick
+
+    // Closest approach of two bodies over the hour; true and sets t / distance if it is an encounter
+    bool closestApproach(const Body& a, const Body& b, double& t, double& distance) const;
+};
+
+#endif //INC_74_EX3_PROXIMITY_H
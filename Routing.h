@@ -0,0 +1,106 @@
+//
+// Routing: sea routes around land and no-go areas.
+//
+// Obstacles are polygons (loaded with loadObstacleFile). They are rasterized
+// once into a navigation grid covering their bounding box plus a margin of open
+// water: a cell is blocked if it touches any polygon at all, so a path through
+// free cell centres never clips an obstacle. Routes are found with A* on the
+// grid (8 neighbours, no corner cutting) and then shortened by string pulling:
+// each waypoint is joined to the furthest later one in clear line of sight, so
+// a route is a handful of straight legs, not a staircase of cells.
+//
+// Port-to-port routes are cached in an LRU keyed by (origin, destination), and
+// handed out as shared immutable waypoint lists: a thousand freighters on the
+// same lane share one search and one copy of the route.
+//
+
+#ifndef INC_74_EX3_ROUTING_H
+#define INC_74_EX3_ROUTING_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "NameTable.h"
+#include "Sim_object.h"
+using namespace std;
+
+using Polygon = vector<Location>;
+using Route   = vector<Location>; // waypoints after the start; the last one is the destination
+
+static const int    ROUTE_GRID_CELLS     = 512;  // cells along the longer side of the navigation grid
+static const size_t ROUTE_CACHE_CAPACITY = 1024; // port-to-port routes kept (least recently used go first)
+
+class Router {
+public:
+    // Replace the obstacles and rebuild the grid; drops every cached route. No polygons = open sea.
+    void setObstacles(vector<Polygon> polygons);
+
+    bool   enabled()          const { return !obstacles.empty(); }
+    size_t getObstacleCount() const { return obstacles.size(); }
+
+    /**
+     * Route from one point to another, around the obstacles. A clear straight
+     * line is a single waypoint. Points on or inside an obstacle (a port on the
+     * coast) connect to the nearest open cell. nullptr if the destination cannot
+     * be reached by sea.
+     */
+    shared_ptr<const Route> route(Location from, Location to);
+
+    // Same, between two ports, through the cache
+    shared_ptr<const Route> portRoute(NameId fromPort, Location from, NameId toPort, Location to);
+
+    // Forget every cached route
+    void clearCache();
+
+    // Forget the cached routes from and to a port (it was removed, so its name may come back elsewhere)
+    void forgetPort(NameId port);
+
+    // Port-to-port lookups answered from the cache / computed
+    size_t getCacheHits()   const { return hits; }
+    size_t getCacheMisses() const { return misses; }
+
+private:
+    vector<Polygon> obstacles;
+
+    // Navigation grid: cell (c, r) covers [originX + c*cell, +cell) x [originY + r*cell, +cell)
+    double originX = 0, originY = 0, cell = 1;
+    int    cols = 0, rows = 0;
+    vector<uint8_t> blocked; // row-major
+
+    // A* scratch, reused between searches; entries are valid where seen == stamp
+    vector<float>    g;
+    vector<int32_t>  parent;
+    vector<uint32_t> seen;
+    uint32_t stamp = 0;
+
+    // LRU: most recently used at the front
+    using CacheEntry = pair<uint64_t, shared_ptr<const Route>>;
+    list<CacheEntry> lru;
+    unordered_map<uint64_t, list<CacheEntry>::iterator> cached;
+    size_t hits = 0, misses = 0;
+
+    void rasterize(const Polygon& poly);
+
+    // Visit every cell the segment a-b passes through (both cells where it crosses a corner),
+    // clipped to the grid; stops early and returns false when visit does
+    template <typename Visit>
+    bool traverse(Location a, Location b, Visit visit) const;
+
+    // True if a-b crosses no blocked cell, ignoring the cells a and b lie in
+    bool clear(Location a, Location b) const;
+
+    // Cell containing p, clamped to the grid
+    int cellOf(Location p) const;
+    Location centre(int index) const;
+
+    // Nearest open cell to index (itself if open), or -1 if there is none
+    int nearestOpen(int index) const;
+
+    // A* between two open cells; fills path (start to goal) and returns false if unreachable
+    bool search(int start, int goal, vector<int>& path);
+};
+
+#endif //INC_74_EX3_ROUTING_H
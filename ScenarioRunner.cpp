@@ -0,0 +1,81 @@
+//
+// ScenarioRunner implementation
+//
+#include "ScenarioRunner.h"
+#include "Controller.h"
+#include "Model.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <sstream>
+#include <thread>
+#include <time.h>
+using namespace std;
+
+// CPU time of the calling thread in seconds (wall time where there is no per-thread clock)
+static double threadCpuSeconds() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+ScenarioRunner::ScenarioRunner(shared_ptr<const PortTable> ports, vector<Polygon> obstacles,
+                               WorldSettings settings)
+    : ports(move(ports)), obstacles(move(obstacles)), settings(settings) {}
+
+ScenarioResult ScenarioRunner::runOne(const Scenario& scenario) const {
+    ScenarioResult result;
+    double start = threadCpuSeconds();
+    ostringstream output;
+    try {
+        Model model(output);
+        model.setNavigation(settings.navigation);
+        if (settings.fuelModel) model.setFuelModel(settings.fuelModel);
+        model.setSubsteps(settings.substeps);
+        model.setProximityThreshold(settings.proximity);
+        model.setTrackDepth(settings.trackDepth);
+        addPorts(model, *ports);
+        if (!obstacles.empty()) model.setObstacles(obstacles);
+
+        Controller controller(model, output, output);
+        controller.execute(*scenario.script);
+        while (model.getTime() < settings.minTicks) model.go();
+
+        ostringstream status;
+        model.printStatus(status);
+        result.time    = model.getTime();
+        result.objects = model.getAllObjects().size();
+        result.status  = status.str();
+    } catch (const exception& e) {
+        result.error = e.what();
+    }
+    result.output     = output.str();
+    result.cpuSeconds = threadCpuSeconds() - start;
+    return result;
+}
+
+/**
+ * Workers claim scenarios through one atomic counter and write each result to
+ * its own slot, so they never wait on each other.
+ */
+vector<ScenarioResult> ScenarioRunner::run(const vector<Scenario>& scenarios, unsigned threads) const {
+    vector<ScenarioResult> results(scenarios.size());
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = static_cast<unsigned>(min<size_t>(threads, scenarios.size()));
+
+    atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i = next++; i < scenarios.size(); i = next++)
+            results[i] = runOne(scenarios[i]);
+    };
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work);
+    work(); // the calling thread is one of the workers
+    for (thread& w : workers) w.join();
+    return results;
+}
@@ -0,0 +1,76 @@
+//
+// ScenarioRunner: many independent worlds at once on a pool of threads.
+//
+// A scenario is a command script replayed through a world of its own: a Model
+// built from the shared port table, driven by a Controller bound to it, with
+// everything the world prints (command output, errors, tick events) captured
+// in its result. Worlds share nothing mutable, so a fixed set of worker
+// threads simply claims the next scenario until none are left; results come
+// back in scenario order whatever the thread count, and a world's result does
+// not depend on which thread ran it or what ran next to it.
+//
+// What the worlds do share is read-only while they run: the parsed port table,
+// compiled command scripts (CommandScript.h: parsed once, however many worlds
+// replay them) and the fuel model (FuelModel.h), plus the process-wide
+// interned names (NameTable.h), which any thread may read and add to.
+//
+
+#ifndef INC_74_EX3_SCENARIORUNNER_H
+#define INC_74_EX3_SCENARIORUNNER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "CommandScript.h"
+#include "FuelModel.h"
+#include "Geodesy.h"
+#include "PortFile.h"
+#include "Routing.h"
+#include "TrajectoryLog.h"
+using namespace std;
+
+// Per-world settings (see the matching Model setters)
+struct WorldSettings {
+    int    substeps   = 1;
+    double proximity  = 0;
+    size_t trackDepth = DEFAULT_TRACK_DEPTH;
+    long   minTicks   = 0; // ticks run after the script until the world has run this many
+    Navigation navigation = Planar;
+    shared_ptr<const FuelModel> fuelModel; // null: the default (constant)
+};
+
+struct Scenario {
+    string name;                             // for reports, e.g. the script's file name
+    shared_ptr<const CommandScript> script; // may be shared by many scenarios
+};
+
+struct ScenarioResult {
+    int    time       = 0; // simulation time at the end
+    size_t objects    = 0;
+    string status;         // final "status" output
+    string output;         // everything the world printed while it ran
+    string error;          // why the world could not be built; empty if it ran
+    double cpuSeconds = 0; // CPU time of the world on its thread (other worlds do not inflate it)
+};
+
+class ScenarioRunner {
+public:
+    // Worlds start from ports with obstacles (none = open sea), configured by settings
+    ScenarioRunner(shared_ptr<const PortTable> ports, vector<Polygon> obstacles, WorldSettings settings);
+
+    /**
+     * Run every scenario in a world of its own on up to threads worker threads
+     * (0 = one per hardware thread). Returns the results in scenario order.
+     */
+    vector<ScenarioResult> run(const vector<Scenario>& scenarios, unsigned threads) const;
+
+    // Build a world, replay one scenario in it and report (on the calling thread)
+    ScenarioResult runOne(const Scenario& scenario) const;
+
+private:
+    shared_ptr<const PortTable> ports;
+    vector<Polygon>             obstacles;
+    WorldSettings               settings;
+};
+
+#endif //INC_74_EX3_SCENARIORUNNER_H
@@ -3,156 +3,260 @@
 //
 
 #include "Ship.h"
+#include "FuelModel.h"
 #include <cmath>
 #include <iomanip>
-#include <sstream>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+namespace {
+
+const ConstantFuelModel CONSTANT_FUEL;
+
+} // namespace
+
 // Default constructor
-Ship::Ship()
+Ship::Ship(ShipType type)
       : Sim_object("", 0.0, 0.0),
-      attackStat(0), speed(0), heading(0),
-      fuel(0), fuelConsumption(0), maxSpeed(0), maxFuel(0),
-      state(Stopped), destX(0), destY(0) {}
+      attackStat(0), type(type), state(Stopped), routed(false), speed(0), dirX(0), dirY(1),
+      fuel(0), destX(0), destY(0), remaining(0), destPort(NO_NAME), index(0), tables(nullptr) {}
 
 
 // Parameterized constructor used by derived classes - initializes all members
-Ship::Ship(const string& name, double corX, double corY,
-           double speed, double heading,
-           double fuel, int fuelConsumption, int attackStat,
-           double maxSpeed, double maxFuel)
+Ship::Ship(ShipType type, const string& name, double corX, double corY,
+           double speed, double heading, double fuel, int attackStat)
     : Sim_object(name, corX, corY),
-      attackStat(attackStat), speed(speed), heading(heading),
-      fuel(fuel), fuelConsumption(fuelConsumption),
-      maxSpeed(maxSpeed), maxFuel(maxFuel),
-      state(Stopped), destX(0), destY(0) {}
+      attackStat(attackStat), type(type), state(Stopped), routed(false), speed(speed), dirX(0), dirY(1),
+      fuel(fuel), destX(0), destY(0), remaining(0), destPort(NO_NAME), index(0), tables(nullptr) {
+    setHeading(heading);
+}
 
 //getter, inline
+ShipType Ship::getType()          const { return type; }
 double Ship::getCorX()            const { return corX; }
 double Ship::getCorY()            const { return corY; }
 double Ship::getSpeed()           const { return speed; }
-double Ship::getHeading()         const { return heading; }
 double Ship::getFuel()            const { return fuel; }
-double Ship::getMaxFuel()         const { return maxFuel; }
-double Ship::getMaxSpeed()        const { return maxSpeed; }
-int    Ship::getFuelConsumption() const { return fuelConsumption; }
+double Ship::getMaxFuel()         const { return SHIP_TRAITS[type].maxFuel; }
+double Ship::getMaxSpeed()        const { return SHIP_TRAITS[type].maxSpeed; }
+int    Ship::getFuelConsumption() const { return SHIP_TRAITS[type].fuelRate; }
 int    Ship::getAttackStat()      const { return attackStat; }
 State  Ship::getState()           const { return state; }
-const string& Ship::getDestPortName() const { return destPortName; }
+NameId Ship::getDestPort()        const { return destPort; }
+bool   Ship::hasArrived()         const { return state == Moving && remaining <= 0; }
+
+// The current leg's remaining distance, then the route's later legs
+double Ship::distanceToGo() const {
+    if (state != Moving) return 0;
+    double distance = remaining;
+    if (routed) {
+        const ShipTables::RouteLeg& r = tables->route(index);
+        const Route& route = *r.route;
+        for (size_t i = r.leg + 1; i < route.size(); ++i)
+            distance += distanceNm(tables->navigation(), route[i - 1].first, route[i - 1].second, route[i].first, route[i].second);
+    }
+    return distance;
+}
+
+/**
+ * Compass heading in degrees. On a planar Course this is the commanded value as
+ * given (kept in tables); otherwise it is derived from the direction of travel
+ * (only needed for display). A great circle changes heading as it goes, so
+ * that is the current one.
+ */
+double Ship::getHeading() const {
+    uint32_t slot = arc();
+    if (slot != ShipTables::NO_ARC && (state == Course || (state == Moving && remaining > 0))) return tables->arc(slot).heading();
+    if (state == Course) return commandedHeading();
+    return directionHeading();
+}
+
+double Ship::commandedHeading() const {
+    double h;
+    if (tables && tables->courseHeading(index, h)) return h;
+    return directionHeading();
+}
+
+double Ship::directionHeading() const {
+    double h = atan2(dirX, dirY) * 180.0 / M_PI;
+    if (h < 0) h += 360.0;
+    return h;
+}
 
 // setters, inline
-void Ship::setCorX(double v)    { corX = v; }
-void Ship::setCorY(double v)    { corY = v; }
-void Ship::setSpeed(double v)   { speed = v; }
-void Ship::setHeading(double v) { heading = v; }
-void Ship::setFuel(double v)    { fuel = v; }
+void Ship::setCorX(double v)    { corX = v; touch(); if (state == Moving) aimAtDestination(); else if (state == Course && arc() != ShipTables::NO_ARC) aimAlongCourse(commandedHeading()); }
+void Ship::setCorY(double v)    { corY = v; touch(); if (state == Moving) aimAtDestination(); else if (state == Course && arc() != ShipTables::NO_ARC) aimAlongCourse(commandedHeading()); }
+void Ship::setSpeed(double v)   { speed = v; touch(); }
+void Ship::setFuel(double v)    { fuel = v; touch(); }
+
+// Set heading as its direction vector (the only sin/cos outside of display); on a Course, also the commanded one
+void Ship::setHeading(double v) {
+    touch();
+    double rad = v * M_PI / 180.0;
+    dirX = sin(rad);
+    dirY = cos(rad);
+    if (state != Course || !tables) return;
+    tables->setCourseHeading(index, v);
+    if (arc() != ShipTables::NO_ARC) aimAlongCourse(commandedHeading());
+}
+
+// Aim at (destX, destY): unit vector plus distance left. A zero-length leg points North.
+void Ship::aimAtDestination() {
+    if (geodesic()) {
+        double distance;
+        tables->setArc(*this, GeoArc::toward(corX, corY, destX, destY, distance));
+        remaining = static_cast<real_t>(distance);
+        return;
+    }
+    double dx = destX - corX;
+    double dy = destY - corY;
+    remaining = sqrt(dx * dx + dy * dy);
+    if (remaining > 0) {
+        dirX = dx / remaining;
+        dirY = dy / remaining;
+    } else {
+        dirX = 0;
+        dirY = 1;
+    }
+}
+
+void Ship::aimAlongCourse(double headingDeg) {
+    tables->setArc(*this, GeoArc::onHeading(corX, corY, headingDeg));
+}
+
+const FuelModel& Ship::fuelModel() const {
+    return tables ? tables->fuelModel() : CONSTANT_FUEL;
+}
+
+void Ship::clearArc() {
+    if (arc() != ShipTables::NO_ARC) tables->releaseArc(*this);
+}
+
+void Ship::clearRoute() {
+    if (!routed) return;
+    tables->clearRoute(index);
+    routed = false;
+}
 
 // Stop, clear destination, and move to stop state
 void Ship::stop() {
-    destPortName.clear();
+    destPort = NO_NAME;
     destX = 0;
     destY = 0;
+    clearRoute();
     changeState(Stopped);
 }
 
-// change state, zero speed if stopping/docking/DITW
+void Ship::forgetDestPort() { destPort = NO_NAME; touch(); }
+
+// change state; stopping/docking/DITW zeroes speed and drops the arc, leaving a Course drops its heading
 void Ship::changeState(State newState) {
+    if (state == Course && newState != Course && tables) tables->clearCourseHeading(index);
     state = newState;
-    if (newState == Stopped || newState == Docked || newState == DITW)
+    touch();
+    if (newState == Stopped || newState == Docked || newState == DITW) {
         speed = 0;
+        clearArc();
+    }
 }
 
 // set course: clear destination and move to Course state
 void Ship::setCourse(double headingDeg, double spd) {
-    destPortName.clear();
-    heading = headingDeg;
-    speed   = spd;
+    destPort = NO_NAME;
+    clearRoute();
+    setHeading(headingDeg);
+    if (tables) tables->setCourseHeading(index, headingDeg);
+    if (geodesic()) aimAlongCourse(commandedHeading());
+    speed = spd;
     changeState(Course);
 }
 
 /**
  * Move toward specific coordinates (no named port).
- * Heading: 0=North(+Y), 90=East(+X). atan2(dx,dy) gives compass angle.
+ * The leg is a straight line (a great circle under Geodesic navigation), so
+ * direction and distance are computed once here and update() only steps along them.
  */
 void Ship::setDestination(double cx, double cy, double spd) {
-    destPortName.clear();
+    destPort = NO_NAME;
+    clearRoute();
     destX = cx;
     destY = cy;
     speed = spd;
-    double dx = cx - corX;
-    double dy = cy - corY;
-    double h  = atan2(dx, dy) * 180.0 / M_PI;
-    if (h < 0) h += 360.0;
-    heading = h;
+    aimAtDestination();
     changeState(Moving);
 }
 
 /**
  * Move toward a named port's coordinates.
- * Same math as setDestination but stores the port name for status display.
+ * Same math as setDestination but stores the port ID for status display.
  */
-void Ship::setPortDestination(double cx, double cy, double spd, const string& portName) {
+void Ship::setPortDestination(double cx, double cy, double spd, NameId port) {
     setDestination(cx, cy, spd);
-    destPortName = portName;
+    destPort = port;
+    touch();
+}
+
+/**
+ * Sail a route leg by leg. Only multi-leg routes are kept (shared with every
+ * other ship on the same lane); a single leg is an ordinary destination.
+ */
+void Ship::setRoute(shared_ptr<const Route> waypoints, double spd, NameId port) {
+    const Location& first = waypoints->front();
+    setDestination(first.first, first.second, spd);
+    if (waypoints->size() > 1 && tables) {
+        tables->setRoute(index, move(waypoints));
+        routed = true;
+    }
+    destPort = port;
+    touch();
 }
 
 // Adjust attackStat ±1
 void Ship::setAttackStat(bool victory) {
     if (victory) attackStat++;
     else         attackStat--;
+    touch();
 }
 
-// Refuel: add amount capped at tank capacity
-void Ship::refuel(double amount) {
-    fuel += amount;
-    if (fuel > maxFuel) fuel = maxFuel;
-}
-
-/**
- * update() — advance one time step (1 hour).
- * - Stopped / Docked / DITW: no movement.
- * - No fuel while moving: transition to DITW.
- * - Moving / Course: advance position, consume fuel.
- *   Ships only dock when explicitly commanded (dockAt in model/controller).
- */
-void Ship::update() {
-    if (state == Stopped || state == Docked || state == DITW)
-        return;
-
-    // Out of fuel → dead in the water
-    if (fuelConsumption > 0 && fuel <= 0.0) {
-        cout << getName() << " is out of fuel and is dead in the water.\n";
-        changeState(DITW);
-        return;
-    }
-
-    double rad  = heading * M_PI / 180.0;
-    double step = speed; // distance travelled this step = speed * 1hr
-
+double Ship::moveBy(double step) {
+    const double whole = step;
     if (state == Moving) {
-        // Cap step so we don't overshoot the destination
-        double dx   = destX - corX;
-        double dy   = destY - corY;
-        double dist = sqrt(dx * dx + dy * dy);
-        if (dist < step) step = dist;
-        // Recompute heading toward destination each step
-        double h = atan2(dx, dy) * 180.0 / M_PI;
-        if (h < 0) h += 360.0;
-        heading = h;
-        rad = heading * M_PI / 180.0;
+        // Cap step so we don't overshoot the destination; land exactly on it.
+        // Once sitting on the destination the course reads North (0 deg), as before.
+        if (remaining <= 0) {
+            dirX = 0;
+            dirY = 1;
+            return 0;
+        }
+        // Waypoints reached within the step are passed without losing the rest of it
+        double travelled = 0;
+        while (remaining <= step) {
+            travelled += remaining;
+            corX       = destX;
+            corY       = destY;
+            ShipTables::RouteLeg* r = routed ? &tables->route(index) : nullptr;
+            if (!r || r->leg + 1 >= r->route->size()) {
+                remaining = 0;
+                return travelled;
+            }
+            step -= remaining;
+            const Location& next = (*r->route)[++r->leg];
+            destX = static_cast<real_t>(next.first);
+            destY = static_cast<real_t>(next.second);
+            aimAtDestination();
+        }
+        remaining -= step;
     }
-
-    corX += step * sin(rad);
-    corY += step * cos(rad);
-
-    // Consume fuel proportional to distance travelled
-    if (fuelConsumption > 0) {
-        fuel -= step * fuelConsumption;
-        if (fuel < 0) fuel = 0;
+    uint32_t slot = arc();
+    if (slot != ShipTables::NO_ARC) { // corX/corY follow when the Model advances the arcs
+        tables->stepArc(slot, step);
+        return whole;
     }
+    corX += step * dirX;
+    corY += step * dirY;
+    return whole;
 }
 
 /**
@@ -161,32 +265,45 @@ void Ship::update() {
  * When Moving to coordinates:  "Moving to (<x>, <y>) on course H deg, speed S nm/hr"
  * When on Course:               "Moving on course H deg, speed S nm/hr"
  */
-string Ship::navString() const {
-    ostringstream oss;
-    oss << fixed << setprecision(2);
+void Ship::printNav(ostream& out) const {
+    out << fixed << setprecision(2);
     switch (state) {
-        case Stopped: return "Stopped";
-        case Docked:  return "Docked";
-        case DITW:    return "Dead in the water";
+        case Stopped: out << "Stopped"; return;
+        case Docked:  out << "Docked"; return;
+        case DITW:    out << "Dead in the water"; return;
         case Course:
-            oss << "Moving on course " << heading
+            out << "Moving on course " << getHeading()
                 << " deg, speed " << speed << " nm/hr";
-            return oss.str();
+            return;
         case Moving:
-            if (!destPortName.empty())
-                oss << "Moving to " << destPortName;
+            if (destPort != NO_NAME)
+                out << "Moving to " << NameTable::get().str(destPort);
+            else if (routed) {
+                const Location& last = tables->route(index).route->back();
+                out << "Moving to (" << last.first << ", " << last.second << ")";
+            }
             else
-                oss << "Moving to (" << destX << ", " << destY << ")";
-            oss << " on course " << heading
+                out << "Moving to (" << destX << ", " << destY << ")";
+            out << " on course " << getHeading()
                 << " deg, speed " << speed << " nm/hr";
-            return oss.str();
+            return;
     }
-    return "";
 }
 
-// Base printStatus
-void Ship::printStatus() const {
-    cout << fixed << setprecision(2);
-    cout << getName() << " at (" << corX << ", " << corY << "), "
-         << navString() << "\n";
+/**
+ * In a world, the cached line (see ShipTables::statusLine): an idle ship costs
+ * a string write. The stream is left in fixed, two-decimal mode either way, as
+ * formatting leaves it.
+ */
+void Ship::printStatus(ostream& out) const {
+    if (tables) out << fixed << setprecision(2) << tables->statusLine(*this);
+    else        formatStatus(out);
+}
+
+// Base status line
+void Ship::formatStatus(ostream& out) const {
+    out << fixed << setprecision(2);
+    out << getName() << " at (" << corX << ", " << corY << "), ";
+    printNav(out);
+    out << "\n";
 }
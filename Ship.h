@@ -6,10 +6,14 @@
 #define INC_74_EX3_SHIP_H
 
 #include "Sim_object.h"
+#include "ShipTraits.h"
+#include "ShipTables.h"
+#include <cstdint>
 #include <iostream>
+#include <memory>
 using namespace std;
 
-enum State {
+enum State : uint8_t {
     Stopped,
     Docked,
     DITW,   // Dead in the water
@@ -21,47 +25,100 @@ enum State {
  * Abstract base class for all ship types.
  * Manages movement, fuel consumption, heading, and combat stat.
  * Name and location are owned by Sim_object.
+ * Per-kind constants (max speed, tank size, burn rate) are not stored: each
+ * kind derives from ShipKind<KindTraits> (see ShipKind.h), which compiles the
+ * hourly update, advance() and refuel() for its constants; getters read
+ * SHIP_TRAITS. Fields are ordered to pack without padding.
+ * State only some ships need lives in the world's ShipTables (see ShipTables.h):
+ *   - the heading a Course was commanded on (dirX/dirY keep its direction)
+ *   - under Geodesic navigation (see Geodesy.h) a moving ship sails a
+ *     great-circle arc in the world's ArcTable, set up with its destination or
+ *     course; moving only notes the step, and the Model then advances every
+ *     arc at once and writes the positions back. dirX/dirY are unused then
+ *   - a ship sent around obstacles (see Routing.h) sails a shared waypoint
+ *     list leg by leg; destX/destY is then the waypoint it is heading for
+ *   - the status line is formatted only when something it shows has changed:
+ *     every state change calls touch(), and printStatus() reuses the cached
+ *     line of a ship that has not been touched since it was last printed
+ * A ship outside any world (not yet added, or outliving its Model) has no
+ * tables: it navigates on the plane, sails a route's first leg only, shows a
+ * Course by its direction of travel, and formats its status on every print.
  */
 class Ship : public Sim_object {
 protected:
     int attackStat; // resistance (freighter/patrol) or attack force (cruiser)
 
 private:
-    double speed;            // current speed in nm/hr
-    double heading;          // compass heading: 0=N, 90=E, 180=S, 270=W
-    double fuel;             // current fuel in kl
-    int    fuelConsumption;  // fuel burn in kl per nm travelled
-    const double maxSpeed;   // type maximum speed
-    const double maxFuel;    // type tank capacity
+    const ShipType type;     // concrete type, fixed at construction
     State  state;            // current navigation state
+    bool   routed;           // sails a multi-leg route held in tables
+    real_t speed;            // current speed in nm/hr
+    real_t dirX;             // unit direction of travel, x component (sin of heading)
+    real_t dirY;             // unit direction of travel, y component (cos of heading)
+    real_t fuel;             // current fuel in kl
 
     // Destination for Moving state
-    double destX;
-    double destY;
-    string destPortName; // name of destination port if Moving to a port; else empty
+    real_t destX;
+    real_t destY;
+    real_t remaining;    // distance left to the destination (nm), Moving only
+    NameId destPort;     // destination port if Moving to a port; else NO_NAME
+
+    uint32_t index;      // in its world's ships (and tables)
+    ShipTables* tables;  // its world's side tables; null outside a world
+
+    // Samples position/state/fuel every tick; reads the fields directly to stay cheap
+    friend class TrajectoryLog;
+    // Sets tables and index as the ship joins and leaves a world; formats its line
+    friend class ShipTables;
+
+    // Under Geodesic navigation, and in a world that can hold its arc
+    bool geodesic() const { return tables && tables->navigation() == Geodesic; }
+    // Slot of its great-circle arc in tables; NO_ARC when none
+    uint32_t arc() const { return tables ? tables->arcOf(index) : ShipTables::NO_ARC; }
+
+    // Heading the Course was commanded on (kept in tables), else that of dirX/dirY
+    double commandedHeading() const;
+    double directionHeading() const;
+
+    // The world's fuel model; a ship outside any world burns at its constant rate
+    const FuelModel& fuelModel() const;
+
+    // Drop the arc and route, if any
+    void clearArc();
+    void clearRoute();
+
+    // Point dirX/dirY (or the arc) at (destX, destY) and reset remaining from the current position
+    void aimAtDestination();
+
+    // Start the great-circle arc of a Course on headingDeg from the current position (Geodesic navigation)
+    void aimAlongCourse(double headingDeg);
+
+    // Move up to `step` nm along the current leg (stopping on the destination); returns nm moved
+    double moveBy(double step);
 
 public:
-    Ship();
+    explicit Ship(ShipType type);
     ~Ship() override = default;
 
     // Parameterized constructor used by derived classes
-    Ship(const string& name, double corX, double corY,
-         double speed, double heading,
-         double fuel, int fuelConsumption, int attackStat,
-         double maxSpeed, double maxFuel);
+    Ship(ShipType type, const string& name, double corX, double corY,
+         double speed, double heading, double fuel, int attackStat);
 
     // Getters
+    ShipType getType()          const;
     double getCorX()            const;
     double getCorY()            const;
     double getSpeed()           const;
-    double getHeading()         const;
+    double getHeading()         const; // derived from the direction of travel unless on a planar Course in a world
     double getFuel()            const;
     double getMaxFuel()         const;
     double getMaxSpeed()        const;
     int    getFuelConsumption() const;
     int    getAttackStat()      const;
     State  getState()           const;
-    const string& getDestPortName() const;
+    NameId getDestPort()        const;
+    bool   hasArrived()         const; // Moving, and on the last waypoint of its destination
+    double distanceToGo()       const; // Moving: nm left to the destination, waypoints included; else 0
 
     // Setters
     void setCorX(double corX);
@@ -75,26 +132,47 @@ public:
     void setCourse(double headingDeg, double spd);
     // Move toward specific coordinates (no named port)
     void setDestination(double cx, double cy, double spd);
-    // Move toward a named port's coordinates (stores port name for status display)
-    void setPortDestination(double cx, double cy, double spd, const string& portName);
+    // Move toward a named port's coordinates (stores port ID for status display)
+    void setPortDestination(double cx, double cy, double spd, NameId port);
+    // Sail the waypoints in order (the last is the destination; port names it, or NO_NAME)
+    void setRoute(shared_ptr<const Route> waypoints, double spd, NameId port);
     void changeState(State newState);
+    // Keep sailing to the destination's coordinates without naming a port (the port was removed)
+    void forgetDestPort();
 
     // Combat
     virtual void setAttackStat(bool victory);
 
-    // Sim_object interface
-    // Advance one time step: move if not stopped/docked/DITW; consume fuel; go DITW if out of fuel
-    void update() override;
+    // Sim_object interface: update() (one hour) comes from the ship's ShipKind
+
+    /**
+     * Advance `hours` (a whole or partial hour) exactly: unlike update(), a ship
+     * whose tank empties part way stops where the fuel ran out and goes DITW then.
+     * Used by the Model's sub-stepped mode (see Model::setSubsteps).
+     */
+    virtual void advance(double hours, ostream& log) = 0;
 
-    // Refuel: add amount capped at maxFuel (derived classes can override)
-    virtual void refuel(double amount);
+    // Refuel: add amount capped at the tank (nothing for a kind without fuel)
+    virtual void refuel(double amount) = 0;
 
-    // Print base status (overridden by each derived class)
-    void printStatus() const override;
+    // Print status: the cached line, reformatted first if the ship was touched since
+    void printStatus(ostream& out) const final;
 
 protected:
-    // Build the navigation state string for use in derived printStatus()
-    string navString() const;
+    // Something shown in the status line changed; call from every mutator
+    void touch() {
+        if (tables) tables->touched(index, getNameId());
+    }
+
+    // Bodies of update() and advance() for a kind's constants (in ShipKind.h, instantiated by each ShipKind)
+    template <class Traits> void updateAs(ostream& log);
+    template <class Traits> void advanceAs(double hours, ostream& log);
+
+    // Format the status line (overridden by each derived class)
+    virtual void formatStatus(ostream& out) const;
+
+    // Write the navigation state, for use in derived formatStatus()
+    void printNav(ostream& out) const;
 };
 
 #endif //INC_74_EX3_SHIP_H
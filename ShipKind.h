@@ -0,0 +1,110 @@
+//
+// ShipKind: the half of a ship that depends only on its kind's constants,
+// generated from the kind's trait struct (see ShipTraits.h):
+//
+//     class Freighter : public ShipKind<FreighterTraits> { ... };
+//
+// The hourly update, the partial-hour advance and refuelling are compiled per
+// kind with its tank size and burn rate as constants; a kind without fuel
+// (fuelRate 0) has no fuel checks or burn in its update at all. A new kind
+// needs a ShipType, its trait struct and SHIP_TRAITS row, its profile phase
+// (see Profiler.h) and its status line; the update bodies below are
+// instantiated by its ShipKind, it inherits everything else and stores no
+// constants of its own. Tables kept per kind are sized by SHIP_KINDS.
+//
+
+#ifndef INC_74_EX3_SHIPKIND_H
+#define INC_74_EX3_SHIPKIND_H
+
+#include "Ship.h"
+#include "FuelModel.h"
+using namespace std;
+
+/**
+ * update() — advance one time step (1 hour).
+ * - Stopped / Docked / DITW: no movement.
+ * - No fuel while moving: transition to DITW.
+ * - Moving / Course: advance position, consume fuel.
+ *   Ships only dock when explicitly commanded (dockAt in model/controller).
+ */
+template <class Traits>
+void Ship::updateAs(ostream& log) {
+    if (state == Stopped || state == Docked || state == DITW)
+        return;
+    touch(); // underway: position, fuel (or the heading of an arrived ship) change
+
+    // Out of fuel → dead in the water
+    if (Traits::fuelRate > 0 && fuel <= 0) {
+        log << getName() << " is out of fuel and is dead in the water.\n";
+        changeState(DITW);
+        return;
+    }
+
+    // distance travelled this step = speed * 1hr (less if the destination is closer)
+    double step = moveBy(speed);
+
+    // Consume fuel proportional to distance travelled, at this speed's rate (see FuelModel.h)
+    if (Traits::fuelRate > 0) {
+        fuel -= step * fuelModel().perNm(SHIP_TRAITS[Traits::type], speed);
+        if (fuel < 0) fuel = 0;
+    }
+}
+
+/**
+ * advance() — move for part of an hour, honouring the fuel left.
+ * Stopped / Docked / DITW ships do not move; an empty tank means DITW as in update().
+ */
+template <class Traits>
+void Ship::advanceAs(double hours, ostream& log) {
+    if (state == Stopped || state == Docked || state == DITW)
+        return;
+    touch();
+
+    if (Traits::fuelRate > 0 && fuel <= 0) {
+        log << getName() << " is out of fuel and is dead in the water.\n";
+        changeState(DITW);
+        return;
+    }
+
+    double step = speed * hours;
+    double burn = Traits::fuelRate > 0 ? fuelModel().perNm(SHIP_TRAITS[Traits::type], speed) : 0;
+    bool runsDry = burn > 0 && step * burn >= fuel;
+    if (runsDry) step = fuel / burn; // how far the tank reaches
+
+    double moved = moveBy(step);
+    if (burn > 0) {
+        fuel -= moved * burn;
+        if (fuel < 0) fuel = 0;
+    }
+    if (runsDry && moved >= step) { // the tank emptied before any arrival
+        fuel = 0;
+        log << getName() << " is out of fuel and is dead in the water.\n";
+        changeState(DITW);
+    }
+}
+
+template <class KindTraits>
+class ShipKind : public Ship {
+public:
+    using Traits = KindTraits;
+
+    void update(ostream& log) final { updateAs<Traits>(log); }
+    void advance(double hours, ostream& log) final { advanceAs<Traits>(hours, log); }
+
+    void refuel(double amount) final {
+        if (Traits::fuelRate == 0) return; // fuel is not simulated
+        double newFuel = getFuel() + amount;
+        if (newFuel > Traits::maxFuel) newFuel = Traits::maxFuel;
+        setFuel(newFuel);
+    }
+
+protected:
+    // An unnamed ship (for default constructors)
+    ShipKind() : Ship(Traits::type) {}
+
+    // Stopped at (corX, corY) with a full tank (empty for a kind without fuel)
+    ShipKind(const string& name, double corX, double corY, int attackStat)
+        : Ship(Traits::type, name, corX, corY, 0.0, 0.0, Traits::maxFuel, attackStat) {}
+};
+
+#endif //INC_74_EX3_SHIPKIND_H
@@ -0,0 +1,161 @@
+//
+// ShipTables implementation
+//
+#include "ShipTables.h"
+#include "ModelSnapshot.h"
+#include "Ship.h"
+#include "StatusIndex.h"
+#include "StringSink.h"
+#include <algorithm>
+using namespace std;
+
+void ShipTables::report(uint32_t index, NameId name) {
+    watcher->changed(index, name);
+}
+
+/**
+ * The first print sizes the table for the whole fleet (every line stale);
+ * from then on only a touched ship is reformatted, in place over its cached
+ * line (no allocation once it has grown).
+ */
+const string& ShipTables::statusLine(const Ship& ship) {
+    if (lines.empty()) {
+        lines.resize(count);
+        stale.assign(count, 1);
+        versions.assign(count, 0);
+    }
+    string& line = lines[ship.index];
+    if (stale[ship.index]) {
+        line.clear();
+        StringSink sink(line);
+        ostream out(&sink);
+        ship.formatStatus(out);
+        stale[ship.index] = 0;
+        versions[ship.index] = ++lineClock;
+    }
+    return line;
+}
+
+uint64_t ShipTables::lineVersion(const Ship& ship) const {
+    return versions[ship.index];
+}
+
+bool ShipTables::courseHeading(uint32_t index, double& heading) const {
+    auto it = headings.find(index);
+    if (it == headings.end()) return false;
+    heading = it->second;
+    return true;
+}
+
+void ShipTables::setRoute(uint32_t index, shared_ptr<const Route> waypoints) {
+    RouteLeg& r = routes[index];
+    r.route = move(waypoints);
+    r.leg   = 0;
+}
+
+void ShipTables::setArc(Ship& ship, const GeoArc& a) {
+    if (arcSlots.empty()) arcSlots.assign(count, static_cast<uint32_t>(NO_ARC)); // a copy: NO_ARC is not defined out of class
+    uint32_t& slot = arcSlots[ship.index];
+    if (slot != NO_ARC) {
+        arcs.set(slot, a);
+        return;
+    }
+    slot = arcs.add(a);
+    arcOwners.push_back(&ship);
+}
+
+void ShipTables::releaseArc(Ship& ship) {
+    uint32_t slot = arcSlots[ship.index];
+    if (arcs.stepPending(slot)) { // it went idle part way through a pass
+        arcs.advanceOne(slot);
+        placeOnArc(slot);
+    }
+    uint32_t from = arcs.remove(slot);
+    arcOwners[slot] = arcOwners[from];
+    arcSlots[arcOwners[slot]->index] = slot;
+    arcOwners.pop_back();
+    arcSlots[ship.index] = NO_ARC;
+}
+
+void ShipTables::placeOnArc(uint32_t slot) {
+    Ship& ship = *arcOwners[slot];
+    double lon, lat;
+    arcs.position(slot, lon, lat);
+    ship.corX = static_cast<real_t>(lon);
+    ship.corY = static_cast<real_t>(lat);
+}
+
+void ShipTables::advanceArcs() {
+    arcs.advance();
+    for (uint32_t slot : arcs.moved()) placeOnArc(slot);
+}
+
+/**
+ * Ships that joined since the last publish have no chunk yet, and a removal
+ * forgets them all (later ships move up in creation order): every chunk from
+ * the first such ship on counts as changed.
+ */
+bool ShipTables::chunkChanged(size_t c) const {
+    return min((c + 1) * SNAPSHOT_CHUNK_SIZE, count) > chunkOf.size() || dirtyChunks[c];
+}
+
+void ShipTables::published(const vector<uint32_t>& order) {
+    size_t from = chunkOf.size(); // new ships come last in creation order, and have the highest indices
+    chunkOf.resize(order.size());
+    for (size_t p = from; p < order.size(); ++p) chunkOf[order[p]] = static_cast<uint32_t>(p / SNAPSHOT_CHUNK_SIZE);
+    dirtyChunks.assign((order.size() + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE, 0);
+}
+
+void ShipTables::addShip(Ship& ship, uint32_t index) {
+    ship.tables = this;
+    ship.index  = index;
+    ++count;
+    if (!lines.empty()) {
+        lines.emplace_back();
+        stale.push_back(1);
+        versions.push_back(0);
+    }
+    if (!arcSlots.empty()) arcSlots.push_back(static_cast<uint32_t>(NO_ARC));
+}
+
+void ShipTables::removeShip(Ship& ship, Ship* last) {
+    uint32_t index = ship.index;
+    detach(ship);
+    --count;
+    chunkOf.clear();
+    if (last && last != &ship) {
+        uint32_t from = last->index;
+        if (!lines.empty()) {
+            lines[index].swap(lines[from]); // the removed line's buffer is dropped with the last row
+            stale[index]    = stale[from];
+            versions[index] = versions[from];
+        }
+        if (last->routed) {
+            auto it = routes.find(from);
+            RouteLeg moved = move(it->second);
+            routes.erase(it);
+            routes[index] = move(moved);
+        }
+        auto h = headings.find(from);
+        if (h != headings.end()) {
+            headings[index] = h->second;
+            headings.erase(from);
+        }
+        if (!arcSlots.empty()) arcSlots[index] = arcSlots[from];
+        last->index = index;
+    }
+    if (!lines.empty()) {
+        lines.pop_back();
+        stale.pop_back();
+        versions.pop_back();
+    }
+    if (!arcSlots.empty()) arcSlots.pop_back();
+}
+
+void ShipTables::detach(Ship& ship) {
+    if (arcOf(ship.index) != NO_ARC) releaseArc(ship);
+    if (ship.routed) routes.erase(ship.index);
+    headings.erase(ship.index);
+    ship.routed = false;
+    ship.tables = nullptr;
+}
@@ -0,0 +1,127 @@
+//
+// ShipTables: the per-ship state of a world that most ships never need, kept
+// beside its ships instead of in them (see Ship.h):
+//   - cached status lines, allocated for the whole fleet on the first status
+//     print, with a stale flag each (set by touch()) and a version that
+//     changes whenever the line is reformatted
+//   - the commanded heading of a ship on a Course
+//   - where a ship on a multi-leg route stands (shared waypoints and leg)
+//   - great-circle arcs of moving ships under Geodesic navigation, in one
+//     ArcTable that the Model advances after each pass over the ships
+//   - the world's status index, told of each touch once it exists
+//   - which chunks of the published ship records (see ModelSnapshot.h) hold a
+//     ship touched since the last publish, so the next one refills only those
+// It also carries the world's navigation mode and fuel model to its ships.
+//
+// Owned by the Model, indexed like its ships and swap-removed with them; each
+// ship it holds keeps a pointer here and its index. A ship that is never
+// printed, put on a course, routed or put on an arc adds nothing to the
+// tables (arc slots are kept for the fleet only in a world with arcs).
+//
+
+#ifndef INC_74_EX3_SHIPTABLES_H
+#define INC_74_EX3_SHIPTABLES_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Geodesy.h"
+#include "NameTable.h"
+#include "Routing.h"
+#include "Sim_object.h"
+using namespace std;
+
+class FuelModel;
+class Ship;
+class StatusIndex;
+
+class ShipTables {
+public:
+    static const uint32_t NO_ARC = ArcTable::NO_ARC;
+
+    // Where a ship on a multi-leg route stands
+    struct RouteLeg {
+        shared_ptr<const Route> route; // shared with every other ship on the same lane
+        uint32_t leg;                  // index in route of the waypoint being sailed to
+    };
+
+    // Ship::touch(): the ship at index changed
+    void touched(uint32_t index, NameId name) {
+        if (index < stale.size()) stale[index] = 1;
+        if (index < chunkOf.size()) dirtyChunks[chunkOf[index]] = 1;
+        if (watcher) report(index, name);
+    }
+
+    // The world's navigation mode and fuel model (set by the Model, which owns the model)
+    Navigation navigation() const { return nav; }
+    const FuelModel& fuelModel() const { return *fuel; }
+    void setNavigation(Navigation mode) { nav = mode; }
+    void setFuelModel(const FuelModel& model) { fuel = &model; }
+
+    // Pass every touch on to index from now on
+    void watch(StatusIndex* index) { watcher = index; }
+
+    // The ship's status line, reformatted first if it was touched since it was last printed
+    const string& statusLine(const Ship& ship);
+    // Version of the line statusLine() last returned for ship: unique to that text, never 0
+    uint64_t lineVersion(const Ship& ship) const;
+
+    // Commanded heading of the ship at index while it is on a Course
+    bool courseHeading(uint32_t index, double& heading) const;
+    void setCourseHeading(uint32_t index, double heading) { headings[index] = static_cast<real_t>(heading); }
+    void clearCourseHeading(uint32_t index) { headings.erase(index); }
+
+    // Route of the ship at index (which has one)
+    RouteLeg& route(uint32_t index) { return routes.find(index)->second; }
+    void setRoute(uint32_t index, shared_ptr<const Route> waypoints);
+    void clearRoute(uint32_t index) { routes.erase(index); }
+
+    // Slot of the arc of the ship at index; NO_ARC when none
+    uint32_t arcOf(uint32_t index) const { return index < arcSlots.size() ? arcSlots[index] : NO_ARC; }
+    GeoArc arc(uint32_t slot) const { return arcs.get(slot); }
+    // Put ship on arc a (in its slot, or a new one)
+    void setArc(Ship& ship, const GeoArc& a);
+    // Take ship off its arc (moving it first by a step still pending)
+    void releaseArc(Ship& ship);
+    // The ship on the arc in slot moves nm along it at the next advanceArcs()
+    void stepArc(uint32_t slot, double nm) { arcs.step(slot, nm); }
+    // Move every arc stepped since the last call and put its ship at the new position
+    void advanceArcs();
+
+    // Snapshot chunk c of the ship records (creation order) may differ from the last published one
+    bool chunkChanged(size_t c) const;
+    // The ships were published in order (dense indices in creation order); clears the chunk flags
+    void published(const vector<uint32_t>& order);
+
+    // The Model's ships: ship joins at index (the next one)
+    void addShip(Ship& ship, uint32_t index);
+    // ship leaves; the world's last ship (if another) takes its index
+    void removeShip(Ship& ship, Ship* last);
+    // The world is going away: ship keeps its position and plain state only
+    void detach(Ship& ship);
+
+private:
+    size_t count = 0;        // ships in the world
+    vector<string> lines;    // per ship: status line; empty until the first print
+    vector<uint8_t> stale;   // per ship: lines[i] is out of date; sized with lines
+    vector<uint64_t> versions; // per ship: lines[i]'s version; sized with lines
+    uint64_t lineClock = 0;  // last version handed out
+    unordered_map<uint32_t, real_t> headings; // by ship index, ships on a Course only
+    unordered_map<uint32_t, RouteLeg> routes; // by ship index, routed ships only
+    ArcTable arcs;             // ships on an arc only
+    vector<Ship*> arcOwners;   // by arc slot: the ship on it
+    vector<uint32_t> arcSlots; // per ship: its arc slot or NO_ARC; empty until the first arc
+    vector<uint32_t> chunkOf;     // per ship: its snapshot chunk; cleared when a removal shifts them
+    vector<uint8_t>  dirtyChunks; // per snapshot chunk: a ship in it was touched
+    StatusIndex* watcher = nullptr;
+    Navigation nav = Planar;
+    const FuelModel* fuel = nullptr;
+
+    void report(uint32_t index, NameId name);
+    // Put the ship on the arc in slot at the arc's position
+    void placeOnArc(uint32_t slot);
+};
+
+#endif //INC_74_EX3_SHIPTABLES_H
@@ -0,0 +1,68 @@
+//
+// ShipTraits: per-kind constants shared by every ship of a kind.
+// Each kind's constants are a constexpr trait struct, compiled into that
+// kind's update, advance and refuel code (see ShipKind.h); code that holds a
+// ship of any kind reads the same values from SHIP_TRAITS, indexed by ShipType.
+// No ship instance stores them.
+//
+
+#ifndef INC_74_EX3_SHIPTRAITS_H
+#define INC_74_EX3_SHIPTRAITS_H
+
+#include <cstdint>
+
+// Concrete ship type tag: lets callers check capabilities without RTTI
+enum ShipType : uint8_t {
+    FreighterType,
+    PatrolType,
+    CruiserType
+};
+
+// Number of ShipTypes: the size of every table kept per kind
+static const int SHIP_KINDS = CruiserType + 1;
+
+// Freighter constants
+struct FreighterTraits {
+    static constexpr ShipType type     = FreighterType;
+    static constexpr double   maxSpeed = 40.0;  // nm/h
+    static constexpr double   maxFuel  = 500.0; // kl
+    static constexpr int      fuelRate = 1;     // kl per nm
+};
+
+// Patrol boat constants
+struct PatrolTraits {
+    static constexpr ShipType type     = PatrolType;
+    static constexpr double   maxSpeed = 15.0;  // nm/h
+    static constexpr double   maxFuel  = 900.0; // kl
+    static constexpr int      fuelRate = 2;     // kl per nm
+};
+
+// Cruiser (pirate ship) constants; fuel is not simulated
+struct CruiserTraits {
+    static constexpr ShipType type     = CruiserType;
+    static constexpr double   maxSpeed = 75.0; // nm/h
+    static constexpr double   maxFuel  = 0.0;
+    static constexpr int      fuelRate = 0;
+};
+
+struct ShipTraits {
+    double maxSpeed; // nm/h
+    double maxFuel;  // kl tank capacity (0 = fuel not simulated)
+    int    fuelRate; // kl burned per nm travelled (0 = fuel not simulated)
+};
+
+// A kind's constants as a runtime row
+template <class Traits>
+constexpr ShipTraits traitsRow() { return ShipTraits{ Traits::maxSpeed, Traits::maxFuel, Traits::fuelRate }; }
+
+// Indexed by ShipType
+static constexpr ShipTraits SHIP_TRAITS[] = {
+    traitsRow<FreighterTraits>(),
+    traitsRow<PatrolTraits>(),
+    traitsRow<CruiserTraits>(),
+};
+static_assert(FreighterTraits::type == 0 && PatrolTraits::type == 1 && CruiserTraits::type == 2,
+              "SHIP_TRAITS rows must follow ShipType");
+static_assert(sizeof(SHIP_TRAITS) / sizeof(SHIP_TRAITS[0]) == SHIP_KINDS, "SHIP_TRAITS needs a row per ShipType");
+
+#endif //INC_74_EX3_SHIPTRAITS_H
@@ -3,6 +3,7 @@
 //
 #include "Sim_object.h"
 Sim_object::Sim_object(const string& name, double corX, double corY)
-    : name(name), corX(corX), corY(corY) {}
-const string& Sim_object::getName() const { return name; }
+    : nameId(NameTable::get().intern(name)), corX(corX), corY(corY) {}
+NameId Sim_object::getNameId() const { return nameId; }
+const string& Sim_object::getName() const { return NameTable::get().str(nameId); }
 Location Sim_object::getLocation() const { return {corX, corY}; }
@@ -6,36 +6,58 @@
 #ifndef INC_74_EX3_SIM_OBJECT_H
 #define INC_74_EX3_SIM_OBJECT_H
 
+#include <ostream>
 #include <string>
 #include <utility>
+#include "NameTable.h"
 using namespace std;
 
 // 2D location as (x, y) in nautical miles
 using Location = pair<double, double>;
 
+/**
+ * Storage type for per-object coordinates and ship kinematics/fuel.
+ * Default build: double. With SIM_COMPACT_STATE (CMake option) it is float32,
+ * which halves those fields. Error bounds in compact mode: every stored value
+ * is rounded to 24 significant bits, i.e. at most half an ulp:
+ *   |x| < 4096 nm   -> <= 0.00025 nm per store     |x| < 65536 nm -> <= 0.004 nm
+ *   fuel <= 1024 kl -> <= 0.00004 kl per store
+ * Ships on a course accumulate at most that much per tick (typically far less,
+ * as rounding errors partly cancel); ships heading for a destination land
+ * exactly on it, so their error does not build up across legs.
+ */
+#ifdef SIM_COMPACT_STATE
+using real_t = float;
+#else
+using real_t = double;
+#endif
+
 class Sim_object {
 private:
-    string name;
+    NameId nameId; // interned name; resolve with getName() only for I/O
 
 protected:
-    double corX;
-    double corY;
+    real_t corX;
+    real_t corY;
 
 public:
     Sim_object(const string& name, double corX, double corY);
     virtual ~Sim_object() = default;
 
-    // Returns the object's name
+    // Returns the object's interned name ID
+    NameId getNameId() const;
+
+    // Returns the object's name (resolved through the NameTable)
     const string& getName() const;
 
     // Returns the object's current (x, y) location
     Location getLocation() const;
 
-    // Called once per time step by the Model
-    virtual void update() = 0;
+    // Called once per time step by the Model; events (a ship running dry) are reported to log
+    virtual void update(ostream& log) = 0;
 
-    // Print current status to stdout
-    virtual void printStatus() const = 0;
+    // Print current status to out
+    virtual void printStatus(ostream& out) const = 0;
 };
 
 #endif //INC_74_EX3_SIM_OBJECT_H
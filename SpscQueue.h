@@ -0,0 +1,108 @@
+//
+// SpscQueue: bounded lock-free single-producer / single-consumer ring buffer.
+// Used to hand pre-tokenized commands from the input reader thread to the
+// model thread without taking a lock on the data path.
+//
+
+#ifndef INC_74_EX3_SPSCQUEUE_H
+#define INC_74_EX3_SPSCQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+ * Capacity is rounded up to a power of two. Exactly one thread may push and
+ * exactly one (other) thread may pop. head/tail live on separate cache lines
+ * so producer and consumer do not false-share.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : head(0), tail(0) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        slots.resize(cap);
+        mask = cap - 1;
+    }
+
+    SpscQueue(const SpscQueue&)            = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer: enqueue if there is room; returns false when full
+    bool tryPush(T&& item) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = move(item);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    // Producer: enqueue, backing off while the consumer catches up
+    void push(T&& item) {
+        for (unsigned spins = 0; !tryPush(move(item)); ++spins) backOff(spins);
+    }
+
+    // Consumer: move up to maxItems into out (appended); returns how many were taken
+    size_t tryPopBatch(vector<T>& out, size_t maxItems) {
+        size_t h = head.load(memory_order_relaxed);
+        size_t avail = tail.load(memory_order_acquire) - h;
+        size_t n = avail < maxItems ? avail : maxItems;
+        for (size_t i = 0; i < n; ++i) out.push_back(move(slots[(h + i) & mask]));
+        head.store(h + n, memory_order_release);
+        return n;
+    }
+
+    // Consumer: wait (spin, then yield, then sleep) until at least one item is available
+    size_t popBatch(vector<T>& out, size_t maxItems) {
+        size_t n;
+        for (unsigned spins = 0; (n = tryPopBatch(out, maxItems)) == 0; ++spins) backOff(spins);
+        return n;
+    }
+
+    // Consumer: true if nothing is queued right now
+    bool empty() const {
+        return head.load(memory_order_relaxed) == tail.load(memory_order_acquire);
+    }
+
+private:
+    // Cheap spin first for low latency under load, then stop burning CPU when idle
+    static void backOff(unsigned spins) {
+        if (spins < 64)        return;
+        if (spins < 128)       this_thread::yield();
+        else                   this_thread::sleep_for(chrono::microseconds(200));
+    }
+
+    vector<T> slots;
+    size_t    mask;
+    alignas(64) atomic<size_t> head; // next slot to pop  (written by consumer)
+    alignas(64) atomic<size_t> tail; // next slot to push (written by producer)
+};
+
+/**
+ * Heap memory aligned to align (a power of two) for an object holding an
+ * SpscQueue, since plain new honours over-alignment only from C++17 on. It
+ * over-allocates with malloc and keeps the block's start just below the
+ * aligned address, so it needs nothing beyond C++14. Release with alignedFree().
+ */
+inline void* alignedAlloc(size_t size, size_t align) {
+    void* block = malloc(size + align - 1 + sizeof(void*));
+    if (!block) throw bad_alloc();
+    uintptr_t first = reinterpret_cast<uintptr_t>(block) + sizeof(void*);
+    void** p = reinterpret_cast<void**>((first + align - 1) & ~static_cast<uintptr_t>(align - 1));
+    p[-1] = block;
+    return p;
+}
+
+inline void alignedFree(void* p) noexcept {
+    if (p) free(static_cast<void**>(p)[-1]);
+}
+
+#endif //INC_74_EX3_SPSCQUEUE_H
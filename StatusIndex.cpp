@@ -0,0 +1,302 @@
+//
+// StatusIndex implementation
+//
+#include "StatusIndex.h"
+#include "Freighter.h"
+#include "Geodesy.h"
+#include <algorithm>
+#include <climits>
+using namespace std;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void StatusIndex::read(const Ship& ship, Entry& e) {
+    Location at  = ship.getLocation();
+    e.x          = at.first;
+    e.y          = at.second;
+    e.fuel       = ship.getMaxFuel() > 0 ? ship.getFuel() : NAN;
+    e.containers = ship.getType() == FreighterType ? static_cast<const Freighter&>(ship).getContainers() : NAN;
+    e.state      = ship.getState();
+    e.type       = ship.getType();
+}
+
+//--Grid--
+// Cell coordinates are clamped to 32 bits each and packed (column, row)
+uint64_t StatusIndex::cellOf(double x, double y) const {
+    double c = floor(x / cellSize), r = floor(y / cellSize);
+    c = min(max(c, static_cast<double>(INT32_MIN)), static_cast<double>(INT32_MAX));
+    r = min(max(r, static_cast<double>(INT32_MIN)), static_cast<double>(INT32_MAX));
+    return static_cast<uint64_t>(static_cast<uint32_t>(static_cast<int32_t>(c))) << 32
+         | static_cast<uint32_t>(static_cast<int32_t>(r));
+}
+
+void StatusIndex::cellInsert(uint32_t index) {
+    Entry& e = entries[index];
+    e.cell = cellOf(e.x, e.y);
+    vector<uint32_t>& cell = cells[e.cell];
+    e.cellPos = static_cast<uint32_t>(cell.size());
+    cell.push_back(index);
+}
+
+void StatusIndex::cellErase(uint32_t index) {
+    auto it = cells.find(entries[index].cell);
+    listErase(it->second, entries[index].cellPos, &Entry::cellPos);
+    if (it->second.empty()) cells.erase(it); // only occupied cells are kept
+}
+
+void StatusIndex::listErase(vector<uint32_t>& list, uint32_t pos, uint32_t Entry::*posField) {
+    uint32_t moved = list.back();
+    list[pos] = moved;
+    entries[moved].*posField = pos;
+    list.pop_back();
+}
+
+//--Maintenance--
+void StatusIndex::build(const vector<shared_ptr<Ship>>& ships, const vector<uint64_t>& seq) {
+    built = true;
+    entries.reserve(ships.size());
+    for (uint32_t i = 0; i < ships.size(); ++i) addShip(i, *ships[i], seq[i]);
+}
+
+void StatusIndex::addShip(uint32_t index, const Ship& ship, uint64_t seq) {
+    if (!built) return;
+    if (entries.empty()) cellSize = navigation == Geodesic ? STATUS_CELL_DEG : STATUS_CELL_NM;
+    Entry e;
+    e.seq    = seq;
+    e.queued = false;
+    read(ship, e);
+    e.statePos = static_cast<uint32_t>(byState[e.state].size());
+    e.typePos  = static_cast<uint32_t>(byType[e.type].size());
+    entries.push_back(e);
+    byState[e.state].push_back(index);
+    byType[e.type].push_back(index);
+    if (!isnan(e.fuel))       byFuel.insert(RankKey{ e.fuel, seq, index });
+    if (!isnan(e.containers)) byContainers.insert(RankKey{ e.containers, seq, index });
+    cellInsert(index);
+}
+
+void StatusIndex::removeShip(uint32_t index) {
+    if (!built) return;
+    const Entry& e = entries[index];
+    listErase(byState[e.state], e.statePos, &Entry::statePos);
+    listErase(byType[e.type], e.typePos, &Entry::typePos);
+    if (!isnan(e.fuel))       byFuel.erase(RankKey{ e.fuel, e.seq, 0 });
+    if (!isnan(e.containers)) byContainers.erase(RankKey{ e.containers, e.seq, 0 });
+    cellErase(index);
+
+    uint32_t last = static_cast<uint32_t>(entries.size() - 1);
+    if (index != last) {
+        const Entry& m = entries[last];
+        byState[m.state][m.statePos] = index;
+        byType[m.type][m.typePos]    = index;
+        cells[m.cell][m.cellPos]     = index;
+        if (!isnan(m.fuel))       byFuel.find(RankKey{ m.fuel, m.seq, 0 })->ship = index;
+        if (!isnan(m.containers)) byContainers.find(RankKey{ m.containers, m.seq, 0 })->ship = index;
+        entries[index] = m;
+    }
+    entries.pop_back();
+}
+
+// Move the ship only within the indexes whose key changed
+void StatusIndex::refresh(uint32_t index, const Ship& ship) {
+    entries[index].queued = false;
+    Entry now = entries[index];
+    read(ship, now);
+    Entry& e = entries[index];
+    if (now.state != e.state) {
+        listErase(byState[e.state], e.statePos, &Entry::statePos);
+        e.state    = now.state;
+        e.statePos = static_cast<uint32_t>(byState[e.state].size());
+        byState[e.state].push_back(index);
+    }
+    if (now.fuel != e.fuel && !isnan(e.fuel)) {
+        byFuel.erase(RankKey{ e.fuel, e.seq, 0 });
+        e.fuel = now.fuel;
+        byFuel.insert(RankKey{ e.fuel, e.seq, index });
+    }
+    if (now.containers != e.containers && !isnan(e.containers)) {
+        byContainers.erase(RankKey{ e.containers, e.seq, 0 });
+        e.containers = now.containers;
+        byContainers.insert(RankKey{ e.containers, e.seq, index });
+    }
+    if (now.x != e.x || now.y != e.y) {
+        e.x = now.x;
+        e.y = now.y;
+        if (cellOf(e.x, e.y) != e.cell) {
+            cellErase(index);
+            cellInsert(index);
+        }
+    }
+}
+
+//--Queries--
+/**
+ * The index is ordered largest first, so the entries in range start at the
+ * first one not above hi and run on while they are not below lo. An open hi
+ * skips the entries equal to it: they all sort before (hi, UINT64_MAX).
+ */
+set<StatusIndex::RankKey>::const_iterator StatusIndex::rangeBegin(const set<RankKey>& index, const ValueRange& r) {
+    return index.lower_bound(RankKey{ r.hi, r.hiOpen ? UINT64_MAX : 0, 0 });
+}
+
+template <class F>
+void StatusIndex::forCandidates(Source source, const StatusQuery& q, F f) const {
+    switch (source) {
+    case AllShips:
+        for (uint32_t i = 0; i < entries.size(); ++i)
+            if (!f(i)) return;
+        return;
+    case StateLists:
+    case TypeLists: {
+        const vector<uint32_t>* lists = source == StateLists ? byState : byType;
+        const int count  = source == StateLists ? 5 : SHIP_KINDS;
+        const uint8_t bits = source == StateLists ? q.states : q.types;
+        for (int k = 0; k < count; ++k)
+            if (bits & (1u << k))
+                for (uint32_t i : lists[k])
+                    if (!f(i)) return;
+        return;
+    }
+    case FuelRange:
+    case CargoRange: {
+        const set<RankKey>& index = source == FuelRange ? byFuel : byContainers;
+        const ValueRange& range   = source == FuelRange ? q.fuel : q.containers;
+        for (auto it = rangeBegin(index, range); it != index.end() && range.contains(it->value); ++it)
+            if (!f(it->ship)) return;
+        return;
+    }
+    case NearCells:
+        forNearCells(q, f);
+        return;
+    }
+}
+
+/**
+ * The cells of the query circle's bounding box: nm on the plane; under
+ * geodesic navigation degrees of latitude, and of longitude widened for the
+ * box's highest latitude (every longitude if the box reaches a pole or the
+ * date line). When the box spans more cells than are occupied, the occupied
+ * cells are scanned instead.
+ */
+template <class F>
+void StatusIndex::forNearCells(const StatusQuery& q, F f) const {
+    double x0 = q.nearX - q.nearR, x1 = q.nearX + q.nearR;
+    double y0 = q.nearY - q.nearR, y1 = q.nearY + q.nearR;
+    if (navigation == Geodesic) {
+        const double dLat = q.nearR * 180.0 / (M_PI * EARTH_RADIUS_NM);
+        y0 = q.nearY - dLat;
+        y1 = q.nearY + dLat;
+        double dLon = HUGE_VAL;
+        if (y0 > -90 && y1 < 90) dLon = dLat / cos(max(fabs(y0), fabs(y1)) * M_PI / 180.0);
+        x0 = q.nearX - dLon;
+        x1 = q.nearX + dLon;
+        if (x0 < -180 || x1 > 180) { x0 = -HUGE_VAL; x1 = HUGE_VAL; }
+    }
+    const uint64_t lo = cellOf(x0, y0), hi = cellOf(x1, y1);
+    const int32_t c0 = static_cast<int32_t>(lo >> 32), r0 = static_cast<int32_t>(static_cast<uint32_t>(lo));
+    const int32_t c1 = static_cast<int32_t>(hi >> 32), r1 = static_cast<int32_t>(static_cast<uint32_t>(hi));
+    const double boxCells = (static_cast<double>(c1) - c0 + 1) * (static_cast<double>(r1) - r0 + 1);
+
+    if (boxCells > static_cast<double>(cells.size())) {
+        for (const auto& cell : cells) {
+            int32_t c = static_cast<int32_t>(cell.first >> 32), r = static_cast<int32_t>(static_cast<uint32_t>(cell.first));
+            if (c < c0 || c > c1 || r < r0 || r > r1) continue;
+            for (uint32_t i : cell.second)
+                if (!f(i)) return;
+        }
+        return;
+    }
+    for (int64_t c = c0; c <= c1; ++c)
+        for (int64_t r = r0; r <= r1; ++r) {
+            auto it = cells.find(static_cast<uint64_t>(static_cast<uint32_t>(c)) << 32 | static_cast<uint32_t>(r));
+            if (it == cells.end()) continue;
+            for (uint32_t i : it->second)
+                if (!f(i)) return;
+        }
+}
+
+bool StatusIndex::matches(const Entry& e, const StatusQuery& q) const {
+    if (q.types && !(q.types & (1u << e.type)))   return false;
+    if (q.states && !(q.states & (1u << e.state))) return false;
+    if (q.fuel.bounded() && !q.fuel.contains(e.fuel)) return false;             // NAN never matches
+    if (q.containers.bounded() && !q.containers.contains(e.containers)) return false;
+    if (q.near && !(distanceNm(navigation, q.nearX, q.nearY, e.x, e.y) <= q.nearR)) return false;
+    return true;
+}
+
+/**
+ * Pick the source with the fewest candidates: the state and type lists know
+ * their sizes, the ranges and the grid are counted, each only up to the best
+ * count so far. A ranked query walks its ordered index from the top instead,
+ * for as many entries as that source holds; if the filters are too selective
+ * for the walk to fill the top within that, the source's matches are sorted.
+ */
+void StatusIndex::query(const StatusQuery& q, vector<uint32_t>& page, size_t& total) const {
+    Source source = AllShips;
+    size_t best   = entries.size();
+    auto listed = [&](Source s, const vector<uint32_t>* lists, int count, uint8_t bits) {
+        if (!bits) return;
+        size_t size = 0;
+        for (int k = 0; k < count; ++k)
+            if (bits & (1u << k)) size += lists[k].size();
+        if (size < best) { source = s; best = size; }
+    };
+    auto consider = [&](Source s, bool used) {
+        if (!used) return;
+        size_t count = 0;
+        forCandidates(s, q, [&](uint32_t) { return ++count < best; });
+        if (count < best) { source = s; best = count; }
+    };
+    listed(StateLists, byState, 5, q.states);
+    listed(TypeLists,  byType,  SHIP_KINDS, q.types);
+    consider(FuelRange,  q.fuel.bounded());
+    consider(CargoRange, q.containers.bounded());
+    consider(NearCells,  q.near);
+
+    candidates.clear();
+    if (q.rank != NoRank) {
+        const set<RankKey>& index = q.rank == RankFuel ? byFuel : byContainers;
+        size_t budget = source == AllShips ? SIZE_MAX : best;
+        auto it = index.begin();
+        for (; it != index.end() && candidates.size() < q.top && budget > 0; ++it, --budget)
+            if (matches(entries[it->ship], q)) candidates.push_back(it->ship);
+        bool filled = candidates.size() == q.top || it == index.end();
+        if (!filled) { // the filters are narrower than the ranking: rank their matches
+            candidates.clear();
+            forCandidates(source, q, [&](uint32_t i) {
+                const Entry& e = entries[i];
+                double value = q.rank == RankFuel ? e.fuel : e.containers;
+                if (!isnan(value) && matches(e, q)) candidates.push_back(i);
+                return true;
+            });
+            auto key = [&](uint32_t i) {
+                return RankKey{ q.rank == RankFuel ? entries[i].fuel : entries[i].containers, entries[i].seq, i };
+            };
+            size_t keep = min(q.top, candidates.size());
+            partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(),
+                         [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+            candidates.resize(keep);
+        }
+    } else {
+        forCandidates(source, q, [&](uint32_t i) {
+            if (matches(entries[i], q)) candidates.push_back(i);
+            return true;
+        });
+    }
+
+    total = candidates.size();
+    page.clear();
+    const size_t first = (q.page - 1) * q.perPage;
+    if (first >= candidates.size()) return;
+    const size_t last = min(candidates.size(), first + q.perPage);
+    if (q.rank == NoRank) {
+        // Creation order, but only as far as the page: the matches before it are
+        // only split off (nth_element), the page itself is sorted
+        auto created = [this](uint32_t a, uint32_t b) { return entries[a].seq < entries[b].seq; };
+        if (first > 0) nth_element(candidates.begin(), candidates.begin() + first, candidates.end(), created);
+        partial_sort(candidates.begin() + first, candidates.begin() + last, candidates.end(), created);
+    }
+    page.assign(candidates.begin() + first, candidates.begin() + last);
+}
@@ -0,0 +1,161 @@
+//
+// StatusIndex: secondary indexes over a world's ships, for status queries
+// (`status type=Freighter state=DITW`, `status fuel<50`, `status near (x,y) r`,
+// `status top 20 by containers`, with pages) that do not walk the fleet.
+//
+// Kept per world by the Model, indexed like its ships:
+//   - per-state and per-type lists (swap-removal, each ship knows its position)
+//   - ordered fuel and cargo indexes (largest first), which answer ranges and
+//     rankings; cruisers carry no fuel and only freighters cargo
+//   - a uniform grid of occupied cells for `near`
+//
+// Maintenance is incremental and lazy. Nothing is built before the first
+// query (a world nobody queries allocates nothing here, and its ships stay
+// packed together in memory). From then on a ship's touch() (see Ship.h)
+// queues the ship here the first time it changes, and the queue is folded
+// into the indexes when a query runs, so an idle ship costs nothing and a
+// busy one is reindexed once per query, not once per change. A query starts from the
+// smallest candidate set its filters offer (counting the ordered and spatial
+// ones only up to the best so far) and tests the other filters on the way,
+// so its cost follows the matches, not the fleet size.
+//
+
+#ifndef INC_74_EX3_STATUSINDEX_H
+#define INC_74_EX3_STATUSINDEX_H
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "Ship.h"
+using namespace std;
+
+static const size_t STATUS_PAGE_SIZE = 50;   // ships per page unless the query says otherwise
+static const double STATUS_CELL_NM   = 64.0; // grid cell side, planar navigation (nm)
+static const double STATUS_CELL_DEG  = 1.0;  // grid cell side, geodesic navigation (degrees)
+
+// Values v with lo < v < hi (or <= where closed); unbounded by default
+struct ValueRange {
+    double lo = -HUGE_VAL, hi = HUGE_VAL;
+    bool   loOpen = false, hiOpen = false;
+
+    bool bounded() const { return lo > -HUGE_VAL || hi < HUGE_VAL; }
+    bool contains(double v) const {
+        return (loOpen ? v > lo : v >= lo) && (hiOpen ? v < hi : v <= hi);
+    }
+};
+
+enum RankField : uint8_t { NoRank, RankFuel, RankContainers };
+
+// A parsed status query; filters combine with "and"
+struct StatusQuery {
+    uint8_t    types  = 0; // bit per ShipType; 0 = any type
+    uint8_t    states = 0; // bit per State; 0 = any state
+    ValueRange fuel;       // ships without fuel (cruisers) never match a bounded range
+    ValueRange containers; // only freighters match a bounded range
+    bool       near = false;
+    double     nearX = 0, nearY = 0, nearR = 0; // nm, under the world's navigation mode
+    RankField  rank = NoRank; // rank by this field, largest first, and keep the first `top`
+    size_t     top  = 0;
+    size_t     page = 1;       // 1-based
+    size_t     perPage = STATUS_PAGE_SIZE;
+};
+static_assert(SHIP_KINDS <= 8, "StatusQuery::types needs a bit per ShipType");
+
+class StatusIndex {
+public:
+    // Index every ship (seq: creation sequence numbers, indexed alike); until then the index is empty
+    void build(const vector<shared_ptr<Ship>>& ships, const vector<uint64_t>& seq);
+    bool isBuilt() const { return built; }
+
+    // The world's navigation mode: what `near` measures in, and the grid's cell size
+    void setNavigation(Navigation mode) { navigation = mode; }
+
+    // Index ship (at index, the next one); no-op before build()
+    void addShip(uint32_t index, const Ship& ship, uint64_t seq);
+
+    // Drop ship index; the last ship's entries move to index (Model swap-removes ships alike)
+    void removeShip(uint32_t index);
+
+    // Called through ShipTables by Ship::touch(); queues the ship once between refreshes
+    void changed(uint32_t index, NameId ship) {
+        if (entries[index].queued) return;
+        entries[index].queued = true;
+        pending.push_back(ship);
+    }
+
+    // Ships changed since the last refresh; refresh each (by index) that still exists
+    const vector<NameId>& getPending() const { return pending; }
+    void refresh(uint32_t index, const Ship& ship);
+    void clearPending() { pending.clear(); }
+
+    /**
+     * Answer query: indices of the ships on its page, in query order (rank,
+     * else creation), and how many ships match in all (at most top when ranked).
+     */
+    void query(const StatusQuery& q, vector<uint32_t>& page, size_t& total) const;
+
+private:
+    // What the indexes hold for a ship, as of its last refresh
+    struct Entry {
+        uint64_t seq;        // creation order
+        double   x, y;
+        double   fuel;       // NAN if the ship carries none
+        double   containers; // NAN unless a freighter
+        uint64_t cell;
+        uint32_t statePos, typePos, cellPos; // positions in byState, byType, the cell
+        State    state;
+        ShipType type;
+        bool     queued;     // in pending since its last refresh
+    };
+    vector<Entry> entries; // indexed like the Model's ships
+    bool built = false;
+
+    vector<uint32_t> byState[5];
+    vector<uint32_t> byType[SHIP_KINDS];
+
+    // Ordered index entry: largest value first, ties in creation order
+    struct RankKey {
+        double   value;
+        uint64_t seq;
+        mutable uint32_t ship; // not part of the order: renumbered in place on swap-removal
+        bool operator<(const RankKey& o) const { return value > o.value || (value == o.value && seq < o.seq); }
+    };
+    set<RankKey> byFuel;
+    set<RankKey> byContainers;
+
+    unordered_map<uint64_t, vector<uint32_t>> cells; // occupied grid cells
+    double cellSize = STATUS_CELL_NM;
+    Navigation navigation = Planar;
+
+    vector<NameId> pending;
+
+    // query() scratch
+    mutable vector<uint32_t> candidates;
+
+    // Where a query takes its candidates from
+    enum Source : uint8_t { AllShips, StateLists, TypeLists, FuelRange, CargoRange, NearCells };
+
+    // A ship's current values (positions in the lists are left alone)
+    static void read(const Ship& ship, Entry& e);
+
+    uint64_t cellOf(double x, double y) const;
+    void cellInsert(uint32_t index);
+    void cellErase(uint32_t index);
+
+    // Swap-remove list[pos]; the moved ship's position field follows it
+    void listErase(vector<uint32_t>& list, uint32_t pos, uint32_t Entry::*posField);
+
+    // First entry of an ordered index that is not above the range (walk on while in range)
+    static set<RankKey>::const_iterator rangeBegin(const set<RankKey>& index, const ValueRange& r);
+
+    // Call f(ship index) for each candidate of source; stops early when f returns false
+    template <class F> void forCandidates(Source source, const StatusQuery& q, F f) const;
+    template <class F> void forNearCells(const StatusQuery& q, F f) const;
+
+    bool matches(const Entry& e, const StatusQuery& q) const;
+};
+
+#endif //INC_74_EX3_STATUSINDEX_H
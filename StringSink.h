@@ -0,0 +1,38 @@
+//
+// StringSink: stream buffer that appends everything written through it to a
+// caller's string. Formatting into a string that is kept (and keeps its
+// capacity) between uses allocates nothing once the string is large enough,
+// where an ostringstream allocates its buffer and str() copies it every time.
+//
+
+#ifndef INC_74_EX3_STRINGSINK_H
+#define INC_74_EX3_STRINGSINK_H
+
+#include <streambuf>
+#include <string>
+using namespace std;
+
+/**
+ * No put area: every write goes straight to the string, so text.size() is
+ * the stream position at any time.
+ */
+class StringSink : public streambuf {
+public:
+    explicit StringSink(string& text) : text(text) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) text.push_back(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char* s, streamsize n) override {
+        text.append(s, static_cast<size_t>(n));
+        return n;
+    }
+
+private:
+    string& text;
+};
+
+#endif //INC_74_EX3_STRINGSINK_H
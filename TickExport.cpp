@@ -0,0 +1,134 @@
+//
+// TickExport implementation
+//
+#include "TickExport.h"
+#include "NameTable.h"
+#include <stdexcept>
+using namespace std;
+
+void* TickExporter::operator new(size_t size) {
+    return alignedAlloc(size, alignof(TickExporter));
+}
+
+void TickExporter::operator delete(void* p) noexcept {
+    alignedFree(p);
+}
+
+TickExporter::TickExporter(const string& path)
+    : path(path), out(path, ios::binary | ios::trunc), queue(EXPORT_QUEUE_CAPACITY), failed(false) {
+    if (!out.is_open())
+        throw runtime_error("cannot open export file '" + path + "'");
+    out.write(COLUMN_FILE_MAGIC, COLUMN_MAGIC_SIZE);
+    writer = thread(&TickExporter::writerLoop, this);
+}
+
+TickExporter::~TickExporter() {
+    finish();
+}
+
+void TickExporter::append(shared_ptr<const ModelSnapshot> tick) {
+    if (finished || !tick) return;
+    queue.push(Item{move(tick)});
+}
+
+bool TickExporter::finish() {
+    if (!finished) {
+        finished = true;
+        queue.push(Item{nullptr});
+        writer.join();
+        out.close();
+        if (out.fail()) failed = true;
+    }
+    return !failed;
+}
+
+void TickExporter::writerLoop() {
+    vector<Item> batch;
+    for (;;) {
+        batch.clear();
+        queue.popBatch(batch, 64);
+        for (Item& item : batch) {
+            if (!item.tick) {
+                out.flush();
+                return;
+            }
+            if (!failed) writeTick(*item.tick);
+            item.tick.reset(); // let the epoch go as soon as it is written
+        }
+    }
+}
+
+void TickExporter::writeFrame(uint8_t type, const string& payload) {
+    out.put(static_cast<char>(type));
+    string len;
+    putU32(len, static_cast<uint32_t>(payload.size()));
+    out.write(len.data(), len.size());
+    out.write(payload.data(), payload.size());
+    if (!out) failed = true;
+}
+
+void TickExporter::writeTick(const ModelSnapshot& snap) {
+    size_t nShips = snap.ships.size();
+    size_t nPorts = snap.ports.size();
+
+    // Dictionary entries for objects seen for the first time
+    frame.clear();
+    size_t newNames = 0;
+    auto learn = [&](NameId id, ObjectKind kind) {
+        if (id < named.size() && named[id]) return;
+        if (id >= named.size()) named.resize(id + 1, false);
+        named[id] = true;
+        const string name = NameTable::get().str(id);
+        putVarint(scratch, id);
+        scratch.push_back(static_cast<char>(kind));
+        putVarint(scratch, name.size());
+        scratch += name;
+        ++newNames;
+    };
+    scratch.clear();
+    snap.ports.forEach([&](const PortRecord& r) { learn(r.name, PortObject); });
+    snap.ships.forEach([&](const ShipRecord& r) {
+        learn(r.name, r.type == FreighterType ? FreighterObject
+                    : r.type == PatrolType    ? PatrolObject : CruiserObject);
+    });
+    if (newNames > 0) {
+        putVarint(frame, newNames);
+        frame += scratch;
+        writeFrame(FRAME_DICTIONARY, frame);
+    }
+
+    // Gather columns
+    for (auto& col : shipCur) col.resize(nShips);
+    for (auto& col : portCur) col.resize(nPorts);
+    size_t i = 0;
+    snap.ships.forEach([&](const ShipRecord& r) {
+        shipCur[ShipName][i]       = r.name;
+        shipCur[ShipX][i]          = toFixed(r.x);
+        shipCur[ShipY][i]          = toFixed(r.y);
+        shipCur[ShipFuel][i]       = toFixed(r.fuel);
+        shipCur[ShipState][i]      = r.state;
+        shipCur[ShipContainers][i] = r.containers;
+        shipCur[ShipAttack][i]     = r.attackStat;
+        ++i;
+    });
+    i = 0;
+    snap.ports.forEach([&](const PortRecord& r) {
+        portCur[PortName][i] = r.name;
+        portCur[PortX][i]    = toFixed(r.x);
+        portCur[PortY][i]    = toFixed(r.y);
+        portCur[PortFuel][i] = toFixed(r.fuel);
+        ++i;
+    });
+
+    // Encode against the previous tick
+    frame.clear();
+    putVarint(frame, static_cast<uint64_t>(snap.time));
+    putVarint(frame, nShips);
+    putVarint(frame, nPorts);
+    for (int c = 0; c < SHIP_COLUMNS; ++c) putColumn(frame, shipCur[c], shipPrev[c], scratch);
+    for (int c = 0; c < PORT_COLUMNS; ++c) putColumn(frame, portCur[c], portPrev[c], scratch);
+    writeFrame(FRAME_TICK, frame);
+
+    for (int c = 0; c < SHIP_COLUMNS; ++c) shipPrev[c].swap(shipCur[c]);
+    for (int c = 0; c < PORT_COLUMNS; ++c) portPrev[c].swap(portCur[c]);
+}
@@ -0,0 +1,78 @@
+//
+// TickExport: appends every tick's ship and port state to a columnar binary file
+// (format in ColumnCodec.h; read it back with the tickdump tool).
+//
+// The model thread only hands over the tick's published ModelSnapshot (a
+// shared_ptr, no copy) through a lock-free SPSC queue. A background writer
+// thread encodes the columns and writes them, so ticks do not wait on disk.
+// If the writer falls EXPORT_QUEUE_CAPACITY ticks behind, append() backs off
+// until there is room again rather than dropping ticks.
+//
+
+#ifndef INC_74_EX3_TICKEXPORT_H
+#define INC_74_EX3_TICKEXPORT_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ColumnCodec.h"
+#include "ModelSnapshot.h"
+#include "SpscQueue.h"
+using namespace std;
+
+// Ticks that may be queued ahead of the writer thread
+// (each holds an epoch's changed chunks alive, so this also bounds memory)
+static const size_t EXPORT_QUEUE_CAPACITY = 64;
+
+class TickExporter {
+public:
+    // Opens (truncates) path and starts the writer; throws runtime_error if it cannot be opened
+    explicit TickExporter(const string& path);
+
+    // Flushes everything queued and joins the writer
+    ~TickExporter();
+
+    TickExporter(const TickExporter&)            = delete;
+    TickExporter& operator=(const TickExporter&) = delete;
+
+    // Heap instances keep the queue's cache-line alignment (plain new only
+    // guarantees it from C++17 on)
+    static void* operator new(size_t size);
+    static void operator delete(void* p) noexcept;
+
+    // Queue one tick (model thread)
+    void append(shared_ptr<const ModelSnapshot> tick);
+
+    // Drain the queue and close the file; false if any write failed. Idempotent.
+    bool finish();
+
+    const string& getPath() const { return path; }
+
+private:
+    struct Item {
+        shared_ptr<const ModelSnapshot> tick; // nullptr = stop
+    };
+
+    string   path;
+    ofstream out;
+    SpscQueue<Item> queue;
+    atomic<bool> failed;
+    bool     finished = false;
+    thread   writer;
+
+    // Writer thread state
+    vector<bool> named;                            // NameIds already in a dictionary frame
+    vector<int64_t> shipPrev[SHIP_COLUMNS], shipCur[SHIP_COLUMNS];
+    vector<int64_t> portPrev[PORT_COLUMNS], portCur[PORT_COLUMNS];
+    string frame, scratch;
+
+    void writerLoop();
+    void writeTick(const ModelSnapshot& snap);
+    void writeFrame(uint8_t type, const string& payload);
+};
+
+#endif //INC_74_EX3_TICKEXPORT_H
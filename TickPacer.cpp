@@ -0,0 +1,170 @@
+//
+// TickPacer implementation
+//
+#include "TickPacer.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/prctl.h>
+#include <time.h>
+#endif
+using namespace std;
+
+namespace {
+
+const int64_t US = 1000;
+const int64_t MS = 1000 * US;
+const int64_t S  = 1000 * MS;
+
+// Upper bound of each bucket but the last (ns)
+const int64_t BOUNDS[LatencyHistogram::BUCKETS - 1] = {
+    1 * US,  2 * US,  5 * US,  10 * US,  20 * US,  50 * US,  100 * US,  200 * US,  500 * US,
+    1 * MS,  2 * MS,  5 * MS,  10 * MS,  20 * MS,  50 * MS,  100 * MS,  200 * MS,  500 * MS,
+    1 * S,   2 * S,   5 * S,   10 * S
+};
+
+const int BAR_WIDTH = 40;
+
+// A bucket bound: "5 us", "20 ms", "1 s"
+string bound(int64_t ns) {
+    if (ns < MS) return to_string(ns / US) + " us";
+    if (ns < S)  return to_string(ns / MS) + " ms";
+    return to_string(ns / S) + " s";
+}
+
+} // namespace
+
+string formatDuration(chrono::nanoseconds d) {
+    double ns = static_cast<double>(d.count());
+    double value = ns / US;
+    const char* unit = " us";
+    if (ns >= S)       { value = ns / S;  unit = " s"; }
+    else if (ns >= MS) { value = ns / MS; unit = " ms"; }
+    ostringstream out;
+    out << fixed << setprecision(value < 10 ? 2 : value < 100 ? 1 : 0) << value << unit;
+    return out.str();
+}
+
+// LatencyHistogram
+
+void LatencyHistogram::add(chrono::nanoseconds d) {
+    int64_t ns = d.count() > 0 ? d.count() : 0;
+    int b = 0;
+    while (b < BUCKETS - 1 && ns >= BOUNDS[b]) ++b;
+    ++buckets[b];
+    ++total;
+    sum += ns;
+    if (ns > longest) longest = ns;
+}
+
+void LatencyHistogram::clear() {
+    *this = LatencyHistogram();
+}
+
+chrono::nanoseconds LatencyHistogram::quantile(double q) const {
+    uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS - 1; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return chrono::nanoseconds(BOUNDS[b]);
+    }
+    return max();
+}
+
+void LatencyHistogram::report(ostream& out, const char* what) const {
+    out << "  " << what << ": ";
+    if (total == 0) { out << "none\n"; return; }
+    out << "mean " << formatDuration(mean()) << ", p50 < " << formatDuration(quantile(0.5))
+        << ", p99 < " << formatDuration(quantile(0.99)) << ", max " << formatDuration(max()) << "\n";
+    uint64_t most = 0;
+    for (uint64_t n : buckets) most = n > most ? n : most;
+    for (int b = 0; b < BUCKETS; ++b) {
+        if (buckets[b] == 0) continue;
+        string label = b == 0 ? "< " + bound(BOUNDS[0])
+                     : b == BUCKETS - 1 ? ">= " + bound(BOUNDS[b - 1])
+                     : bound(BOUNDS[b - 1]) + " - " + bound(BOUNDS[b]);
+        int bar = static_cast<int>((buckets[b] * BAR_WIDTH + most - 1) / most);
+        out << "    " << left << setw(17) << label << right << setw(10) << buckets[b] << "  "
+            << string(static_cast<size_t>(bar), '#') << "\n";
+    }
+}
+
+// TickPacer
+
+TickPacer::TickPacer(chrono::nanoseconds period) : period(period) {
+    start();
+}
+
+void TickPacer::start() {
+    deadline  = Clock::now() + period;
+    tickStart = deadline;
+}
+
+void TickPacer::beginTick() {
+    tickStart = Clock::now();
+    chrono::nanoseconds late = tickStart - deadline;
+    lateness.add(late);
+    if (late > period * PACER_MAX_BEHIND) {
+        ++slips;
+        deadline = tickStart; // the missed deadlines are gone; this tick is on time
+    }
+    deadline += period;
+}
+
+void TickPacer::endTick() {
+    Clock::time_point end = Clock::now();
+    durations.add(end - tickStart);
+    if (end > deadline) ++overruns;
+}
+
+void TickPacer::reset() {
+    lateness.clear();
+    durations.clear();
+    overruns = slips = skipped = 0;
+}
+
+void TickPacer::report(ostream& out) const {
+    uint64_t ticks = getTicks();
+    out << "Pacing: " << ticks << (ticks == 1 ? " tick" : " ticks") << " every " << formatDuration(period)
+        << ", " << overruns << (overruns == 1 ? " overrun" : " overruns");
+    if (ticks > 0) out << " (" << fixed << setprecision(2) << 100.0 * overruns / ticks << "%)";
+    out << ", " << slips << (slips == 1 ? " slip" : " slips") << ", "
+        << skipped << " skipped " << (skipped == 1 ? "render" : "renders") << "\n";
+    lateness.report(out, "started late");
+    durations.report(out, "tick time");
+}
+
+void TickPacer::sleepUntil(Clock::time_point when) {
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC, so its time points are valid absolute deadlines
+    chrono::nanoseconds since = when.time_since_epoch();
+    timespec ts;
+    ts.tv_sec  = static_cast<time_t>(since.count() / S);
+    ts.tv_nsec = static_cast<long>(since.count() % S);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+    this_thread::sleep_until(when);
+#endif
+}
+
+void prepareRealTime(int cpu) {
+#ifdef __linux__
+    prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL); // best effort: only makes sleeps more precise
+    if (cpu < 0) cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= CPU_SETSIZE) throw runtime_error("no CPU " + to_string(cpu));
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        throw runtime_error("cannot pin to CPU " + to_string(cpu) + ": " + strerror(errno));
+#else
+    (void)cpu;
+    throw runtime_error("pinning to a CPU needs Linux");
+#endif
+}
@@ -0,0 +1,124 @@
+//
+// TickPacer: runs ticks on a wall-clock schedule, one simulated hour every
+// period, and measures how well the schedule is kept.
+//
+// Deadlines are absolute (start + k periods), so a late wake-up or a slow
+// tick never drifts the schedule: a tick that ends after the next deadline is
+// an overrun, and the ticks it delayed run back to back until the loop has
+// caught up. A loop more than PACER_MAX_BEHIND periods behind gives up on the
+// missed deadlines and restarts the schedule from now (a slip). Sleeps are
+// clock_nanosleep on an absolute CLOCK_MONOTONIC deadline; prepareRealTime()
+// cuts the thread's timer slack to 1 ns and pins it to one CPU, so a tick
+// starts within the kernel's wake-up latency of its deadline.
+//
+// How late each tick started and how long it ran go into fixed histograms;
+// keeping the schedule and measuring it never allocate.
+//
+
+#ifndef INC_74_EX3_TICKPACER_H
+#define INC_74_EX3_TICKPACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+using namespace std;
+
+// Periods a loop may fall behind before its schedule restarts from now
+static const int PACER_MAX_BEHIND = 10;
+
+/**
+ * Counts of durations in 1-2-5 buckets from 1 us to 10 s (the last bucket
+ * takes everything longer).
+ */
+class LatencyHistogram {
+public:
+    static const int BUCKETS = 23;
+
+    void add(chrono::nanoseconds d);
+    void clear();
+
+    uint64_t count() const { return total; }
+    chrono::nanoseconds max() const { return chrono::nanoseconds(longest); }
+    chrono::nanoseconds mean() const { return chrono::nanoseconds(total ? sum / static_cast<int64_t>(total) : 0); }
+
+    // Upper bound of the bucket holding quantile q (0..1)
+    chrono::nanoseconds quantile(double q) const;
+
+    // One summary line, then a bar per non-empty bucket
+    void report(ostream& out, const char* what) const;
+
+private:
+    uint64_t buckets[BUCKETS] = {};
+    uint64_t total   = 0;
+    int64_t  sum     = 0; // ns
+    int64_t  longest = 0; // ns
+};
+
+// "850 us", "12.4 ms", "1.20 s"
+string formatDuration(chrono::nanoseconds d);
+
+class TickPacer {
+public:
+    using Clock = chrono::steady_clock;
+
+    explicit TickPacer(chrono::nanoseconds period);
+
+    chrono::nanoseconds getPeriod() const { return period; }
+
+    // Restart the schedule: the next tick is due one period from now
+    void start();
+
+    // When the next tick is due
+    Clock::time_point nextDeadline() const { return deadline; }
+    bool due() const { return Clock::now() >= deadline; }
+
+    // Sleep until the next tick is due, or until limit if that comes first
+    void sleepUntilDue() const { sleepUntil(deadline); }
+    void sleepUntilDue(Clock::time_point limit) const { sleepUntil(limit < deadline ? limit : deadline); }
+
+    // The tick that is due starts now / has finished
+    void beginTick();
+    void endTick();
+
+    // The next tick is already due: the last one overran, or ticks are catching up
+    bool behind() const { return due(); }
+
+    // Output deferred to keep the schedule (see ControlServer's degraded mode)
+    void skippedRender() { ++skipped; }
+
+    uint64_t getTicks() const { return durations.count(); }
+    uint64_t getOverruns() const { return overruns; }
+    uint64_t getSlips() const { return slips; }
+    uint64_t getSkipped() const { return skipped; }
+
+    // Drop what has been measured (the schedule keeps running)
+    void reset();
+
+    /**
+     * Ticks, overruns, slips and skipped renders, then histograms of how
+     * late ticks started and how long they ran.
+     */
+    void report(ostream& out) const;
+
+    static void sleepUntil(Clock::time_point when);
+
+private:
+    chrono::nanoseconds period;
+    Clock::time_point   deadline;
+    Clock::time_point   tickStart;
+    LatencyHistogram    lateness;
+    LatencyHistogram    durations;
+    uint64_t            overruns = 0;
+    uint64_t            slips    = 0;
+    uint64_t            skipped  = 0;
+};
+
+/**
+ * Set the calling thread up to keep a schedule: timer slack of 1 ns, pinned
+ * to cpu (or, if cpu < 0, to the CPU it is running on). Throws
+ * std::runtime_error if it cannot be pinned.
+ */
+void prepareRealTime(int cpu);
+
+#endif //INC_74_EX3_TICKPACER_H
@@ -0,0 +1,64 @@
+//
+// TrajectoryLog implementation
+//
+#include "TrajectoryLog.h"
+using namespace std;
+
+TrajectoryLog::TrajectoryLog(size_t depth) : depth(depth), latest(0) {}
+
+void TrajectoryLog::reset(size_t newDepth, int now) {
+    depth = newDepth;
+    blocks.clear();
+    firstTime.clear();
+    latest.store(now, memory_order_release);
+}
+
+// A ship created between ticks gets its first sample at the current hour
+void TrajectoryLog::addShip(const Ship& ship, int now) {
+    if (!enabled()) return;
+    size_t index = firstTime.size();
+    if (index / SHIPS_PER_BLOCK == blocks.size())
+        blocks.emplace_back(new TrackPoint[slots() * SHIPS_PER_BLOCK]);
+    firstTime.push_back(now);
+    sample(ship, at(index, now));
+}
+
+// A block whose last ship is removed is freed
+void TrajectoryLog::removeShip(size_t index) {
+    if (!enabled()) return;
+    size_t last = firstTime.size() - 1;
+    if (index != last) {
+        for (size_t s = 0; s < slots(); ++s)
+            blocks[index / SHIPS_PER_BLOCK][s * SHIPS_PER_BLOCK + index % SHIPS_PER_BLOCK] =
+                blocks[last / SHIPS_PER_BLOCK][s * SHIPS_PER_BLOCK + last % SHIPS_PER_BLOCK];
+        firstTime[index] = firstTime[last];
+    }
+    firstTime.pop_back();
+    if (last % SHIPS_PER_BLOCK == 0) blocks.pop_back();
+}
+
+void TrajectoryLog::history(size_t index, size_t count,
+                            vector<int>& times, vector<TrackPoint>& points) const {
+    times.clear();
+    points.clear();
+    if (!enabled() || index >= firstTime.size()) return;
+
+    int newest = latest.load(memory_order_acquire);
+    if (newest < firstTime[index]) newest = firstTime[index]; // created this hour
+    int oldest = newest - static_cast<int>(depth) + 1;
+    if (oldest < firstTime[index]) oldest = firstTime[index];
+    if (count > 0 && newest - oldest + 1 > static_cast<int>(count))
+        oldest = newest - static_cast<int>(count) + 1;
+
+    for (int t = oldest; t <= newest; ++t) {
+        times.push_back(t);
+        points.push_back(at(index, t));
+    }
+
+    // Anything the writer has since lapped may be torn; drop it
+    int lapped = latest.load(memory_order_acquire) - static_cast<int>(depth);
+    size_t drop = 0;
+    while (drop < times.size() && times[drop] <= lapped) ++drop;
+    times.erase(times.begin(), times.begin() + drop);
+    points.erase(points.begin(), points.begin() + drop);
+}
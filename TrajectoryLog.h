@@ -0,0 +1,101 @@
+//
+// TrajectoryLog: fixed-depth history of every ship's position, state and fuel,
+// one sample per simulated hour, kept in per-ship ring buffers.
+//
+// Memory comes from a shared slab of blocks, each holding the rings of
+// SHIPS_PER_BLOCK ships laid out time-major (all ships of a block for one hour
+// are adjacent), so recording a tick is a sequential write and costs no
+// allocation. A block is only allocated when ship creation needs a new one.
+// Model::go() records each ship right after updating it, while it is in cache.
+//
+// Single writer (the model thread). Rings hold one spare hour, so the hour
+// being written is never one a reader may return; samples are published by
+// advancing the atomic `latest` time after a tick is fully written, and
+// history() re-checks it after copying, dropping anything lapped meanwhile.
+//
+
+#ifndef INC_74_EX3_TRAJECTORYLOG_H
+#define INC_74_EX3_TRAJECTORYLOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Ship.h"
+using namespace std;
+
+// Default history depth (hours) per ship: recording is off unless asked for
+static const size_t DEFAULT_TRACK_DEPTH = 0;
+
+// One recorded hour. Stored as float32: ~0.001 nm resolution below 16384 nm.
+struct TrackPoint {
+    float x;
+    float y;
+    float fuel;
+    State state;
+};
+
+class TrajectoryLog {
+public:
+    // Ships whose rings share one slab block
+    static const size_t SHIPS_PER_BLOCK = 256;
+
+    // depth = hours kept per ship; 0 disables recording
+    explicit TrajectoryLog(size_t depth = DEFAULT_TRACK_DEPTH);
+
+    TrajectoryLog(const TrajectoryLog&)            = delete;
+    TrajectoryLog& operator=(const TrajectoryLog&) = delete;
+
+    size_t getDepth() const { return depth; }
+    bool   enabled()  const { return depth > 0; }
+
+    // Drop all history and keep `depth` hours from now on (0 disables)
+    void reset(size_t depth, int now);
+
+    // Start a ring for the next ship index and record its state at `now`
+    void addShip(const Ship& ship, int now);
+
+    // Drop ship index's ring; the last ship's ring moves to index (Model swap-removes ships alike)
+    void removeShip(size_t index);
+
+    // Recording a tick: beginTick(t), record(i, ship) for every ship index, publish(t)
+    void beginTick(int time) { row = (static_cast<size_t>(time) % slots()) * SHIPS_PER_BLOCK; }
+    void record(size_t index, const Ship& ship) {
+        sample(ship, blocks[index / SHIPS_PER_BLOCK][row + index % SHIPS_PER_BLOCK]);
+    }
+    void publish(int time) { latest.store(time, memory_order_release); }
+
+    /**
+     * Up to `count` most recent samples of ship `index`, oldest first, with the
+     * hour each was taken at. count = 0 means everything still held.
+     */
+    void history(size_t index, size_t count,
+                 vector<int>& times, vector<TrackPoint>& points) const;
+
+private:
+    size_t depth;
+    vector<unique_ptr<TrackPoint[]>> blocks; // slab: depth * SHIPS_PER_BLOCK points each
+    vector<int> firstTime;                   // per ship: hour of its first sample
+    atomic<int> latest;                      // newest fully written hour
+    size_t row = 0;                          // offset of the hour being recorded
+
+    // Hours per ring: depth plus the one being written
+    size_t slots() const { return depth + 1; }
+
+    TrackPoint& at(size_t index, int time) {
+        return blocks[index / SHIPS_PER_BLOCK][(time % slots()) * SHIPS_PER_BLOCK + index % SHIPS_PER_BLOCK];
+    }
+    const TrackPoint& at(size_t index, int time) const {
+        return blocks[index / SHIPS_PER_BLOCK][(time % slots()) * SHIPS_PER_BLOCK + index % SHIPS_PER_BLOCK];
+    }
+
+    static void sample(const Ship& ship, TrackPoint& p) {
+        p.x     = static_cast<float>(ship.corX);
+        p.y     = static_cast<float>(ship.corY);
+        p.fuel  = static_cast<float>(ship.fuel);
+        p.state = ship.state;
+    }
+};
+
+#endif //INC_74_EX3_TRAJECTORYLOG_H
@@ -15,8 +15,10 @@
  */
 
 #include "View.h"
-#include "Model.h"
+#include "ModelSnapshot.h"
+#include "NameTable.h"
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -73,41 +75,52 @@ bool View::worldToGrid(double wx, double wy, int& col, int& row) const {
 
 // draw()
 
-void View::draw() const {
+void View::draw(const ModelSnapshot& snap, ostream& out) const {
     // ---- header line ----
-    cout << fixed << setprecision(2);
-    cout << "Display size: " << size
-         << ", scale: "  << scale
-         << ", origin: (" << originX << ", " << originY << ")\n";
+    out << fixed << setprecision(2);
+    out << "Display size: " << size
+        << ", scale: "  << scale
+        << ", origin: (" << originX << ", " << originY << ")\n";
 
     // ---- build the grid ----
     // grid[row][col]: empty = "", occupied = first-two-chars label, collision = "*"
     // row 0 = bottom, row size-1 = top
     vector<vector<string>> grid(size, vector<string>(size, ""));
-
-    // Collect objects from Model
-    auto objects = Model::get().getAllObjects();
     vector<string> outsideNames;
 
-    for (const auto& obj : objects) {
-        double wx = obj->getLocation().first;
-        double wy = obj->getLocation().second;
+    auto place = [&](NameId id, double wx, double wy) {
+        const string& name = NameTable::get().str(id);
         int col, row;
         if (worldToGrid(wx, wy, col, row)) {
-            string label = obj->getName().substr(0, 2);
+            string label = name.substr(0, 2);
             if (grid[row][col].empty()) {
                 grid[row][col] = label;
             } else {
                 grid[row][col] = "*"; // collision marker
             }
         } else {
-            outsideNames.push_back(obj->getName());
+            outsideNames.push_back(name);
         }
+    };
+
+    // Ports (already in name order), then ships grouped by type and ordered by name
+    snap.ports.forEach([&](const PortRecord& p) { place(p.name, p.x, p.y); });
+    vector<size_t> order(snap.ships.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    sort(order.begin(), order.end(), [&snap](size_t a, size_t b) {
+        const ShipRecord& ra = snap.ships[a];
+        const ShipRecord& rb = snap.ships[b];
+        if (ra.type != rb.type) return ra.type < rb.type;
+        return NameTable::get().str(ra.name) < NameTable::get().str(rb.name);
+    });
+    for (size_t i : order) {
+        const ShipRecord& r = snap.ships[i];
+        place(r.name, r.x, r.y);
     }
 
     // ---- print outside-map warnings ----
     for (const auto& name : outsideNames) {
-        cout << name << " is outside the map\n";
+        out << name << " is outside the map\n";
     }
 
     // ---- print rows top-to-bottom ----
@@ -122,33 +135,33 @@ void View::draw() const {
             // right-align in 4 chars
             ostringstream lbl;
             lbl << fixed << setprecision(0) << rowY;
-            cout << setw(4) << lbl.str() << " ";
+            out << setw(4) << lbl.str() << " ";
         } else {
-            cout << "     ";
+            out << "     ";
         }
 
         for (int c = 0; c < size; ++c) {
             const string& cell = grid[r][c];
             if (cell.empty()) {
-                cout << ". ";
+                out << ". ";
             } else if (cell == "*") {
-                cout << "* ";
+                out << "* ";
             } else {
                 // Two-char label; no trailing space (occupies both char slots)
-                cout << cell;
+                out << cell;
             }
         }
-        cout << "\n";
+        out << "\n";
     }
 
     // ---- x-axis labels ----
     // Print x coordinate labels below; one label per 5 columns, right-aligned in 6 chars
-    cout << "   "; // offset to align with the grid body (5 spaces label + 1 space gap = 6 leading on rows)
+    out << "   "; // offset to align with the grid body (5 spaces label + 1 space gap = 6 leading on rows)
     for (int c = 0; c < size; c += 5) {
         double xVal = originX + c * scale;
         ostringstream lbl;
         lbl << fixed << setprecision(0) << xVal;
-        cout << setw(6) << lbl.str();
+        out << setw(6) << lbl.str();
     }
-    cout << "\n";
+    out << "\n";
 }
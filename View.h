@@ -11,6 +11,10 @@
 
 #pragma once
 
+#include <iosfwd>
+
+struct ModelSnapshot;
+
 class View {
 public:
     // Construct with default parameters
@@ -31,12 +35,13 @@ public:
 
     // Rendering
     /**
-     * Draw the current map to stdout.
-     * Fetches all objects from Model, places their 2-char labels in the grid,
-     * and prints with y-axis labels on the left and x-axis labels on the bottom.
-     * Objects outside the map boundary are noted with a warning message.
+     * Draw the map of a published Model snapshot to out.
+     * Places each object's 2-char label in the grid and prints with y-axis
+     * labels on the left and x-axis labels on the bottom. Objects outside the
+     * map boundary are noted with a warning message. Reads only the snapshot,
+     * so it may run on any thread while the Model keeps ticking.
      */
-    void draw() const;
+    void draw(const ModelSnapshot& snap, std::ostream& out) const;
 
 private:
     int    size;    // grid dimension (size x size cells)
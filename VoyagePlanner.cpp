@@ -0,0 +1,209 @@
+//
+// VoyagePlanner implementation
+//
+#include "VoyagePlanner.h"
+#include "FuelModel.h"
+#include "Geodesy.h"
+#include <algorithm>
+#include <cmath>
+
+VoyagePlanner::VoyagePlanner(Router& router) : router(router) {}
+
+void VoyagePlanner::addPort(NameId id, Location location) {
+    size_t n = ids.size();
+    ids.push_back(id);
+    locations.push_back(location);
+    if (id >= indexOf.size()) indexOf.resize(id + 1, -1);
+    indexOf[id] = static_cast<int32_t>(n);
+    memo.clear(); // a new port can shorten any voyage
+}
+
+// The last port takes the removed one's index: its row and column move too if
+// the table covers it, and are cleared if not
+void VoyagePlanner::removePort(NameId id) {
+    size_t n = ids.size(), index = indexOf[id], last = n - 1;
+    if (index != last) {
+        if (known == n) {
+            for (size_t k = 0; k < n; ++k) {
+                lengths[index * n + k] = lengths[last * n + k];
+                lengths[k * n + index] = lengths[k * n + last];
+            }
+            lengths[index * n + index] = -1.0;
+        } else if (index < known) {
+            for (size_t k = 0; k < known; ++k)
+                lengths[index * known + k] = lengths[k * known + index] = -1.0;
+        }
+        ids[index]       = ids[last];
+        locations[index] = locations[last];
+        indexOf[ids[index]] = static_cast<int32_t>(index);
+    }
+    if (known == n) {
+        vector<double> shrunk(last * last);
+        for (size_t i = 0; i < last; ++i)
+            copy(lengths.begin() + i * n, lengths.begin() + i * n + last, shrunk.begin() + i * last);
+        lengths.swap(shrunk);
+        known = last;
+    }
+    ids.pop_back();
+    locations.pop_back();
+    indexOf[id] = -1;
+    memo.clear();
+}
+
+void VoyagePlanner::invalidate() {
+    fill(lengths.begin(), lengths.end(), -1.0);
+    memo.clear();
+}
+
+void VoyagePlanner::setNavigation(Navigation mode) {
+    navigation = mode;
+    invalidate();
+}
+
+void VoyagePlanner::setFuelModel(const FuelModel& model) {
+    fuelModel = &model;
+    memo.clear();
+}
+
+double VoyagePlanner::legLength(Location a, Location b) {
+    if (!router.enabled()) return distanceNm(navigation, a.first, a.second, b.first, b.second);
+    shared_ptr<const Route> route = router.route(a, b);
+    if (!route) return HUGE_VAL;
+    double length = 0;
+    for (const Location& w : *route) {
+        length += distanceNm(navigation, a.first, a.second, w.first, w.second);
+        a = w;
+    }
+    return length;
+}
+
+void VoyagePlanner::growLengths() {
+    size_t n = ids.size();
+    vector<double> grown(n * n, -1.0);
+    for (size_t i = 0; i < known; ++i)
+        copy(lengths.begin() + i * known, lengths.begin() + (i + 1) * known, grown.begin() + i * n);
+    lengths.swap(grown);
+    known = n;
+}
+
+double VoyagePlanner::portLength(int i, int j) {
+    size_t n = known;
+    double& length = lengths[i * n + j];
+    if (length < 0) length = lengths[j * n + i] = legLength(locations[i], locations[j]);
+    return length;
+}
+
+void VoyagePlanner::buildLayers(const double* firstLegs, double firstMax, double legMax, Layers& layers) {
+    const int ports = static_cast<int>(ids.size());
+    layers.reach.assign((VOYAGE_MAX_STOPS + 1) * ports, HUGE_VAL);
+    layers.parent.assign((VOYAGE_MAX_STOPS + 1) * ports, -1);
+    for (int j = 0; j < ports; ++j)
+        if (firstLegs[j] <= firstMax) layers.reach[j] = firstLegs[j];
+    for (int k = 1; k <= VOYAGE_MAX_STOPS; ++k) {
+        const double* prev = &layers.reach[(k - 1) * ports];
+        double*  cur = &layers.reach[k * ports];
+        int32_t* par = &layers.parent[k * ports];
+        for (int m = 0; m < ports; ++m) {
+            if (prev[m] == HUGE_VAL) continue;
+            for (int j = 0; j < ports; ++j) {
+                if (j == m) continue;
+                double length = portLength(m, j);
+                if (length > legMax || prev[m] + length >= cur[j]) continue;
+                cur[j] = prev[m] + length;
+                par[j] = m;
+            }
+        }
+    }
+}
+
+/**
+ * Rounds at rising trial speeds v (whole speed steps). At v a leg fits if its
+ * length times perNm(v) fits the fuel aboard (first leg) or a full tank (after
+ * a stop). For each stop count k the shortest chain D_k to the destination
+ * needs speed max(vEcon, D_k / (hours - k * STOP)): at or below v it is a valid
+ * voyage (perNm does not fall above vEcon, so its legs fit at that speed too);
+ * above v it is retried in a later round at that speed.
+ */
+shared_ptr<const VoyagePlan> VoyagePlanner::plan(ShipType type, Location from, NameId fromPort, double fuel,
+                                                 NameId to, double hours) {
+    if (to >= indexOf.size() || indexOf[to] < 0) return nullptr;
+    if (known != ids.size()) growLengths();
+    const ShipTraits& traits = SHIP_TRAITS[type];
+    const FuelModel& model = *fuelModel;
+    const int ports  = static_cast<int>(ids.size());
+    const int target = indexOf[to];
+    const int origin = fromPort < indexOf.size() ? indexOf[fromPort] : -1;
+    const double vEcon = min(model.economicalSpeed(traits), traits.maxSpeed);
+    const double step  = traits.maxSpeed / VOYAGE_SPEED_LEVELS;
+    const bool memoized = origin >= 0 && fuel >= traits.maxFuel;
+
+    // First legs; from sea only ports the straight line (a lower bound) puts within reach get a route
+    first.assign(ports, HUGE_VAL);
+    const double leastBurn = model.perNm(traits, vEcon);
+    for (int j = 0; j < ports; ++j) {
+        if (j == origin) continue;
+        if (origin >= 0) first[j] = portLength(origin, j);
+        else if (distanceNm(navigation, from.first, from.second, locations[j].first, locations[j].second) * leastBurn <= fuel)
+            first[j] = legLength(from, locations[j]);
+    }
+
+    shared_ptr<VoyagePlan> best;
+    double bestFuel = HUGE_VAL;
+    int level = max(1, static_cast<int>(ceil(vEcon / step - 1e-9)));
+    while (level <= VOYAGE_SPEED_LEVELS) {
+        const double v = level * step;
+        const double burn = model.perNm(traits, v);
+        const Layers* layers = &scratch;
+        if (memoized) {
+            uint64_t key = static_cast<uint64_t>(origin) << 16 | static_cast<uint64_t>(type) << 8
+                           | static_cast<uint64_t>(level);
+            auto it = memo.find(key);
+            if (it == memo.end()) {
+                ++misses;
+                auto built = make_shared<Layers>();
+                buildLayers(first.data(), traits.maxFuel / burn, traits.maxFuel / burn, *built);
+                if (memo.size() >= VOYAGE_MEMO_CAPACITY) memo.clear();
+                it = memo.emplace(key, move(built)).first;
+            } else {
+                ++hits;
+            }
+            layers = it->second.get();
+        } else {
+            buildLayers(first.data(), fuel / burn, traits.maxFuel / burn, scratch);
+        }
+
+        double next = HUGE_VAL; // lowest speed above v that some chain needs
+        for (int k = 0; k <= VOYAGE_MAX_STOPS; ++k) {
+            double distance = layers->reach[k * ports + target];
+            double sailing  = hours - k * VOYAGE_STOP_HOURS;
+            if (distance == HUGE_VAL || sailing <= 0) continue;
+            double speed = max(vEcon, distance / sailing);
+            if (speed > traits.maxSpeed) continue;
+            if (speed > v) {
+                next = min(next, speed);
+                continue;
+            }
+            double perNm = model.perNm(traits, speed);
+            if (distance * perNm >= bestFuel) continue;
+
+            // Walk the parents back to the start
+            vector<int> stops(k + 1);
+            for (int layer = k, j = target; layer >= 0; --layer) {
+                stops[layer] = j;
+                j = layers->parent[layer * ports + j];
+            }
+            auto voyage = make_shared<VoyagePlan>();
+            for (int i = 0; i <= k; ++i) {
+                double length = i == 0 ? first[stops[0]] : portLength(stops[i - 1], stops[i]);
+                voyage->legs.push_back(VoyageLeg{ ids[stops[i]], length, speed, length * perNm });
+            }
+            voyage->hours = distance / speed + k * VOYAGE_STOP_HOURS;
+            voyage->fuel  = distance * perNm;
+            bestFuel = voyage->fuel;
+            best = move(voyage);
+        }
+        if (next == HUGE_VAL) break;
+        level = max(level + 1, static_cast<int>(ceil(next / step - 1e-9)));
+    }
+    return best;
+}
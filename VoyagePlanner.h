@@ -0,0 +1,126 @@
+//
+// VoyagePlanner: least-fuel voyages to a port within a deadline.
+//
+// A voyage is a chain of legs between ports: straight to the destination, or
+// through refuel stops when one tank does not reach (or when stopping is what
+// lets the ship slow to an economical speed). Under the fuel model (see
+// FuelModel.h) the hourly burn is convex in speed, so for a given chain one
+// common speed is optimal: the economical speed, or the slowest speed that
+// still meets the deadline if that is faster. A chain with D nm and k stops
+// therefore costs D * perNm(max(vEcon, D / (T - k * STOP))) and each leg must
+// fit the tank at that speed.
+//
+// The search is a shortest path over the port graph, layered by stop count
+// (Bellman-Ford, at most VOYAGE_MAX_STOPS stops): at a trial speed it finds,
+// for every port, the shortest chain of each length whose legs fit the tank;
+// the speed is then raised to the next one any chain to the destination needs,
+// until every chain is either valid or cannot make the deadline. Trial speeds
+// are rounded up to VOYAGE_SPEED_LEVELS steps of full speed, so a leg is
+// judged at most one step conservatively and the layers of a speed step serve
+// every destination and deadline: they are memoized per (origin port, ship
+// type, speed step) for ships leaving a port with a full tank, which is how
+// voyages start and how they replan at each stop. Port-to-port leg lengths
+// (around obstacles when there are any) are computed once and kept.
+//
+
+#ifndef INC_74_EX3_VOYAGEPLANNER_H
+#define INC_74_EX3_VOYAGEPLANNER_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Geodesy.h"
+#include "NameTable.h"
+#include "Routing.h"
+#include "ShipTraits.h"
+#include "Sim_object.h"
+using namespace std;
+
+class FuelModel;
+
+static const int    VOYAGE_MAX_STOPS     = 3;    // refuel stops considered per voyage
+static const double VOYAGE_STOP_HOURS    = 1.0;  // a stop costs the rest of the arrival hour
+static const int    VOYAGE_SPEED_LEVELS  = 32;   // trial speeds per full speed
+static const size_t VOYAGE_MEMO_CAPACITY = 4096; // memoized layers kept before the memo is cleared
+
+struct VoyageLeg {
+    NameId port;     // where the leg ends: a refuel stop, or the destination
+    double distance; // nm
+    double speed;    // nm/hr
+    double fuel;     // kl burned on the leg
+};
+
+struct VoyagePlan {
+    vector<VoyageLeg> legs;
+    double hours = 0; // sailing time plus VOYAGE_STOP_HOURS per stop
+    double fuel  = 0; // kl burned in total
+};
+
+class VoyagePlanner {
+public:
+    // Leg lengths follow router's routes whenever it has obstacles
+    explicit VoyagePlanner(Router& router);
+
+    // Ports form the graph; adding one keeps the lengths already known (O(1): the
+    // length table grows at the next plan(), once for every port added since)
+    void addPort(NameId id, Location location);
+
+    // Take a port out of the graph (the last one takes its index); drops memoized layers
+    void removePort(NameId id);
+
+    // Forget leg lengths and memoized layers (obstacles changed)
+    void invalidate();
+
+    // The world's navigation mode (lengths are forgotten) and fuel model (layers are; the Model owns it)
+    void setNavigation(Navigation mode);
+    void setFuelModel(const FuelModel& model);
+
+    /**
+     * Least-fuel voyage for a ship of type at from (on port fromPort, or NO_NAME
+     * at sea) with fuel kl aboard, to port `to` within hours. Refuel stops
+     * assume a full tank when sailing on. nullptr if no voyage makes it.
+     */
+    shared_ptr<const VoyagePlan> plan(ShipType type, Location from, NameId fromPort, double fuel,
+                                      NameId to, double hours);
+
+    // Layers of a full-tank start found in the memo / computed
+    size_t getMemoHits()   const { return hits; }
+    size_t getMemoMisses() const { return misses; }
+
+private:
+    Router& router;
+    Navigation navigation = Planar;
+    const FuelModel* fuelModel = nullptr;
+
+    vector<NameId>   ids;       // port index -> name
+    vector<Location> locations; // port index -> location
+    vector<int32_t>  indexOf;   // NameId -> port index, -1 for non-ports
+    vector<double>   lengths;   // known x known leg lengths in nm, row-major; < 0 = not computed yet
+    size_t           known = 0; // ports (the first ones) the lengths table covers
+
+    // Shortest chains from one start at one trial speed: (VOYAGE_MAX_STOPS + 1) layers of one entry per port
+    struct Layers {
+        vector<double>  reach;  // layer k: shortest chain with k stops ending at each port
+        vector<int32_t> parent; // layer k: the stop before it (in layer k - 1), or -1 from the start
+    };
+    unordered_map<uint64_t, shared_ptr<const Layers>> memo; // by (origin, type, speed step)
+    size_t hits = 0, misses = 0;
+
+    vector<double> first;   // leg length from the start to each port, infinite if out of reach
+    Layers         scratch; // for starts that are not memoized (at sea, or short of a full tank)
+
+    // Leg length between two points (around obstacles); infinite if there is no sea route
+    double legLength(Location a, Location b);
+
+    // Extend the lengths table to every port
+    void growLengths();
+
+    // Cached length between ports i and j
+    double portLength(int i, int j);
+
+    // Fill layers from first-leg lengths; legs fit if at most firstMax (the first) or legMax nm
+    void buildLayers(const double* firstLegs, double firstMax, double legMax, Layers& layers);
+};
+
+#endif //INC_74_EX3_VOYAGEPLANNER_H
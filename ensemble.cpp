@@ -0,0 +1,163 @@
+/*
+ * ensemble.cpp
+ *
+ * Monte-Carlo ensemble: samples many futures of one world (see Ensemble.h).
+ *
+ * Usage:  ensemble <portfile> <checkpoint-script> <future-script> [--branches N] [--jobs J]
+ *                  [--seed S] [--ticks K] [--combat stochastic|deterministic] [--history H]
+ *                  [--substeps N] [--geodesic] [--obstacles FILE] [--fuel-model NAME]
+ *
+ * Builds one world from the port file and replays the checkpoint script in
+ * it. That state is then branched N times (default 100), at most J branches
+ * running at once (default: one per hardware thread). Every branch replays
+ * the future script with its own random stream (branch seeds derive from S,
+ * default 1) and runs until K hours past the checkpoint. Combat is stochastic
+ * unless --combat says otherwise (see Combat.h); the checkpoint script plays
+ * under the same combat and seed. The other options configure the world as
+ * in soak.
+ *
+ * Report (stdout): the checkpoint, the branch count and wall time, then over
+ * the branches the distribution (mean, sd, p5 / p50 / p95, range) of attacks,
+ * cruiser wins and containers lost, and for every ship that ended off its
+ * checkpoint force (cruisers) or resistance in some branch, the distribution
+ * of its final value with a histogram.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Model.h"
+#include "Controller.h"
+#include "Ensemble.h"
+#include "PortFile.h"
+#include "ObstacleFile.h"
+#include "FuelModel.h"
+#include "Geodesy.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+static bool readScript(const string& path, vector<string>& lines) {
+    ifstream file(path);
+    if (!file.is_open()) return false;
+    string line;
+    while (getline(file, line)) lines.push_back(line);
+    return true;
+}
+
+static void printDistribution(const string& label, const Distribution& d) {
+    cout << label << "mean " << d.mean << " (sd " << d.stddev << "), p5 / p50 / p95 "
+         << d.p5 << " / " << d.p50 << " / " << d.p95 << ", range [" << d.min << ", " << d.max << "]\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        cerr << "Usage: " << argv[0] << " <portfile> <checkpoint-script> <future-script> [--branches N] [--jobs J]"
+                " [--seed S] [--ticks K] [--combat stochastic|deterministic] [--history H] [--substeps N]"
+                " [--geodesic] [--obstacles FILE] [--fuel-model NAME]\n";
+        return 1;
+    }
+    EnsembleSettings settings;
+    long branches = static_cast<long>(settings.branches), history = static_cast<long>(DEFAULT_TRACK_DEPTH);
+    int jobs = 0, substeps = 1;
+    string combat = "stochastic", obstaclePath, fuelModel = "constant";
+    bool geodesic = false;
+    for (int i = 4; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--branches" && i + 1 < argc)       branches = stol(argv[++i]);
+        else if (flag == "--jobs" && i + 1 < argc)      jobs = stoi(argv[++i]);
+        else if (flag == "--seed" && i + 1 < argc)      settings.seed = stoull(argv[++i]);
+        else if (flag == "--ticks" && i + 1 < argc)     settings.ticks = stol(argv[++i]);
+        else if (flag == "--combat" && i + 1 < argc)    combat = argv[++i];
+        else if (flag == "--history" && i + 1 < argc)   history = stol(argv[++i]);
+        else if (flag == "--substeps" && i + 1 < argc)  substeps = stoi(argv[++i]);
+        else if (flag == "--geodesic")                  geodesic = true;
+        else if (flag == "--obstacles" && i + 1 < argc) obstaclePath = argv[++i];
+        else if (flag == "--fuel-model" && i + 1 < argc) fuelModel = argv[++i];
+        else { cerr << "Error: unknown option " << flag << "\n"; return 1; }
+    }
+    if (branches < 1) { cerr << "Error: --branches must be at least 1\n"; return 1; }
+    if (jobs < 0) { cerr << "Error: --jobs must not be negative\n"; return 1; }
+    if (settings.ticks < 0) { cerr << "Error: --ticks must not be negative\n"; return 1; }
+    if (history < 0) { cerr << "Error: --history must not be negative\n"; return 1; }
+    if (substeps < 1) { cerr << "Error: --substeps must be at least 1\n"; return 1; }
+    settings.branches = static_cast<size_t>(branches);
+    settings.jobs     = static_cast<unsigned>(jobs);
+
+    vector<string> checkpointScript, future;
+    if (!readScript(argv[2], checkpointScript)) {
+        cerr << "Error: cannot open script '" << argv[2] << "'\n";
+        return 1;
+    }
+    if (!readScript(argv[3], future)) {
+        cerr << "Error: cannot open script '" << argv[3] << "'\n";
+        return 1;
+    }
+
+    // The checkpoint world's own chatter is not part of the report
+    ostringstream sink;
+    Model model(sink);
+    try {
+        if (geodesic) model.setNavigation(Geodesic);
+        model.setFuelModel(makeFuelModel(fuelModel));
+        model.setCombat(parseCombatMode(combat));
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    model.seed(settings.seed);
+    model.setSubsteps(substeps);
+    model.setTrackDepth(static_cast<size_t>(history));
+    try {
+        loadPortFile(model, argv[1]);
+        if (!obstaclePath.empty()) loadObstacleFile(model, obstaclePath);
+    } catch (const runtime_error& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+    {
+        Controller controller(model, sink, cerr);
+        for (const string& line : checkpointScript)
+            if (!controller.parseCommand(line)) break; // "exit"
+    }
+
+    const CommandScript futureScript = CommandScript::compile(future);
+    vector<BranchOutcome> outcomes;
+    auto wallStart = Clock::now();
+    try {
+        outcomes = runEnsemble(model, futureScript, settings);
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    double wallS = chrono::duration<double>(Clock::now() - wallStart).count();
+    EnsembleSummary summary = summarizeEnsemble(model, outcomes);
+
+    unsigned running = jobs > 0 ? static_cast<unsigned>(jobs) : max(1u, thread::hardware_concurrency());
+    cout << fixed << setprecision(2);
+    cout << "checkpoint:      time " << model.getTime() << ", " << model.getAllObjects().size() << " objects\n";
+    cout << "branches:        " << summary.branches << " (" << running << " at a time), seed "
+         << settings.seed << ", " << combat << " combat\n";
+    cout << "wall time:       " << wallS << " s (" << (wallS > 0 ? summary.branches / wallS : 0)
+         << " branches/s)\n";
+    printDistribution("attacks:         ", summary.attacks);
+    printDistribution("cruiser wins:    ", summary.victories);
+    printDistribution("cargo lost:      ", summary.containersLost);
+    cout << "ships off their checkpoint force / resistance: " << summary.ships.size() << "\n";
+    for (const StrengthSpread& s : summary.ships) {
+        const string& name = NameTable::get().str(s.ship);
+        printDistribution("  " + name + ": from " + to_string(s.start) + ", ", s.spread);
+        cout << "   ";
+        for (const auto& bin : s.histogram) cout << " " << bin.first << ":" << bin.second;
+        cout << "\n";
+    }
+    return 0;
+}
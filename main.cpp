@@ -3,105 +3,165 @@
  *
  * Entry point for simNautica.
  *
- * Usage:  simNautica <portfile>
+ * Usage:  simNautica <portfile> [--serve unix:<path>|tcp:<port>] [--tick-ms <n>]
+ *                               [--realtime [--cpu <n>] [--degrade]] [--history <hours>]
+ *                               [--export <file>] [--substeps <n>] [--proximity <nm>]
+ *                               [--geodesic] [--obstacles <file>]
+ *                               [--fuel-model constant|cubic] [--combat deterministic|stochastic]
+ *                               [--seed <n>]
  *
  * The port file contains one port per line in the format:
  *   <name> (<x>, <y>) <initialFuel> <fuelRate>
  *
- * On success the program enters the interactive command loop via Controller::run().
+ * On success the program enters the interactive command loop via Controller::run(),
+ * or, with --serve, runs the local control server (see ControlServer.h) instead;
+ * --tick-ms makes the server advance time on its own every n milliseconds.
+ * --realtime holds the server to that schedule: it pins the simulation thread
+ * (to CPU n with --cpu), counts overruns and prints a pacing report at
+ * shutdown (see TickPacer.h); --degrade lets it skip publishing the status
+ * rather than miss a deadline.
+ * --history turns on trajectory recording for "track", keeping the given
+ * number of hours per ship (default 0: off).
+ * --export writes every tick's state to a columnar binary file (see TickExport.h,
+ * read it back with tickdump).
+ * --substeps enables exact sub-hour motion and cruiser approach reports with up to
+ * n steps per hour (see Model::setSubsteps; default 1 = whole-hour steps).
+ * --proximity reports ships passing within nm of each other (see Proximity.h
+ * and the "encounters" command; default off).
+ * --geodesic reads every (x, y) as (longitude, latitude) in degrees and sails
+ * ships along great circles (see Geodesy.h); speeds and ranges stay in nm.
+ * It cannot be combined with --proximity, which measures on the plane.
+ * --obstacles loads land / no-go polygons (see ObstacleFile.h) that ships are
+ * routed around (see Routing.h).
+ * --fuel-model picks how fuel burn depends on speed (see FuelModel.h; default
+ * constant, the burn rate per nm at any speed); it also drives "voyage" plans.
+ * --combat stochastic draws attack outcomes at odds set by force and resistance
+ * instead of always letting the stronger side win (see Combat.h); --seed seeds
+ * those draws (default 1), so a session replays the same way.
  * Any file or parse error is reported to stderr and the program exits with code 1.
  */
 
+#include <cstdlib>
+#include "Model.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <stdexcept>
 
-#include "Model.h"
 #include "Controller.h"
+#include "PortFile.h"
+#include "ObstacleFile.h"
+#include "FuelModel.h"
+#ifdef SIM_CONTROL_SERVER
+#include "ControlServer.h"
+#endif
 
 using namespace std;
 
 int main(int argc, char* argv[]) {
     // 1. Validate command-line arguments
-    if (argc != 2) {
-        cerr << "Usage: " << argv[0] << " <portfile>\n";
+    string serveEndpoint;
+    int tickMs = 0;
+    bool realTime = false;
+    int cpu = -1;
+    bool degrade = false;
+    int history = static_cast<int>(DEFAULT_TRACK_DEPTH);
+    string exportPath;
+    int substeps = 1;
+    double proximity = 0;
+    bool geodesic = false;
+    string obstaclePath;
+    string fuelModel = "constant";
+    string combat = "deterministic";
+    unsigned long long seed = 1;
+    bool argsOk = argc >= 2;
+    for (int i = 2; argsOk && i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--serve" && i + 1 < argc)        serveEndpoint = argv[++i];
+        else if (flag == "--tick-ms" && i + 1 < argc) tickMs = atoi(argv[++i]);
+        else if (flag == "--realtime")                realTime = true;
+        else if (flag == "--cpu" && i + 1 < argc)     cpu = atoi(argv[++i]);
+        else if (flag == "--degrade")                 degrade = true;
+        else if (flag == "--history" && i + 1 < argc) history = atoi(argv[++i]);
+        else if (flag == "--export" && i + 1 < argc)  exportPath = argv[++i];
+        else if (flag == "--substeps" && i + 1 < argc) substeps = atoi(argv[++i]);
+        else if (flag == "--proximity" && i + 1 < argc) proximity = atof(argv[++i]);
+        else if (flag == "--geodesic")                geodesic = true;
+        else if (flag == "--obstacles" && i + 1 < argc) obstaclePath = argv[++i];
+        else if (flag == "--fuel-model" && i + 1 < argc) fuelModel = argv[++i];
+        else if (flag == "--combat" && i + 1 < argc)  combat = argv[++i];
+        else if (flag == "--seed" && i + 1 < argc)    seed = strtoull(argv[++i], nullptr, 10);
+        else                                          argsOk = false;
+    }
+    bool modelOk = (fuelModel == "constant" || fuelModel == "cubic")
+                   && (combat == "deterministic" || combat == "stochastic");
+    // real-time mode needs a schedule to keep
+    bool realTimeOk = realTime ? !serveEndpoint.empty() && tickMs > 0 && cpu >= -1 : cpu == -1 && !degrade;
+    if (geodesic && proximity > 0) {
+        cerr << "Error: --proximity measures nm on the plane and cannot be combined with --geodesic\n";
         return 1;
     }
-
-    // 2. Open the port file
-    ifstream portFile(argv[1]);
-    if (!portFile.is_open()) {
-        cerr << "Error: cannot open port file '" << argv[1] << "'\n";
+    if (!argsOk || !modelOk || !realTimeOk || tickMs < 0 || history < 0 || substeps < 1 || proximity < 0) {
+        cerr << "Usage: " << argv[0]
+             << " <portfile> [--serve unix:<path>|tcp:<port>] [--tick-ms <n>] [--realtime [--cpu <n>] [--degrade]]"
+                " [--history <hours>] [--export <file>] [--substeps <n>] [--proximity <nm>]"
+                " [--geodesic] [--obstacles <file>] [--fuel-model constant|cubic]"
+                " [--combat deterministic|stochastic] [--seed <n>]\n";
         return 1;
     }
+    Model model;
+    model.setTrackDepth(static_cast<size_t>(history));
+    model.setSubsteps(substeps);
+    model.setProximityThreshold(proximity);
+    model.setCombat(parseCombatMode(combat));
+    model.seed(seed);
+    if (geodesic) model.setNavigation(Geodesic);
+    model.setFuelModel(makeFuelModel(fuelModel));
 
-    // 3. Parse ports and load them into the Model
+    // 2. Parse ports and load them into the Model
     //    Format per line:  <name> (<x>, <y>) <initialFuel> <fuelRate>
-    //    Empty lines and lines consisting only of whitespace are skipped.
-    string line;
-    int lineNum = 0;
     try {
-        while (getline(portFile, line)) {
-            ++lineNum;
-
-            // Skip blanks
-            istringstream probe(line);
-            string firstTok;
-            if (!(probe >> firstTok)) continue;
-
-            //name
-            string name = firstTok;
-            if (name.size() > 12) {
-                cerr << "Error (line " << lineNum << "): port name too long: " << name << "\n";
-                return 1;
-            }
-
-            // coordinates: "(x," and "y)" as two tokens
-            string coordA, coordB;
-            if (!(probe >> coordA >> coordB)) {
-                cerr << "Error (line " << lineNum << "): expected coordinates after port name\n";
-                return 1;
-            }
-            // Join and strip parentheses/comma
-            string coordStr = coordA + coordB;
-            string inner;
-            for (char c : coordStr)
-                if (c != '(' && c != ')') inner += c;
-            for (char& c : inner)
-                if (c == ',') c = ' ';
-            istringstream coordSS(inner);
-            double x, y;
-            if (!(coordSS >> x >> y)) {
-                cerr << "Error (line " << lineNum << "): invalid coordinates\n";
-                return 1;
-            }
-
-            // initialFuel and fuelRate
-            double initialFuel, fuelRate;
-            if (!(probe >> initialFuel >> fuelRate)) {
-                cerr << "Error (line " << lineNum << "): expected initialFuel and fuelRate\n";
-                return 1;
-            }
-            if (initialFuel < 0 || fuelRate < 0) {
-                cerr << "Error (line " << lineNum << "): fuel values must be non-negative\n";
-                return 1;
-            }
-
-            // add to model (throws if name already exists)
-            Model::get().addPort(name, x, y, initialFuel, fuelRate);
-        }
+        loadPortFile(model, argv[1]);
+        if (!obstaclePath.empty()) loadObstacleFile(model, obstaclePath);
     } catch (const runtime_error& e) {
-        cerr << "Error (line " << lineNum << "): " << e.what() << "\n";
+        cerr << e.what() << "\n";
         return 1;
     }
+    if (!exportPath.empty()) {
+        try {
+            model.startExport(exportPath);
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
 
-    portFile.close();
-
-    // 4. Hand control to the Controller
-    Controller controller;
-    controller.run();
+    // 3. Hand control to the Controller (or serve it to local clients)
+    Controller controller(model);
+    if (!serveEndpoint.empty()) {
+#ifdef SIM_CONTROL_SERVER
+        try {
+            RealTimeOptions rt;
+            rt.enabled = realTime;
+            rt.cpu     = cpu;
+            rt.degrade = degrade;
+            ControlServer server(controller, serveEndpoint, tickMs, rt);
+            server.run();
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+#else
+        cerr << "Error: control server is not available on this platform\n";
+        return 1;
+#endif
+    } else {
+        controller.run();
+    }
 
+    // 4. Flush the export, if any
+    if (!model.stopExport()) {
+        cerr << "Error: writing " << exportPath << " failed\n";
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
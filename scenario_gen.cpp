@@ -0,0 +1,292 @@
+/*
+ * scenario_gen.cpp
+ *
+ * Headless scenario generator for simNautica.
+ *
+ * Usage:  scenario_gen <outprefix> [options]
+ *
+ * Writes two files:
+ *   <outprefix>.ports  – port file accepted by simNautica / soak
+ *   <outprefix>.cmds   – command script (create, routing, attacks, go)
+ *
+ * Options (all optional):
+ *   --seed <n>            RNG seed (default 1); same seed => byte-identical output
+ *   --ports <n>           number of ports in addition to Nagoya (default 10)
+ *   --ships <n>           number of ships (default 100)
+ *   --mix <f>:<p>:<c>     relative weights of Freighter:Patrol_boat:Cruiser (default 6:3:1)
+ *   --world <nm>          side of the square world in nm (default 1000)
+ *   --speed <lo>:<hi>     speed range as a fraction of type max speed (default 0.2:1.0)
+ *   --ticks <n>           number of "go" commands to emit (default 100)
+ *   --attack-every <n>    emit an attack wave every n ticks, 0 = never (default 10)
+ *   --attack-wave <n>     attacks per wave (default 5)
+ *   --reroute-every <n>   re-route a slice of the fleet every n ticks, 0 = never (default 25)
+ *   --reroute-frac <f>    fraction of the fleet re-routed per wave (default 0.1)
+ *
+ * The generator uses its own splitmix64 generator and hand-rolled distributions
+ * so the output does not depend on the standard library implementation.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ShipTraits.h"
+using namespace std;
+
+// splitmix64: tiny, fast and fully specified
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    // Uniform in [0, 1)
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    // Uniform in [lo, hi)
+    double real(double lo, double hi) { return lo + (hi - lo) * unit(); }
+    // Uniform in [lo, hi]
+    int integer(int lo, int hi) { return lo + static_cast<int>(next() % static_cast<uint64_t>(hi - lo + 1)); }
+
+private:
+    uint64_t state;
+};
+
+enum GenType { GenFreighter, GenPatrol, GenCruiser };
+
+struct GenShip {
+    string  name;
+    GenType type;
+};
+
+struct Options {
+    uint64_t seed         = 1;
+    int      ports        = 10;
+    int      ships        = 100;
+    double   mix[3]       = {6, 3, 1};
+    double   world        = 1000.0;
+    double   speedLo      = 0.2;
+    double   speedHi      = 1.0;
+    int      ticks        = 100;
+    int      attackEvery  = 10;
+    int      attackWave   = 5;
+    int      rerouteEvery = 25;
+    double   rerouteFrac  = 0.1;
+};
+
+// Encode n as an alphabetic suffix so generated names stay valid ship names
+static string alphaName(char prefix, int n) {
+    string s;
+    do {
+        s.insert(s.begin(), static_cast<char>('a' + n % 26));
+        n /= 26;
+    } while (n > 0);
+    return string(1, prefix) + s;
+}
+
+// Per-type maxima, from the simulator's own ship traits
+static double maxSpeedOf(GenType t) {
+    switch (t) {
+        case GenFreighter: return FreighterTraits::maxSpeed;
+        case GenPatrol:    return PatrolTraits::maxSpeed;
+        case GenCruiser:   return CruiserTraits::maxSpeed;
+    }
+    return 0;
+}
+
+// Split "a:b[:c]" into doubles; throws on malformed input
+static vector<double> splitRatio(const string& s) {
+    vector<double> out;
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        size_t colon = s.find(':', pos);
+        if (colon == string::npos) colon = s.size();
+        out.push_back(stod(s.substr(pos, colon - pos)));
+        pos = colon + 1;
+    }
+    return out;
+}
+
+static Options parseOptions(int argc, char* argv[]) {
+    Options o;
+    for (int i = 2; i < argc; ++i) {
+        string flag = argv[i];
+        if (i + 1 >= argc) throw invalid_argument("missing value for " + flag);
+        string val = argv[++i];
+        if      (flag == "--seed")          o.seed = stoull(val);
+        else if (flag == "--ports")         o.ports = stoi(val);
+        else if (flag == "--ships")         o.ships = stoi(val);
+        else if (flag == "--world")         o.world = stod(val);
+        else if (flag == "--ticks")         o.ticks = stoi(val);
+        else if (flag == "--attack-every")  o.attackEvery = stoi(val);
+        else if (flag == "--attack-wave")   o.attackWave = stoi(val);
+        else if (flag == "--reroute-every") o.rerouteEvery = stoi(val);
+        else if (flag == "--reroute-frac")  o.rerouteFrac = stod(val);
+        else if (flag == "--mix") {
+            vector<double> m = splitRatio(val);
+            if (m.size() != 3) throw invalid_argument("--mix expects f:p:c");
+            for (int k = 0; k < 3; ++k) o.mix[k] = m[k];
+        } else if (flag == "--speed") {
+            vector<double> r = splitRatio(val);
+            if (r.size() != 2) throw invalid_argument("--speed expects lo:hi");
+            o.speedLo = r[0];
+            o.speedHi = r[1];
+        } else {
+            throw invalid_argument("unknown option " + flag);
+        }
+    }
+    if (o.ports < 0 || o.ships < 0 || o.ticks < 0)
+        throw invalid_argument("counts must be non-negative");
+    if (o.mix[0] + o.mix[1] + o.mix[2] <= 0)
+        throw invalid_argument("--mix weights must not all be zero");
+    if (o.speedLo <= 0 || o.speedHi > 1.0 || o.speedLo > o.speedHi)
+        throw invalid_argument("--speed must satisfy 0 < lo <= hi <= 1");
+    return o;
+}
+
+class Generator {
+public:
+    explicit Generator(const Options& o) : opt(o), rng(o.seed) {}
+
+    void writePorts(ostream& out) {
+        portNames.push_back("Nagoya"); // always present in the Model
+        out << fixed << setprecision(2);
+        for (int i = 0; i < opt.ports; ++i) {
+            string name = alphaName('P', i);
+            portNames.push_back(name);
+            out << name << " (" << rng.real(0, opt.world) << ", " << rng.real(0, opt.world) << ") "
+                << rng.real(0, 100000.0) << " " << rng.real(0, 1000.0) << "\n";
+        }
+    }
+
+    void writeCommands(ostream& out) {
+        out << fixed << setprecision(2);
+        createShips(out);
+        for (const auto& s : ships) route(out, s);
+
+        for (int t = 1; t <= opt.ticks; ++t) {
+            out << "go\n";
+            if (opt.attackEvery > 0 && t % opt.attackEvery == 0) attackWave(out);
+            if (opt.rerouteEvery > 0 && t % opt.rerouteEvery == 0) rerouteWave(out);
+        }
+    }
+
+private:
+    const Options& opt;
+    Rng rng;
+    vector<string>  portNames;
+    vector<GenShip> ships;
+    vector<size_t>  cruisers; // indices into ships
+    vector<size_t>  targets;  // indices into ships (non-cruisers)
+
+    GenType pickType() {
+        double total = opt.mix[0] + opt.mix[1] + opt.mix[2];
+        double r = rng.real(0, total);
+        if (r < opt.mix[0])               return GenFreighter;
+        if (r < opt.mix[0] + opt.mix[1])  return GenPatrol;
+        return GenCruiser;
+    }
+
+    const string& randomPort() {
+        return portNames[rng.integer(0, static_cast<int>(portNames.size()) - 1)];
+    }
+
+    double randomSpeed(GenType t) {
+        return maxSpeedOf(t) * rng.real(opt.speedLo, opt.speedHi);
+    }
+
+    void createShips(ostream& out) {
+        for (int i = 0; i < opt.ships; ++i) {
+            GenShip s{alphaName('S', i), pickType()};
+            out << "create " << s.name << " ";
+            double x = rng.real(0, opt.world), y = rng.real(0, opt.world);
+            switch (s.type) {
+                case GenFreighter:
+                    out << "Freighter (" << x << ", " << y << ") "
+                        << rng.integer(1, 10) << " " << rng.integer(10, 200) << "\n";
+                    break;
+                case GenPatrol:
+                    out << "Patrol_boat (" << x << ", " << y << ") " << rng.integer(1, 10) << "\n";
+                    break;
+                case GenCruiser:
+                    out << "Cruiser (" << x << ", " << y << ") "
+                        << rng.integer(1, 15) << " " << rng.integer(5, 50) << "\n";
+                    break;
+            }
+            (s.type == GenCruiser ? cruisers : targets).push_back(ships.size());
+            ships.push_back(s);
+        }
+    }
+
+    // Give a ship a new route appropriate to its type
+    void route(ostream& out, const GenShip& s) {
+        double speed = randomSpeed(s.type);
+        int kind = rng.integer(0, 2);
+        if (s.type == GenFreighter && kind == 0) {
+            const string& from = randomPort();
+            out << s.name << " load_at " << from << "\n";
+            out << s.name << " unload_at " << randomPort() << " " << rng.integer(1, 50) << "\n";
+            out << s.name << " destination " << from << " " << speed << "\n";
+        } else if (kind == 1 || s.type == GenPatrol) {
+            out << s.name << " destination " << randomPort() << " " << speed << "\n";
+        } else if (kind == 2) {
+            out << s.name << " course " << rng.real(0, 360) << " " << speed << "\n";
+        } else {
+            out << s.name << " position (" << rng.real(0, opt.world) << ", "
+                << rng.real(0, opt.world) << ") " << speed << "\n";
+        }
+    }
+
+    void attackWave(ostream& out) {
+        if (cruisers.empty() || targets.empty()) return;
+        for (int i = 0; i < opt.attackWave; ++i) {
+            const GenShip& c = ships[cruisers[rng.integer(0, static_cast<int>(cruisers.size()) - 1)]];
+            const GenShip& t = ships[targets[rng.integer(0, static_cast<int>(targets.size()) - 1)]];
+            out << c.name << " attack " << t.name << "\n";
+        }
+    }
+
+    void rerouteWave(ostream& out) {
+        if (ships.empty()) return;
+        int n = static_cast<int>(ships.size() * opt.rerouteFrac);
+        for (int i = 0; i < n; ++i)
+            route(out, ships[rng.integer(0, static_cast<int>(ships.size()) - 1)]);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <outprefix> [--seed n] [--ports n] [--ships n] [--mix f:p:c]\n"
+             << "       [--world nm] [--speed lo:hi] [--ticks n] [--attack-every n] [--attack-wave n]\n"
+             << "       [--reroute-every n] [--reroute-frac f]\n";
+        return 1;
+    }
+
+    Options opt;
+    try {
+        opt = parseOptions(argc, argv);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    string prefix = argv[1];
+    ofstream portOut(prefix + ".ports");
+    ofstream cmdOut(prefix + ".cmds");
+    if (!portOut.is_open() || !cmdOut.is_open()) {
+        cerr << "Error: cannot write output files with prefix '" << prefix << "'\n";
+        return 1;
+    }
+
+    Generator gen(opt);
+    gen.writePorts(portOut);
+    gen.writeCommands(cmdOut);
+    return 0;
+}
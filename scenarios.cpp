@@ -0,0 +1,166 @@
+/*
+ * scenarios.cpp
+ *
+ * Runs many what-if scenarios at once, each in a world of its own (see
+ * ScenarioRunner.h).
+ *
+ * Usage:  scenarios <portfile> <script>... [--copies N] [--threads T] [--ticks K] [--history H]
+ *                   [--substeps N] [--proximity NM] [--geodesic] [--obstacles FILE]
+ *                   [--fuel-model NAME] [--verbose]
+ *
+ * The port file (and obstacle file) is read once and shared by every world.
+ * Each script is compiled once (CommandScript.h) and replayed through the
+ * Controller of a fresh world; --copies
+ * runs every script N times over (to load more threads with the same work);
+ * --threads sets the number of worker threads (default: one per hardware
+ * thread); --ticks keeps each world going after its script until it has run
+ * K ticks. --history, --substeps, --proximity, --geodesic and --fuel-model
+ * apply to every world as in soak. --verbose prints everything each world
+ * printed, world by world, before the report, after the lines of each script
+ * that did not compile (they are replayed as text).
+ *
+ * Report (stdout), one line per world in the order given:
+ *   <script>[#copy]: time T, N objects, checksum 0x..., CPU time of the world
+ * then the thread count, the total wall time, and the speedup: the worlds' CPU
+ * time added up over the wall time, i.e. how many times faster they ran than
+ * one after another would have. The checksum is that of the final
+ * "status" output, as in soak, so a world can be compared with a soak run.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ScenarioRunner.h"
+#include "PortFile.h"
+#include "ObstacleFile.h"
+#include "FuelModel.h"
+#include "Geodesy.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// 64-bit FNV-1a
+static uint64_t fnv1a(const string& s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <portfile> <script>... [--copies N] [--threads T] [--ticks K]"
+                " [--history H] [--substeps N] [--proximity NM] [--geodesic] [--obstacles FILE]"
+                " [--fuel-model NAME] [--verbose]\n";
+        return 1;
+    }
+    vector<string> scripts;
+    WorldSettings settings;
+    long copies = 1, history = static_cast<long>(DEFAULT_TRACK_DEPTH);
+    int threads = 0;
+    bool verbose = false;
+    string obstaclePath, fuelModel = "constant";
+    for (int i = 2; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--copies" && i + 1 < argc)         copies = stol(argv[++i]);
+        else if (flag == "--threads" && i + 1 < argc)   threads = stoi(argv[++i]);
+        else if (flag == "--ticks" && i + 1 < argc)     settings.minTicks = stol(argv[++i]);
+        else if (flag == "--history" && i + 1 < argc)   history = stol(argv[++i]);
+        else if (flag == "--substeps" && i + 1 < argc)  settings.substeps = stoi(argv[++i]);
+        else if (flag == "--proximity" && i + 1 < argc) settings.proximity = stod(argv[++i]);
+        else if (flag == "--geodesic")                  settings.navigation = Geodesic;
+        else if (flag == "--obstacles" && i + 1 < argc) obstaclePath = argv[++i];
+        else if (flag == "--fuel-model" && i + 1 < argc) fuelModel = argv[++i];
+        else if (flag == "--verbose")                   verbose = true;
+        else if (flag.compare(0, 2, "--") == 0) { cerr << "Error: unknown option " << flag << "\n"; return 1; }
+        else                                            scripts.push_back(flag);
+    }
+
+    if (scripts.empty()) { cerr << "Error: no scenario scripts given\n"; return 1; }
+    if (copies < 1) { cerr << "Error: --copies must be at least 1\n"; return 1; }
+    if (threads < 0) { cerr << "Error: --threads must not be negative\n"; return 1; }
+    if (history < 0) { cerr << "Error: --history must not be negative\n"; return 1; }
+    if (settings.substeps < 1) { cerr << "Error: --substeps must be at least 1\n"; return 1; }
+    if (settings.proximity < 0) { cerr << "Error: --proximity must not be negative\n"; return 1; }
+    if (settings.proximity > 0 && settings.navigation == Geodesic) {
+        cerr << "Error: --proximity cannot be combined with --geodesic\n";
+        return 1;
+    }
+    settings.trackDepth = static_cast<size_t>(history);
+    try {
+        settings.fuelModel = makeFuelModel(fuelModel);
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    shared_ptr<const PortTable> ports;
+    vector<Polygon> obstacles;
+    try {
+        ports = make_shared<const PortTable>(readPortFile(argv[1]));
+        if (!obstaclePath.empty()) obstacles = readObstacleFile(obstaclePath);
+    } catch (const runtime_error& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+
+    vector<Scenario> scenarios;
+    for (const string& path : scripts) {
+        ifstream file(path);
+        if (!file.is_open()) {
+            cerr << "Error: cannot open script '" << path << "'\n";
+            return 1;
+        }
+        vector<string> lines;
+        string line;
+        while (getline(file, line)) lines.push_back(line);
+        auto script = make_shared<const CommandScript>(CommandScript::compile(lines));
+        if (verbose)
+            for (const string& d : script->getDiagnostics()) cout << path << ": " << d << "\n";
+        for (long c = 0; c < copies; ++c)
+            scenarios.push_back(Scenario{ copies > 1 ? path + "#" + to_string(c + 1) : path, script });
+    }
+
+    ScenarioRunner runner(ports, move(obstacles), settings);
+    unsigned workers = threads > 0 ? static_cast<unsigned>(threads) : max(1u, thread::hardware_concurrency());
+    workers = static_cast<unsigned>(min<size_t>(workers, scenarios.size()));
+    auto wallStart = Clock::now();
+    vector<ScenarioResult> results = runner.run(scenarios, workers);
+    double wallS = chrono::duration<double>(Clock::now() - wallStart).count();
+
+    if (verbose)
+        for (size_t i = 0; i < results.size(); ++i)
+            cout << "== " << scenarios[i].name << "\n" << results[i].output;
+
+    double worldS = 0;
+    int failed = 0;
+    cout << fixed << setprecision(1);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ScenarioResult& r = results[i];
+        worldS += r.cpuSeconds;
+        if (!r.error.empty()) {
+            cout << scenarios[i].name << ": " << r.error << "\n";
+            ++failed;
+            continue;
+        }
+        cout << scenarios[i].name << ": time " << r.time << ", " << r.objects << " objects, checksum 0x"
+             << hex << setw(16) << setfill('0') << fnv1a(r.status) << dec << setfill(' ')
+             << ", " << r.cpuSeconds * 1000 << " ms CPU\n";
+    }
+    cout << "worlds:         " << results.size() << " on " << workers << " thread(s)\n";
+    cout << "wall time:      " << wallS << " s\n";
+    cout << setprecision(2);
+    cout << "speedup:        " << (wallS > 0 ? worldS / wallS : 0) << "x over one world at a time\n";
+    return failed > 0 ? 1 : 0;
+}
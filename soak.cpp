@@ -0,0 +1,295 @@
+/*
+ * soak.cpp
+ *
+ * Headless soak-test harness for simNautica.
+ *
+ * Usage:  soak <portfile> <script> [--ticks K] [--history H] [--export FILE] [--substeps N]
+ *              [--proximity NM] [--geodesic] [--obstacles FILE] [--fuel-model NAME] [--profile]
+ *              [--pace MS [--cpu N]] [--verbose]
+ *
+ * Loads the port file, replays the command script through the Controller and
+ * times every "go" with a steady clock. If the script contains fewer than K
+ * "go" commands, extra ticks are run after the script until K ticks have
+ * elapsed. Simulation chatter on stdout is suppressed unless --verbose is given.
+ * --history turns on the trajectory log with that depth in hours (default off);
+ * --export streams every tick to a columnar file, to measure its cost on ticks;
+ * --substeps turns on sub-stepped motion (Model::setSubsteps); --proximity turns
+ * on encounter detection and adds the number of encounters found to the report;
+ * --geodesic runs the scenario under great-circle navigation (see Geodesy.h);
+ * --obstacles routes ships around the polygons in FILE (see Routing.h) and
+ * reports how many port-to-port routes were computed and how many reused;
+ * --fuel-model selects the fuel model (see FuelModel.h), and when the script
+ * starts voyages the report adds how many plans were searched and how many
+ * came from the planner's memo. --profile adds the tick profile (see Profiler.h):
+ * time and hardware counters per phase, per ship type. --pace runs every tick
+ * on a real-time schedule of one per MS milliseconds (fractions allowed),
+ * pinned to CPU N with --cpu, and adds the pacing report (see TickPacer.h).
+ *
+ * Report (stderr is left for command errors, the report goes to stdout):
+ *   tick-time percentiles (p50/p90/p99/max, microseconds)
+ *   peak RSS and RSS growth across the ticking phase
+ *   per-ship object size (shrinks when built with SIM_COMPACT_STATE)
+ *   how many snapshot chunks the last tick shared with the previous epoch
+ *   heap allocations made by ticks, overall and once the script has ended
+ *   a checksum of the final "status" output, for comparing runs
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "Model.h"
+#include "Controller.h"
+#include "Cruiser.h"
+#include "Freighter.h"
+#include "Patrol.h"
+#include "PortFile.h"
+#include "ObstacleFile.h"
+#include "FuelModel.h"
+#include "Profiler.h"
+#include "TickPacer.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Every heap allocation in the process goes through these
+static atomic<uint64_t> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Peak resident set size in KB (Linux reports ru_maxrss in KB)
+static long peakRssKb() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// Current resident set size in KB, or -1 if /proc is unavailable
+static long currentRssKb() {
+    ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return -1;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 64-bit FNV-1a
+static uint64_t fnv1a(const string& s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Value at percentile p (0..100) of an already sorted sample
+static double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t idx = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[min(idx, sorted.size() - 1)];
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <portfile> <script> [--ticks K] [--history H] [--export FILE] [--substeps N]"
+                " [--proximity NM] [--geodesic] [--obstacles FILE] [--fuel-model NAME] [--profile]"
+                " [--pace MS [--cpu N]] [--verbose]\n";
+        return 1;
+    }
+    long minTicks = 0;
+    long history  = static_cast<long>(DEFAULT_TRACK_DEPTH);
+    bool verbose  = false;
+    bool profile  = false;
+    bool geodesic = false;
+    string exportPath, obstaclePath, fuelModel = "constant";
+    int substeps = 1;
+    double proximity = 0;
+    double paceMs = 0;
+    int cpu = -1;
+    for (int i = 3; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--ticks" && i + 1 < argc) minTicks = stol(argv[++i]);
+        else if (flag == "--history" && i + 1 < argc) history = stol(argv[++i]);
+        else if (flag == "--export" && i + 1 < argc)  exportPath = argv[++i];
+        else if (flag == "--substeps" && i + 1 < argc) substeps = stoi(argv[++i]);
+        else if (flag == "--proximity" && i + 1 < argc) proximity = stod(argv[++i]);
+        else if (flag == "--geodesic")         geodesic = true;
+        else if (flag == "--obstacles" && i + 1 < argc) obstaclePath = argv[++i];
+        else if (flag == "--fuel-model" && i + 1 < argc) fuelModel = argv[++i];
+        else if (flag == "--profile")          profile = true;
+        else if (flag == "--pace" && i + 1 < argc) paceMs = stod(argv[++i]);
+        else if (flag == "--cpu" && i + 1 < argc)  cpu = stoi(argv[++i]);
+        else if (flag == "--verbose")          verbose = true;
+        else { cerr << "Error: unknown option " << flag << "\n"; return 1; }
+    }
+
+    if (history < 0) { cerr << "Error: --history must not be negative\n"; return 1; }
+    if (substeps < 1) { cerr << "Error: --substeps must be at least 1\n"; return 1; }
+    if (proximity < 0) { cerr << "Error: --proximity must not be negative\n"; return 1; }
+    if (proximity > 0 && geodesic) {
+        cerr << "Error: --proximity cannot be combined with --geodesic\n";
+        return 1;
+    }
+    if (paceMs < 0) { cerr << "Error: --pace must not be negative\n"; return 1; }
+    if (cpu >= 0 && paceMs == 0) { cerr << "Error: --cpu needs --pace\n"; return 1; }
+    Model model;
+    model.setSubsteps(substeps);
+    model.setProximityThreshold(proximity);
+    model.setTrackDepth(static_cast<size_t>(history));
+    try {
+        if (geodesic) model.setNavigation(Geodesic);
+        model.setFuelModel(makeFuelModel(fuelModel));
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    try {
+        loadPortFile(model, argv[1]);
+        if (!obstaclePath.empty()) loadObstacleFile(model, obstaclePath);
+    } catch (const runtime_error& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+    try {
+        if (!exportPath.empty()) model.startExport(exportPath);
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    ifstream script(argv[2]);
+    if (!script.is_open()) {
+        cerr << "Error: cannot open script '" << argv[2] << "'\n";
+        return 1;
+    }
+
+    // Silence the simulation's own stdout unless asked for
+    ostringstream sink;
+    streambuf* realOut = cout.rdbuf();
+    if (!verbose) cout.rdbuf(sink.rdbuf());
+
+    Controller controller(model);
+    if (profile) model.startProfiling();
+    TickPacer pacer(chrono::duration_cast<chrono::nanoseconds>(chrono::duration<double, milli>(paceMs)));
+    if (paceMs > 0) {
+        try {
+            prepareRealTime(cpu);
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    vector<double> tickUs;
+    tickUs.reserve(static_cast<size_t>(max(minTicks, 0L)));
+    long rssBefore = -1;
+    size_t encounterCount = 0;
+    shared_ptr<const ModelSnapshot> prevEpoch;
+    uint64_t tickAllocs = 0, afterScriptAllocs = 0;
+    bool afterScript = false;
+
+    auto timedGo = [&]() {
+        if (rssBefore < 0) {
+            rssBefore = currentRssKb();
+            pacer.start();
+        }
+        prevEpoch = model.getSnapshot();
+        if (paceMs > 0) {
+            pacer.sleepUntilDue();
+            pacer.beginTick();
+        }
+        uint64_t allocs0 = allocations.load(memory_order_relaxed);
+        auto t0 = Clock::now();
+        model.go();
+        auto t1 = Clock::now();
+        uint64_t allocs = allocations.load(memory_order_relaxed) - allocs0;
+        if (paceMs > 0) pacer.endTick();
+        tickAllocs += allocs;
+        if (afterScript) afterScriptAllocs += allocs;
+        tickUs.push_back(chrono::duration<double, micro>(t1 - t0).count());
+        encounterCount += model.getEncounters().size();
+        if (!verbose) sink.str(""); // don't let suppressed output accumulate
+    };
+
+    auto wallStart = Clock::now();
+    string line;
+    while (getline(script, line)) {
+        istringstream probe(line);
+        string first;
+        if (!(probe >> first)) continue;
+        if (first == "go") { timedGo(); continue; }
+        if (!controller.parseCommand(line)) break; // "exit"
+        if (!verbose) sink.str("");
+    }
+    size_t scriptTicks = tickUs.size();
+    afterScript = true;
+    while (static_cast<long>(tickUs.size()) < minTicks) timedGo();
+    double wallS = chrono::duration<double>(Clock::now() - wallStart).count();
+    if (!model.stopExport()) cerr << "Error: writing " << exportPath << " failed\n";
+    long rssAfter = currentRssKb();
+
+    // Checksum the final status exactly as a user would see it
+    cout.rdbuf(realOut);
+    ostringstream status;
+    model.printStatus(status);
+
+    vector<double> sorted = tickUs;
+    sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double v : tickUs) total += v;
+
+    cout << fixed << setprecision(1);
+    cout << "objects:        " << model.getAllObjects().size() << "\n";
+    cout << "ticks:          " << tickUs.size() << " (sim time " << model.getTime() << ")\n";
+    cout << "wall time:      " << wallS << " s\n";
+    cout << "tick time (us): mean " << (tickUs.empty() ? 0 : total / tickUs.size())
+         << ", p50 " << percentile(sorted, 50)
+         << ", p90 " << percentile(sorted, 90)
+         << ", p99 " << percentile(sorted, 99)
+         << ", max " << (sorted.empty() ? 0 : sorted.back()) << "\n";
+    cout << "peak RSS:       " << peakRssKb() << " KB\n";
+    cout << "ship bytes:     freighter " << sizeof(Freighter) << ", patrol " << sizeof(Patrol)
+         << ", cruiser " << sizeof(Cruiser) << "\n";
+    if (prevEpoch) {
+        auto last = model.getSnapshot();
+        cout << "COW sharing:    " << last->ships.sharedWith(prevEpoch->ships) << "/"
+             << last->ships.chunkCount() << " ship chunks reused by the last tick\n";
+    }
+    if (proximity > 0)
+        cout << "encounters:     " << encounterCount << " within " << proximity << " nm\n";
+    if (model.getRouter().enabled())
+        cout << "routes:         " << model.getRouter().getCacheMisses() << " computed, "
+             << model.getRouter().getCacheHits() << " from cache\n";
+    const VoyagePlanner& planner = model.getPlanner();
+    if (planner.getMemoHits() + planner.getMemoMisses() > 0)
+        cout << "voyage plans:   " << planner.getMemoMisses() << " searched, "
+             << planner.getMemoHits() << " from memo\n";
+    if (rssBefore >= 0 && rssAfter >= 0)
+        cout << "RSS growth:     " << (rssAfter - rssBefore) << " KB across ticks\n";
+    cout << "allocations:    " << tickAllocs << " in ticks";
+    if (tickUs.size() > scriptTicks)
+        cout << ", " << static_cast<double>(afterScriptAllocs) / (tickUs.size() - scriptTicks)
+             << " per tick after the script";
+    cout << "\n";
+    if (paceMs > 0) pacer.report(cout);
+    if (profile) model.getProfiler()->report(cout);
+    cout << "checksum:       0x" << hex << setw(16) << setfill('0') << fnv1a(status.str()) << dec << "\n";
+    return 0;
+}
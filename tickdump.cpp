@@ -0,0 +1,157 @@
+/*
+ * tickdump.cpp
+ *
+ * Reader for the columnar tick export written by "simNautica --export" (and soak).
+ *
+ * Usage:  tickdump <file> [--csv] [--ship <name>]
+ *
+ * Without --csv prints a summary: ticks and time range, objects seen, and the
+ * encoded size of every column, which shows where the bytes go.
+ * With --csv prints one row per ship per tick:
+ *   time,name,type,x,y,fuel,state,containers,attack
+ * --ship restricts the CSV to one ship.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ColumnCodec.h"
+using namespace std;
+
+namespace {
+
+const char* SHIP_COLUMN_NAMES[SHIP_COLUMNS] = { "name", "x", "y", "fuel", "state", "containers", "attack" };
+const char* PORT_COLUMN_NAMES[PORT_COLUMNS] = { "name", "x", "y", "fuel" };
+const char* KIND_NAMES[] = { "Port", "Freighter", "Patrol_boat", "Cruiser" };
+const char* STATE_NAMES[] = { "Stopped", "Docked", "Dead in the water", "Moving", "Course" };
+
+struct Entry {
+    string     name;
+    ObjectKind kind;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <file> [--csv] [--ship <name>]\n";
+        return 1;
+    }
+    bool csv = false;
+    string onlyShip;
+    for (int i = 2; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--csv")                        csv = true;
+        else if (flag == "--ship" && i + 1 < argc)  onlyShip = argv[++i];
+        else { cerr << "Error: unknown option " << flag << "\n"; return 1; }
+    }
+
+    ifstream in(argv[1], ios::binary);
+    if (!in.is_open()) {
+        cerr << "Error: cannot open '" << argv[1] << "'\n";
+        return 1;
+    }
+    ostringstream whole;
+    whole << in.rdbuf();
+    const string data = whole.str();
+    if (data.size() < COLUMN_MAGIC_SIZE || data.compare(0, COLUMN_MAGIC_SIZE, COLUMN_FILE_MAGIC) != 0) {
+        cerr << "Error: not a tick export file\n";
+        return 1;
+    }
+
+    unordered_map<uint64_t, Entry> dictionary;
+    vector<int64_t> shipPrev[SHIP_COLUMNS], shipCur[SHIP_COLUMNS];
+    vector<int64_t> portPrev[PORT_COLUMNS], portCur[PORT_COLUMNS];
+    uint64_t shipBytes[SHIP_COLUMNS] = {}, portBytes[PORT_COLUMNS] = {};
+    long ticks = 0, firstTime = -1, lastTime = -1;
+    size_t maxShips = 0, maxPorts = 0;
+
+    if (csv) cout << "time,name,type,x,y,fuel,state,containers,attack\n" << fixed << setprecision(3);
+
+    size_t pos = COLUMN_MAGIC_SIZE;
+    while (pos < data.size()) {
+        if (data.size() - pos < 5) { cerr << "Error: truncated frame header\n"; return 1; }
+        uint8_t type = static_cast<uint8_t>(data[pos]);
+        uint32_t len = getU32(data.data() + pos + 1);
+        pos += 5;
+        if (len > data.size() - pos) { cerr << "Error: truncated frame\n"; return 1; }
+        const string payload = data.substr(pos, len);
+        pos += len;
+        size_t p = 0;
+
+        if (type == FRAME_DICTIONARY) {
+            uint64_t n, id, nameLen;
+            if (!getVarint(payload, p, n)) { cerr << "Error: bad dictionary frame\n"; return 1; }
+            for (uint64_t k = 0; k < n; ++k) {
+                if (!getVarint(payload, p, id) || p >= payload.size()) { cerr << "Error: bad dictionary frame\n"; return 1; }
+                ObjectKind kind = static_cast<ObjectKind>(payload[p++]);
+                if (kind > CruiserObject || !getVarint(payload, p, nameLen) || nameLen > payload.size() - p) {
+                    cerr << "Error: bad dictionary frame\n";
+                    return 1;
+                }
+                dictionary[id] = Entry{ payload.substr(p, nameLen), kind };
+                p += nameLen;
+            }
+            continue;
+        }
+        if (type != FRAME_TICK) { cerr << "Error: unknown frame type\n"; return 1; }
+
+        uint64_t time, nShips, nPorts;
+        bool ok = getVarint(payload, p, time) && getVarint(payload, p, nShips) && getVarint(payload, p, nPorts);
+        for (int c = 0; ok && c < SHIP_COLUMNS; ++c) {
+            size_t before = p;
+            ok = getColumn(payload, p, nShips, shipPrev[c], shipCur[c]);
+            shipBytes[c] += p - before;
+        }
+        for (int c = 0; ok && c < PORT_COLUMNS; ++c) {
+            size_t before = p;
+            ok = getColumn(payload, p, nPorts, portPrev[c], portCur[c]);
+            portBytes[c] += p - before;
+        }
+        if (!ok) { cerr << "Error: bad tick frame\n"; return 1; }
+
+        ++ticks;
+        if (firstTime < 0) firstTime = static_cast<long>(time);
+        lastTime = static_cast<long>(time);
+        if (nShips > maxShips) maxShips = nShips;
+        if (nPorts > maxPorts) maxPorts = nPorts;
+
+        if (csv) {
+            for (size_t i = 0; i < nShips; ++i) {
+                const Entry& e = dictionary[static_cast<uint64_t>(shipCur[ShipName][i])];
+                if (!onlyShip.empty() && e.name != onlyShip) continue;
+                int64_t state = shipCur[ShipState][i];
+                cout << time << ',' << e.name << ',' << KIND_NAMES[e.kind] << ','
+                     << fromFixed(shipCur[ShipX][i]) << ',' << fromFixed(shipCur[ShipY][i]) << ','
+                     << fromFixed(shipCur[ShipFuel][i]) << ','
+                     << (state >= 0 && state <= 4 ? STATE_NAMES[state] : "?") << ','
+                     << shipCur[ShipContainers][i] << ',' << shipCur[ShipAttack][i] << '\n';
+            }
+        }
+        for (int c = 0; c < SHIP_COLUMNS; ++c) shipPrev[c].swap(shipCur[c]);
+        for (int c = 0; c < PORT_COLUMNS; ++c) portPrev[c].swap(portCur[c]);
+    }
+
+    if (csv) return 0;
+
+    cout << "file:       " << argv[1] << " (" << data.size() << " bytes)\n";
+    cout << "ticks:      " << ticks;
+    if (ticks > 0) cout << " (time " << firstTime << ".." << lastTime << ")";
+    cout << "\n";
+    cout << "objects:    " << dictionary.size() << " named, up to " << maxShips << " ships and "
+         << maxPorts << " ports per tick\n";
+    if (ticks > 0)
+        cout << "per tick:   " << fixed << setprecision(1)
+             << static_cast<double>(data.size() - COLUMN_MAGIC_SIZE) / ticks << " bytes\n";
+    cout << "columns (encoded bytes):\n";
+    for (int c = 0; c < SHIP_COLUMNS; ++c)
+        cout << "  ship." << left << setw(11) << SHIP_COLUMN_NAMES[c] << right << shipBytes[c] << "\n";
+    for (int c = 0; c < PORT_COLUMNS; ++c)
+        cout << "  port." << left << setw(11) << PORT_COLUMN_NAMES[c] << right << portBytes[c] << "\n";
+    return 0;
+}